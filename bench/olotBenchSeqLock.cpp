@@ -0,0 +1,225 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * Contention benchmark comparing a mutex against olotSeqLockValue.
+ * 
+ * One writer thread publishes values the size of an OCS snapshot while reader threads
+ * copy them as fast as possible. Reports reads per second, read latency percentiles and
+ * write latency for both synchronization methods.
+ * 
+ * Build with "scons bench". Run:
+ *   bench/olotBenchSeqLock [readers] [seconds] [writeIntervalMicroseconds]
+ * 
+ * Defaults are one reader per remaining CPU, 2 seconds and a write interval of 1000us.
+ * A write interval of 0 writes as fast as possible.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "utils/olotClock.h"
+#include "utils/olotSeqLock.h"
+
+
+// Definitions
+////////////////
+
+// same size as the published OCS values
+struct sValues{
+	uint32_t version;
+	int64_t time;
+	float values[ 50 ];
+};
+
+// latencies are sampled every few reads to keep the clock reads out of the throughput
+static const int vSampleInterval = 64;
+
+struct sResult{
+	uint64_t reads;
+	uint64_t writes;
+	std::vector<int64_t> readLatencies;
+	std::vector<int64_t> writeLatencies;
+};
+
+// mutex protected values
+class cMutexValues{
+private:
+	std::mutex pMutex;
+	sValues pValues;
+	
+public:
+	cMutexValues() : pValues{}{
+	}
+	
+	void Store( const sValues &values ){
+		const std::lock_guard<std::mutex> guard( pMutex );
+		pValues = values;
+	}
+	
+	void Load( sValues &values ){
+		const std::lock_guard<std::mutex> guard( pMutex );
+		values = pValues;
+	}
+};
+
+// sequence lock protected values
+class cSeqLockValues{
+private:
+	olotSeqLockValue<sValues> pValues;
+	
+public:
+	void Store( const sValues &values ){
+		pValues.Store( values );
+	}
+	
+	void Load( sValues &values ){
+		pValues.Load( values );
+	}
+};
+
+static int64_t percentile( std::vector<int64_t> &samples, double fraction ){
+	if( samples.empty() ){
+		return 0;
+	}
+	const size_t index = std::min( ( size_t )( fraction * ( double )samples.size() ), samples.size() - 1 );
+	std::nth_element( samples.begin(), samples.begin() + index, samples.end() );
+	return samples[ index ];
+}
+
+template<class Values> static sResult run( int readerCount, int seconds, int writeInterval ){
+	Values shared;
+	std::atomic<bool> running( true );
+	std::vector<sResult> readerResults( readerCount );
+	sResult result = {};
+	
+	std::vector<std::thread> readers;
+	int i;
+	
+	for( i=0; i<readerCount; i++ ){
+		readers.emplace_back( [ &shared, &running, &readerResults, i ](){
+			sResult &reader = readerResults[ i ];
+			sValues values;
+			uint64_t checksum = 0;
+			
+			while( running.load( std::memory_order_relaxed ) ){
+				if( reader.reads % vSampleInterval == 0 ){
+					const int64_t start = olotClock::Now();
+					shared.Load( values );
+					reader.readLatencies.push_back( olotClock::Now() - start );
+					
+				}else{
+					shared.Load( values );
+				}
+				
+				checksum += values.version;
+				reader.reads++;
+			}
+			
+			// keeps the loads from being optimized away
+			if( checksum == 1 ){
+				printf( " " );
+			}
+		} );
+	}
+	
+	// the writer runs on the calling thread
+	const int64_t end = olotClock::Now() + ( int64_t )seconds * 1000000000LL;
+	sValues values = {};
+	
+	while( true ){
+		const int64_t now = olotClock::Now();
+		if( now >= end ){
+			break;
+		}
+		
+		values.version++;
+		values.time = now;
+		for( i=0; i<50; i++ ){
+			values.values[ i ] = ( float )( values.version % 100 ) * 0.01f;
+		}
+		
+		shared.Store( values );
+		result.writeLatencies.push_back( olotClock::Now() - now );
+		result.writes++;
+		
+		if( writeInterval > 0 ){
+			std::this_thread::sleep_for( std::chrono::microseconds( writeInterval ) );
+		}
+	}
+	
+	running.store( false, std::memory_order_relaxed );
+	for( std::thread &reader : readers ){
+		reader.join();
+	}
+	
+	for( const sResult &reader : readerResults ){
+		result.reads += reader.reads;
+		result.readLatencies.insert( result.readLatencies.end(),
+			reader.readLatencies.cbegin(), reader.readLatencies.cend() );
+	}
+	return result;
+}
+
+static void print( const char *name, sResult &result, int seconds ){
+	printf( "%-8s reads %10.0f/s  read p50 %5lldns p99 %6lldns max %8lldns  "
+		"writes %8.0f/s  write p50 %5lldns p99 %6lldns max %8lldns\n",
+		name, ( double )result.reads / seconds,
+		( long long )percentile( result.readLatencies, 0.5 ),
+		( long long )percentile( result.readLatencies, 0.99 ),
+		( long long )percentile( result.readLatencies, 1.0 ),
+		( double )result.writes / seconds,
+		( long long )percentile( result.writeLatencies, 0.5 ),
+		( long long )percentile( result.writeLatencies, 0.99 ),
+		( long long )percentile( result.writeLatencies, 1.0 ) );
+}
+
+int main( int argc, char **argv ){
+	const int cpus = ( int )std::thread::hardware_concurrency();
+	const int readerCount = argc > 1 ? atoi( argv[ 1 ] ) : std::max( cpus - 1, 1 );
+	const int seconds = argc > 2 ? atoi( argv[ 2 ] ) : 2;
+	const int writeInterval = argc > 3 ? atoi( argv[ 3 ] ) : 1000;
+	
+	if( readerCount < 1 || seconds < 1 || writeInterval < 0 ){
+		fprintf( stderr, "Usage: %s [readers] [seconds] [writeIntervalMicroseconds]\n", argv[ 0 ] );
+		return 1;
+	}
+	
+	printf( "%d readers, %d seconds, write interval %dus, %d cpus\n",
+		readerCount, seconds, writeInterval, cpus );
+	
+	sResult resultMutex = run<cMutexValues>( readerCount, seconds, writeInterval );
+	print( "mutex", resultMutex, seconds );
+	
+	sResult resultSeqLock = run<cSeqLockValues>( readerCount, seconds, writeInterval );
+	print( "seqlock", resultSeqLock, seconds );
+	return 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+/*
+ * Sample producer writing frames to the shared memory ring read by the layer.
+ * 
+ * Build:
+ *   cc -O2 -I../src -o olot_shm_producer olot_shm_producer.c -lrt -lm
+ * 
+ * Run:
+ *   ./olot_shm_producer [name] [rate]
+ * 
+ * Start the application with OCSEYEFACETRACKING_SHM_NAME set to the same name. Default name
+ * is OLOT_SHM_DEFAULT_NAME and default rate is 120 frames per second. Opens the jaw and
+ * moves the eyes left and right.
+ */
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+
+#include "olot_shm.h"
+
+static volatile sig_atomic_t running = 1;
+
+static void onSignal( int number ){
+	(void)number;
+	running = 0;
+}
+
+static int64_t now( void ){
+	struct timespec time;
+	clock_gettime( CLOCK_MONOTONIC, &time );
+	return ( int64_t )time.tv_sec * 1000000000 + time.tv_nsec;
+}
+
+int main( int argc, char **argv ){
+	const char * const name = argc > 1 ? argv[ 1 ] : OLOT_SHM_DEFAULT_NAME;
+	const int rate = argc > 2 ? atoi( argv[ 2 ] ) : 120;
+	if( rate < 1 ){
+		fprintf( stderr, "Invalid rate\n" );
+		return 1;
+	}
+	
+	/* the object is reused if it exists. unlinking it would disconnect the layer */
+	const int fd = shm_open( name, O_CREAT | O_RDWR | O_CLOEXEC, 0600 );
+	if( fd == -1 ){
+		perror( "shm_open" );
+		return 1;
+	}
+	
+	if( ftruncate( fd, sizeof( olot_shm_ring ) ) == -1 ){
+		perror( "ftruncate" );
+		close( fd );
+		return 1;
+	}
+	
+	olot_shm_ring * const ring = ( olot_shm_ring* )mmap( NULL, sizeof( olot_shm_ring ),
+		PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	close( fd );
+	
+	if( ring == MAP_FAILED ){
+		perror( "mmap" );
+		return 1;
+	}
+	
+	if( ! olot_shm_valid( ring ) ){
+		olot_shm_init( ring );
+	}
+	
+	signal( SIGINT, onSignal );
+	signal( SIGTERM, onSignal );
+	
+	printf( "Writing %d frames per second to %s\n", rate, name );
+	
+	const int64_t period = 1000000000 / rate;
+	const int64_t start = now();
+	int64_t next = start;
+	olot_shm_frame frame = { 0 };
+	
+	frame.expression_mask = ( uint64_t )1 << OLOT_SHM_JAW_OPEN;
+	frame.eye_state_mask = ( 1u << OLOT_SHM_LEFT_EYE_X ) | ( 1u << OLOT_SHM_RIGHT_EYE_X )
+		| ( 1u << OLOT_SHM_EYES_Y );
+	
+	while( running ){
+		frame.time = now();
+		
+		const double seconds = ( double )( frame.time - start ) * 1e-9;
+		frame.expressions[ OLOT_SHM_JAW_OPEN ] = ( float )( 0.5 + 0.5 * sin( seconds * 2.0 ) );
+		frame.eye_states[ OLOT_SHM_LEFT_EYE_X ] = ( float )sin( seconds );
+		frame.eye_states[ OLOT_SHM_RIGHT_EYE_X ] = frame.eye_states[ OLOT_SHM_LEFT_EYE_X ];
+		frame.eye_states[ OLOT_SHM_EYES_Y ] = 0.0f;
+		
+		olot_shm_write( ring, &frame );
+		
+		next += period;
+		const struct timespec wakeup = { ( time_t )( next / 1000000000 ), ( long )( next % 1000000000 ) };
+		clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeup, NULL );
+	}
+	
+	munmap( ring, sizeof( olot_shm_ring ) );
+	return 0;
+}
@@ -74,9 +74,11 @@ pName( ! name.empty() ? name : std::string( STR_NULL ) ),
 pDescription( ! description.empty() ? description : std::string( STR_NULL ) ),
 pFile( ! file.empty() ? file : std::string( STR_NULL ) ),
 pLine( std::max( line, 0 ) ),
-pResult( result )
+pResult( result ),
+pFramePointerCount( 0 ),
+pBacktraceResolved( false )
 {
-	pBuildBacktrace();
+	pCaptureBacktrace();
 }
 
 olotException::~olotException(){
@@ -90,6 +92,14 @@ bool olotException::IsNamed( const std::string &name ) const{
 	return pName == name;
 }
 
+const std::vector<std::string> &olotException::GetBacktrace() const{
+	if( ! pBacktraceResolved ){
+		pResolveBacktrace();
+		pBacktraceResolved = true;
+	}
+	return pBacktrace;
+}
+
 
 
 // Display
@@ -109,7 +119,8 @@ std::vector<std::string> olotException::FormatOutput() const{
 	output.push_back( string_format( "Result: %d", pResult ) );
 	
 	std::vector<std::string>::const_iterator iter;
-	for( iter = pBacktrace.cbegin(); iter != pBacktrace.cend(); iter++ ){
+	const std::vector<std::string> &backtrace = GetBacktrace();
+	for( iter = backtrace.cbegin(); iter != backtrace.cend(); iter++ ){
 		output.push_back( string_format( "Backtrace: %s", iter->c_str() ) );
 	}
 	
@@ -132,9 +143,6 @@ void olotException::PrintError( std::ostream &stream ) const{
 // Private Functions
 //////////////////////
 
-// we want this many entries at max
-#define MAX_BACKTRACE_COUNT		25
-
 // this many first entries are related to exception handling. skip them
 #define SKIP_SELF_TRACE_COUNT	3
 
@@ -160,19 +168,51 @@ static _Unwind_Reason_Code unwindCallback( struct _Unwind_Context *context, void
 }
 #endif
 
-void olotException::pBuildBacktrace(){
-#if defined OS_UNIX && ! defined ANDROID && ! defined OS_BEOS
-	const int maxFramepointerCount = MAX_BACKTRACE_COUNT + SKIP_SELF_TRACE_COUNT;
+// capturing has to stay cheap since exceptions can be thrown repeatedly. only raw frame
+// pointers are stored. resolving symbols is done by pResolveBacktrace once needed
+void olotException::pCaptureBacktrace(){
+	const int maxFramepointerCount = MaxBacktraceCount + SKIP_SELF_TRACE_COUNT;
 	void *framepointers[ maxFramepointerCount ];
-	const int fpcount = backtrace( framepointers, maxFramepointerCount );
-	if( fpcount == 0 ){
+	int fpcount = 0;
+	
+#if defined OS_UNIX && ! defined ANDROID && ! defined OS_BEOS
+	fpcount = backtrace( framepointers, maxFramepointerCount );
+#endif
+	
+#ifdef ANDROID
+	// NOTE unwindCallback can segfault for strange reasons. The void* pointers are not
+	//      const on purpose. Using them const can result in segfault due to compiler
+	//      trying to optimize the wrong way
+	sBacktraceState state;
+	state.current = &framepointers[ 0 ];
+	state.end = &framepointers[ 0 ] + maxFramepointerCount;
+	_Unwind_Backtrace( unwindCallback, &state );
+	fpcount = ( int )( state.current - &framepointers[ 0 ] );
+#endif
+	
+#ifdef OS_W32
+	fpcount = ( int )RtlCaptureStackBackTrace( 0, maxFramepointerCount, framepointers, NULL );
+#endif
+	
+	int i;
+	for( i=SKIP_SELF_TRACE_COUNT; i<fpcount; i++ ){
+		pFramePointers[ pFramePointerCount++ ] = framepointers[ i ];
+	}
+}
+
+void olotException::pResolveBacktrace() const{
+	if( pFramePointerCount == 0 ){
 		return;
 	}
 	
-	char ** const symbols = backtrace_symbols( framepointers, fpcount );
-	int i;
+#if defined OS_UNIX && ! defined ANDROID && ! defined OS_BEOS
+	char ** const symbols = backtrace_symbols( pFramePointers, pFramePointerCount );
+	if( ! symbols ){
+		return;
+	}
 	
-	for( i=SKIP_SELF_TRACE_COUNT; i<fpcount; i++ ){
+	int i;
+	for( i=0; i<pFramePointerCount; i++ ){
 		pBacktrace.push_back( std::string( symbols[ i ] ) );
 	}
 	
@@ -180,51 +220,35 @@ void olotException::pBuildBacktrace(){
 #endif
 	
 #ifdef ANDROID
-	// NOTE unwindCallback can segfault for strange reasons. The void* pointers are not
-	//      const on purpose. Using them const can result in segfault due to compiler
-	//      trying to optimize the wrong way
-	// 
 	// NOTE -fvisibility=hidden prevent demangling from working
+	int i;
 	
-	void *context[ MAX_BACKTRACE_COUNT ];
-	void ** const stateBegin = &context[ 0 ];
-	sBacktraceState state;
-	state.current = stateBegin;
-	state.end = stateBegin + MAX_BACKTRACE_COUNT;
-	_Unwind_Backtrace( unwindCallback, &state );
-	const size_t count = ( size_t )( state.current - stateBegin );
-	std::string symbol;
-	size_t i;
-	
-	for( i=SKIP_SELF_TRACE_COUNT; i<count; i++ ){
-		const void * const addr = context[ i ];
+	for( i=0; i<pFramePointerCount; i++ ){
+		const void * const addr = pFramePointers[ i ];
 		
 		Dl_info info;
 		if( dladdr( addr, &info ) && info.dli_sname ){
 			int status = 0;
-			char * const demangled = abi::__cxa_demangle( symbol, 0, 0, &status );
+			char * const demangled = abi::__cxa_demangle( info.dli_sname, 0, 0, &status );
 			if( demangled ){
-				symbol.Format( "%s(%s+0x%x) [%p] %s", info.dli_fname, info.dli_sname,
-					( const char* )addr - ( const char* )info.dli_saddr, addr, demangled );
+				pBacktrace.push_back( string_format( "%s(%s+0x%x) [%p] %s", info.dli_fname, info.dli_sname,
+					( unsigned int )( ( const char* )addr - ( const char* )info.dli_saddr ), addr, demangled ) );
 				free( demangled );
 				
 			}else{
-				symbol.Format( "%s(%s+0x%x) [%p]", info.dli_fname, info.dli_sname,
-					( const char* )addr - ( const char* )info.dli_saddr, addr );
+				pBacktrace.push_back( string_format( "%s(%s+0x%x) [%p]", info.dli_fname, info.dli_sname,
+					( unsigned int )( ( const char* )addr - ( const char* )info.dli_saddr ), addr ) );
 			}
 			
 		}else{
-			symbol.Format( "%p ??", addr );
+			pBacktrace.push_back( string_format( "%p ??", addr ) );
 		}
-		
-		pBacktrace.Add( symbol );
 	}
 #endif
 
 #ifdef OS_W32
 #ifdef WITH_DBGHELP
 	const HANDLE process = GetCurrentProcess();
-	const HANDLE thread = GetCurrentThread();
 	
 	DWORD symOptions = SYMOPT_LOAD_LINES | SYMOPT_CASE_INSENSITIVE;
 	symOptions |= SYMOPT_DEBUG | SYMOPT_DEFERRED_LOADS | SYMOPT_UNDNAME;
@@ -237,88 +261,38 @@ void olotException::pBuildBacktrace(){
 		return;
 	}
 	
-	CONTEXT context;
-	memset( &context, 0, sizeof( CONTEXT ) );
-	context.ContextFlags = CONTEXT_FULL;
-	RtlCaptureContext( &context );
-	
-	const int symbolBufferLen = sizeof( IMAGEHLP_SYMBOL64 ) + MAX_SYM_NAME;
-	char * const symbolBuffer = new char[ symbolBufferLen + 1 ];
-	memset( symbolBuffer, 0, symbolBufferLen + 1 );
-	PIMAGEHLP_SYMBOL64 const symbol = ( PIMAGEHLP_SYMBOL64 )symbolBuffer;
-	symbol->SizeOfStruct = sizeof( IMAGEHLP_SYMBOL64 );
-	symbol->MaxNameLength = MAX_SYM_NAME;
-
-	STACKFRAME_EX stack;
-	memset( &stack, 0, sizeof( stack ) );
-	DWORD machineType;
-
-	#ifdef _WIN64
-		machineType = IMAGE_FILE_MACHINE_IA64;
-		stack.AddrPC.Offset = context.Rip;
-		stack.AddrPC.Mode = AddrModeFlat;
-		stack.AddrStack.Offset = context.Rsp;
-		stack.AddrStack.Mode = AddrModeFlat;
-		stack.AddrFrame.Offset = context.Rbp;
-		stack.AddrFrame.Mode = AddrModeFlat;
-	#else
-		machineType = IMAGE_FILE_MACHINE_I386;
-		stack.AddrPC.Offset = context.Eip;
-		stack.AddrPC.Mode = AddrModeFlat;
-		stack.AddrStack.Offset = context.Esp;
-		stack.AddrStack.Mode = AddrModeFlat;
-		stack.AddrFrame.Offset = context.Ebp;
-		stack.AddrFrame.Mode = AddrModeFlat;
-	#endif
-	
-	BOOL result;
 	char undecoratedName[ 256 ];
-
-	IMAGEHLP_MODULE64 moduleInfo;
-	memset( &moduleInfo, 0, sizeof( moduleInfo ) );
-	moduleInfo.SizeOfStruct = sizeof( IMAGEHLP_MODULE64 );
-
+	
 	char symbolInfoBuffer[ sizeof( SYMBOL_INFO ) + MAX_SYM_NAME * sizeof( TCHAR ) ];
 	memset( &symbolInfoBuffer, 0, sizeof( symbolInfoBuffer ) );
 	PSYMBOL_INFO symbolInfo = ( PSYMBOL_INFO )&symbolInfoBuffer;
 	symbolInfo->SizeOfStruct = sizeof( SYMBOL_INFO );
 	symbolInfo->MaxNameLen = MAX_SYM_NAME;
-
+	
 	int i;
-	std::string desymbol;
-
-	for( i=0; i<50; i++ ){
-		result = StackWalkEx( machineType, process, thread, &stack, &context, NULL,
-			SymFunctionTableAccess64, SymGetModuleBase64, NULL, 0 );
-		if( ! result || ! stack.AddrPC.Offset ){
-			break;
-		}
-
-		symbol->SizeOfStruct = sizeof( IMAGEHLP_SYMBOL64 );
-		symbol->MaxNameLength = 255;
-
+	
+	for( i=0; i<pFramePointerCount; i++ ){
+		const DWORD64 address = ( DWORD64 )pFramePointers[ i ];
 		DWORD64 offsetSymbol = 0;
 		DWORD offsetLine = 0;
-		IMAGEHLP_LINE64 symbolLine = ( IMAGEHLP_LINE64 )0;
-
-		const void *address = 0;
-		const std::string &name = "??";
-		const std::string &sourceFile = "??";
+		IMAGEHLP_LINE64 symbolLine;
+		memset( &symbolLine, 0, sizeof( symbolLine ) );
+		symbolLine.SizeOfStruct = sizeof( IMAGEHLP_LINE64 );
+		
+		const char *name = "??";
+		const char *sourceFile = "??";
 		int sourceLine = 0;
-
-		if( SymFromAddr( process, stack.AddrPC.Offset, &offsetSymbol, symbolInfo ) ){
-			address = ( void* )symbolInfo->Address;
-			
+		
+		if( SymFromAddr( process, address, &offsetSymbol, symbolInfo ) ){
 			UnDecorateSymbolName( symbolInfo->Name, ( PSTR )undecoratedName, sizeof( undecoratedName ), UNDNAME_COMPLETE );
 			name = undecoratedName;
 		}
-		if( SymGetLineFromAddr64( process, stack.AddrPC.Offset, &offsetLine, &symbolLine ) ){
+		if( SymGetLineFromAddr64( process, address, &offsetLine, &symbolLine ) ){
 			sourceLine = ( int )symbolLine.LineNumber;
 			sourceFile = symbolLine.FileName;
 		}
 		
-		desymbol.Format( "%s [%p] %s:%d", name, address, sourceFile, sourceLine );
-		pBacktrace.Add( desymbol );
+		pBacktrace.push_back( string_format( "%s [%p] %s:%d", name, pFramePointers[ i ], sourceFile, sourceLine ) );
 	}
 	
 	SymCleanup( process );
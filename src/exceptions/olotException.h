@@ -34,13 +34,22 @@
 
 /** Exception class. */
 class olotException{
+public:
+	/** Maximum number of backtrace frames captured. */
+	const static int MaxBacktraceCount = 25;
+	
+	
+	
 private:
 	std::string pName;
 	std::string pDescription;
 	std::string pFile;
 	int pLine;
 	XrResult pResult;
-	std::vector<std::string> pBacktrace;
+	void *pFramePointers[ MaxBacktraceCount ];
+	int pFramePointerCount;
+	mutable std::vector<std::string> pBacktrace;
+	mutable bool pBacktraceResolved;
 	
 	
 	
@@ -74,8 +83,19 @@ public:
 	/** Result. */
 	inline XrResult GetResult() const{ return pResult; }
 	
-	/** Backtrace. */
-	inline const std::vector<std::string> &GetBacktrace() const{ return pBacktrace; }
+	/** Number of captured backtrace frames. */
+	inline int GetFramePointerCount() const{ return pFramePointerCount; }
+	
+	/** Captured backtrace frame at index. */
+	inline void *GetFramePointerAt( int index ) const{ return pFramePointers[ index ]; }
+	
+	/**
+	 * Backtrace.
+	 * 
+	 * Only raw frame pointers are captured while throwing. Symbols are resolved the
+	 * first time the backtrace is requested.
+	 */
+	const std::vector<std::string> &GetBacktrace() const;
 	/*@}*/
 	
 	
@@ -121,8 +141,11 @@ public:
 	
 	
 private:
-	/** Build backtrace. */
-	void pBuildBacktrace();
+	/** Capture raw frame pointers. */
+	void pCaptureBacktrace();
+	
+	/** Resolve symbols of captured frame pointers. */
+	void pResolveBacktrace() const;
 };
 
 #endif
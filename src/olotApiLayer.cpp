@@ -22,12 +22,11 @@
  * SOFTWARE.
  */
 
+#include <algorithm>
 #include <stdlib.h>
-#include <fstream>
 #include <string.h>
 #include <filesystem>
-#include <chrono>
-#include <ctime>
+#include <vector>
 
 #include "olotApiLayer.h"
 #include "olotOcsClient.h"
@@ -35,6 +34,37 @@
 
 
 
+// runtime or a later layer supports instance extension
+static bool nextSupportsExtension( PFN_xrGetInstanceProcAddr nextGetInstanceProcAddr, const char *name ){
+	PFN_xrEnumerateInstanceExtensionProperties enumerate = nullptr;
+	if( XR_FAILED( nextGetInstanceProcAddr( XR_NULL_HANDLE, "xrEnumerateInstanceExtensionProperties",
+			( PFN_xrVoidFunction* )&enumerate ) ) || ! enumerate ){
+		return false;
+	}
+	
+	uint32_t count = 0;
+	if( XR_FAILED( enumerate( nullptr, 0, &count, nullptr ) ) ){
+		return false;
+	}
+	
+	std::vector<XrExtensionProperties> properties( count );
+	uint32_t i;
+	for( i=0; i<count; i++ ){
+		properties[ i ].type = XR_TYPE_EXTENSION_PROPERTIES;
+	}
+	
+	if( XR_FAILED( enumerate( nullptr, count, &count, properties.data() ) ) ){
+		return false;
+	}
+	
+	for( i=0; i<count; i++ ){
+		if( strcmp( properties[ i ].extensionName, name ) == 0 ){
+			return true;
+		}
+	}
+	return false;
+}
+
 // xrCreateInstance is a special case that we can't hook. We get this amended call instead.
 static XrResult XRAPI_PTR fxrCreateApiLayerInstance( const XrInstanceCreateInfo *info,
 const XrApiLayerCreateInfo *apiLayerInfo, XrInstance *instance ){
@@ -42,28 +72,48 @@ const XrApiLayerCreateInfo *apiLayerInfo, XrInstance *instance ){
 	const char ** enabledExtensionNames = nullptr;
 	
 	try{
-		{
-		const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-		olotApiLayer::Get().log() << "Created api layer instance for app "
-			<< info->applicationInfo.applicationName << std::endl;
+		OLOTLOG_INFO( olotApiLayer::Get().log(), "Created api layer instance for app "
+			<< info->applicationInfo.applicationName );
+		
+		// this layer adds the eye gaze, HTC facial tracking and FB face tracking extensions
+		// which the VR runtime probably does not know about. if we let nextCreateApiLayerInstance
+		// see these extensions it can likely fail us due to know nothing them. the workaround
+		// here is to create a modified extension list with the extensions provided by this
+		// layer filtered out
+		//
+		// packet receive times are converted to XrTime using XR_KHR_convert_timespec_time.
+		// enable it if not enabled by the application and supported by the runtime
+		bool addConvertTimespec = true;
+		
+		enabledExtensionNames = new const char*[ info->enabledExtensionCount + 1 ];
+		
+		for( i=0; i<info->enabledExtensionCount; i++ ){
+			if( strcmp( info->enabledExtensionNames[ i ], XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME ) == 0 ){
+				addConvertTimespec = false;
+				break;
+			}
 		}
 		
-		// this layer adds two new extensions which the VR runtime probably does not know
-		// about. if we let nextCreateApiLayerInstance see these extensions it can likely
-		// fail us due to know nothing them. the workaround here is to create a modified
-		// extension list with the extensions provided by this layer filtered out
-		if( info->enabledExtensionCount > 0 ){
-			enabledExtensionNames = new const char*[ info->enabledExtensionCount ];
-			
-			for( i=0; i<info->enabledExtensionCount; i++ ){
-				if( strcmp( info->enabledExtensionNames[ i ], XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME ) == 0 ){
-					continue;
-				}
-				if( strcmp( info->enabledExtensionNames[ i ], XR_HTC_FACIAL_TRACKING_EXTENSION_NAME ) == 0 ){
-					continue;
-				}
-				enabledExtensionNames[ enabledExtensionCount++ ] = info->enabledExtensionNames[ i ];
+		if( addConvertTimespec ){
+			addConvertTimespec = nextSupportsExtension(
+				apiLayerInfo->nextInfo->nextGetInstanceProcAddr, XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME );
+		}
+		
+		for( i=0; i<info->enabledExtensionCount; i++ ){
+			if( strcmp( info->enabledExtensionNames[ i ], XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME ) == 0 ){
+				continue;
+			}
+			if( strcmp( info->enabledExtensionNames[ i ], XR_HTC_FACIAL_TRACKING_EXTENSION_NAME ) == 0 ){
+				continue;
 			}
+			if( strcmp( info->enabledExtensionNames[ i ], XR_FB_FACE_TRACKING_EXTENSION_NAME ) == 0 ){
+				continue;
+			}
+			enabledExtensionNames[ enabledExtensionCount++ ] = info->enabledExtensionNames[ i ];
+		}
+		
+		if( addConvertTimespec ){
+			enabledExtensionNames[ enabledExtensionCount++ ] = XR_KHR_CONVERT_TIMESPEC_TIME_EXTENSION_NAME;
 		}
 		
 		XrInstanceCreateInfo subinfo = {
@@ -95,11 +145,8 @@ const XrApiLayerCreateInfo *apiLayerInfo, XrInstance *instance ){
 			delete [] enabledExtensionNames;
 		}
 		
-		{
-		const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-		olotApiLayer::Get().log() << "Failed to create api layer instance:" << std::endl;
+		OLOTLOG_ERROR( olotApiLayer::Get().log(), "Failed to create api layer instance:" );
 		e.PrintError( olotApiLayer::Get().baseLogStream() );
-		}
 		return e.GetResult();
 	}
 }
@@ -123,9 +170,13 @@ XrInstance instance, const char *name, PFN_xrVoidFunction *function ){
 static olotApiLayer vApiLayer;
 
 olotApiLayer::olotApiLayer() :
+pLogWriter( *new olotLogWriter( /*dirLogDragonDreams /*/ "XrApiLayer_ocseyefacetracking.log" ) ),
 pLayerName( "ocseyefacetracking" ),
 pSupportsEyeGazeTracking( true ),
-pSupportsFacialTracking( true )
+pSupportsFacialTracking( true ),
+pFastLocateSpace( nullptr ),
+pGazeSpaceCount( 0 ),
+pGazeSpaceOverflow( false )
 {
 	/*
 	char buffer[ MAX_PATH ];
@@ -139,14 +190,20 @@ pSupportsFacialTracking( true )
 	std::filesystem::create_directory( dirLogDragonDreams );
 	*/
 	
-	pLogFile.rdbuf()->pubsetbuf( nullptr, 0 );
-	pLogFile.open( /*dirLogDragonDreams /*/ "XrApiLayer_ocseyefacetracking.log",
-		std::ofstream::out | std::ofstream::trunc );
+	pConfig.LoadFromEnvironment();
+	olotLog::SetLevel( pConfig.GetLogLevel() );
+	pConfig.LogConfig();
+	
+	// crash handlers are opt-in since managed runtimes use these signals for control flow
+	if( pConfig.GetLogFlushOnCrash() ){
+		pLogWriter.InstallCrashHandler();
+	}
 }
 
 olotApiLayer::~olotApiLayer(){
-	pLogFile.flush();
-	pLogFile.close();
+	// the log writer is never destroyed. thread local log streams of threads still running
+	// keep referencing it. stopping writes pending records
+	pLogWriter.Stop();
 }
 
 
@@ -164,30 +221,25 @@ XrResult olotApiLayer::Negotiate( const XrNegotiateLoaderInfo *loaderInfo,
 const char *layerName, XrNegotiateApiLayerRequest *apiLayerRequest ){
 	pLayerName = layerName;
 	
-	{
-	std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-	log() << "Using API layer: " << layerName << std::endl;
+	OLOTLOG_INFO( log(), "Using API layer: " << layerName );
 	
-	log() << "loader API version min: "
+	OLOTLOG_DEBUG( log(), "loader API version min: "
 		<< XR_VERSION_MAJOR( loaderInfo->minApiVersion ) << "."
 		<< XR_VERSION_MINOR( loaderInfo->minApiVersion ) << "."
 		<< XR_VERSION_PATCH( loaderInfo->minApiVersion ) << "."
 		<< " max: "
 		<< XR_VERSION_MAJOR( loaderInfo->maxApiVersion ) << "."
 		<< XR_VERSION_MINOR( loaderInfo->maxApiVersion ) << "."
-		<< XR_VERSION_PATCH( loaderInfo->maxApiVersion ) << "."
-		<< std::endl;
+		<< XR_VERSION_PATCH( loaderInfo->maxApiVersion ) << "." );
 	
-	log() << "loader interface version min: "
+	OLOTLOG_DEBUG( log(), "loader interface version min: "
 		<< XR_VERSION_MAJOR( loaderInfo->minInterfaceVersion ) << "."
 		<< XR_VERSION_MINOR( loaderInfo->minInterfaceVersion ) << "."
 		<< XR_VERSION_PATCH( loaderInfo->minInterfaceVersion ) << "."
 		<< " max: "
 		<< XR_VERSION_MAJOR( loaderInfo->maxInterfaceVersion ) << "."
 		<< XR_VERSION_MINOR( loaderInfo->maxInterfaceVersion ) << "."
-		<< XR_VERSION_PATCH( loaderInfo->maxInterfaceVersion ) << "."
-		<< std::endl;
-	}
+		<< XR_VERSION_PATCH( loaderInfo->maxInterfaceVersion ) << "." );
 	
 	// TODO: proper version check
 	// On error return XR_ERROR_INITIALIZATION_FAILED
@@ -202,24 +254,83 @@ const char *layerName, XrNegotiateApiLayerRequest *apiLayerRequest ){
 
 
 bool olotApiLayer::HasInstance( XrInstance instance ) const{
-	return pInstances.find( instance ) != pInstances.cend();
+	return pInstances.Has( instance );
 }
 
 olotInstance::Ref olotApiLayer::GetInstance( XrInstance instance ) const{
-	MapInstances::const_iterator iter( pInstances.find( instance ) );
-	OLOTASSERT_FALSE( iter == pInstances.cend(), XR_ERROR_HANDLE_INVALID )
-	return iter->second;
+	olotInstance::Ref ref;
+	OLOTASSERT_TRUE( pInstances.Get( instance, ref ), XR_ERROR_HANDLE_INVALID )
+	return ref;
 }
 
 void olotApiLayer::AddInstance( const olotInstance::Ref &instance ){
 	OLOTASSERT_NOTNULL( instance, XR_ERROR_HANDLE_INVALID )
-	pInstances[ instance->GetInstance() ] = instance;
+	pInstances.Set( instance->GetInstance(), instance );
+	pUpdateFastLocateSpace();
 }
 
 void olotApiLayer::RemoveInstance( XrInstance instance ){
-	MapInstances::iterator iter( pInstances.find( instance ) );
-	OLOTASSERT_FALSE( iter == pInstances.cend(), XR_ERROR_HANDLE_INVALID )
-	pInstances.erase( iter );
+	OLOTASSERT_TRUE( pInstances.Has( instance ), XR_ERROR_HANDLE_INVALID )
+	pInstances.Remove( instance );
+	pUpdateFastLocateSpace();
+}
+
+olotInstance &olotApiLayer::GetSessionInstance( XrSession session ) const{
+	olotInstance * const instance = FindSessionInstance( session );
+	OLOTASSERT_NOTNULL( instance, XR_ERROR_HANDLE_INVALID )
+	return *instance;
+}
+
+olotInstance &olotApiLayer::GetActionSetInstance( XrActionSet actionSet ) const{
+	olotInstance *instance = nullptr;
+	OLOTASSERT_TRUE( pActionSets.Get( actionSet, instance ), XR_ERROR_HANDLE_INVALID )
+	return *instance;
+}
+
+olotInstance &olotApiLayer::GetActionInstance( XrAction action ) const{
+	olotInstance *instance = nullptr;
+	OLOTASSERT_TRUE( pActions.Get( action, instance ), XR_ERROR_HANDLE_INVALID )
+	return *instance;
+}
+
+olotSpace olotApiLayer::GetSpace( XrSpace space ) const{
+	olotSpace value;
+	OLOTASSERT_TRUE( FindSpace( space, value ), XR_ERROR_HANDLE_INVALID )
+	return value;
+}
+
+olotInstance *olotApiLayer::FindSessionInstance( XrSession session ) const{
+	olotInstance *instance = nullptr;
+	return pSessions.Get( session, instance ) ? instance : nullptr;
+}
+
+bool olotApiLayer::FindSpace( XrSpace space, olotSpace &value ) const{
+	return pSpaces.Get( space, value );
+}
+
+void olotApiLayer::RemoveInstanceHandles( olotInstance *instance ){
+	pSpaces.ForEach( [ this, instance ]( const olotSpace &space ){
+		if( space.instance == instance ){
+			SetGazeSpace( space.space, false );
+		}
+	} );
+	
+	pSessions.RemoveValue( instance );
+	pActionSets.RemoveValue( instance );
+	pActions.RemoveValue( instance );
+	pSpaces.RemoveIf( [ instance ]( uint64_t, const olotSpace &space ){
+		return space.instance == instance;
+	} );
+}
+
+
+
+void olotApiLayer::SetGazeSpace( XrSpace space, bool gaze ){
+	// writers are serialized by the mutex. readers scan again if the spaces changed
+	const std::lock_guard<std::mutex> guard( pMutexGazeSpaces );
+	pGazeSpacesLock.BeginWrite();
+	pSetGazeSpace( pSpaceKey( space ), gaze );
+	pGazeSpacesLock.EndWrite();
 }
 
 
@@ -241,17 +352,88 @@ void olotApiLayer::DropOcsClient(){
 
 
 
-std::ostream& olotApiLayer::baseLogStream()
-{
-	const auto now = std::time( nullptr );
-	const auto tm_info = std::localtime( &now );
-	
-	char buffer[ 100 ];
-	std::strftime( buffer, 100, "%Y-%m-%d %H:%M:%S", tm_info );
-	
-	return pLogFile << "[" << buffer << "] ";
+std::ostream &olotApiLayer::baseLogStream(){
+	return pLogWriter.Stream();
 }
 
 std::ostream &olotApiLayer::log(){
 	return baseLogStream() << pLayerName << ": ";
 }
+
+
+
+// Private Functions
+//////////////////////
+
+// the fast path is only used if all instances use the same next layer function. otherwise
+// the space has to be looked up to find the right instance
+void olotApiLayer::pUpdateFastLocateSpace(){
+	PFN_xrLocateSpace function = nullptr;
+	bool shared = true;
+	
+	pInstances.ForEach( [ &function, &shared ]( const olotInstance::Ref &instance ){
+		if( ! function ){
+			function = instance->GetNextXrLocateSpace();
+			
+		}else if( instance->GetNextXrLocateSpace() != function ){
+			shared = false;
+		}
+	} );
+	
+	pFastLocateSpace.store( shared ? function : nullptr, std::memory_order_relaxed );
+}
+
+void olotApiLayer::pSetGazeSpace( uint64_t key, bool gaze ){
+	const int count = pGazeSpaceCount.load( std::memory_order_relaxed );
+	int i;
+	
+	for( i=0; i<count; i++ ){
+		if( pGazeSpaces[ i ].load( std::memory_order_relaxed ) == key ){
+			break;
+		}
+	}
+	
+	if( gaze ){
+		if( i < count ){
+			return;
+		}
+		
+		// too many gaze spaces. all spaces take the slow path until enough gaze spaces
+		// have been untagged for the overflowed ones to fit
+		if( count == MaxGazeSpaces ){
+			if( std::find( pGazeSpacesOverflowed.cbegin(), pGazeSpacesOverflowed.cend(), key )
+			== pGazeSpacesOverflowed.cend() ){
+				pGazeSpacesOverflowed.push_back( key );
+				pGazeSpaceOverflow.store( true, std::memory_order_relaxed );
+			}
+			return;
+		}
+		
+		pGazeSpaces[ count ].store( key, std::memory_order_relaxed );
+		pGazeSpaceCount.store( count + 1, std::memory_order_relaxed );
+		
+	}else if( i < count ){
+		if( ! pGazeSpacesOverflowed.empty() ){
+			// replace the removed entry with an overflowed one
+			pGazeSpaces[ i ].store( pGazeSpacesOverflowed.back(), std::memory_order_relaxed );
+			pGazeSpacesOverflowed.pop_back();
+			
+		}else{
+			// move the last entry into the removed slot
+			pGazeSpaces[ i ].store( pGazeSpaces[ count - 1 ].load( std::memory_order_relaxed ),
+				std::memory_order_relaxed );
+			pGazeSpaceCount.store( count - 1, std::memory_order_relaxed );
+		}
+		
+	}else{
+		const std::vector<uint64_t>::iterator iter = std::find(
+			pGazeSpacesOverflowed.begin(), pGazeSpacesOverflowed.end(), key );
+		if( iter != pGazeSpacesOverflowed.end() ){
+			pGazeSpacesOverflowed.erase( iter );
+		}
+	}
+	
+	if( pGazeSpacesOverflowed.empty() && pGazeSpaceOverflow.load( std::memory_order_relaxed ) ){
+		pGazeSpaceOverflow.store( false, std::memory_order_relaxed );
+	}
+}
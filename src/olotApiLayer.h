@@ -26,16 +26,21 @@
 #define _OLOTAPILAYER_H_
 
 #include <string>
-#include <unordered_map>
 #include <vector>
-#include <fstream>
+#include <atomic>
 #include <mutex>
+#include <string.h>
 
 #include "openxr/openxr.h"
 #include "openxr/loader_interfaces.h"
 
 #include "olotStructs.h"
 #include "olotInstance.h"
+#include "olotConfig.h"
+#include "olotLog.h"
+#include "olotLogWriter.h"
+#include "utils/olotHandleRegistry.h"
+#include "utils/olotSeqLock.h"
 
 class olotOcsClient;
 
@@ -45,45 +50,53 @@ class olotOcsClient;
  */
 class olotApiLayer{
 public:
-	/** Instance map. */
-	typedef std::unordered_map<XrInstance,olotInstance::Ref> MapInstances;
+	/** Instance registry. */
+	typedef olotHandleRegistry<XrInstance,olotInstance::Ref> RegistryInstances;
 	
-	/** Session map. */
-	typedef std::unordered_map<XrSession,olotInstance*> MapSessions;
+	/** Session registry. */
+	typedef olotHandleRegistry<XrSession,olotInstance*> RegistrySessions;
 	
-	/** Space map. */
-	typedef std::unordered_map<XrSpace,olotSpace> MapSpaces;
+	/** Space registry. */
+	typedef olotHandleRegistry<XrSpace,olotSpace> RegistrySpaces;
 	
-	/** Action set map. */
-	typedef std::unordered_map<XrActionSet,olotInstance*> MapActionSets;
+	/** Action set registry. */
+	typedef olotHandleRegistry<XrActionSet,olotInstance*> RegistryActionSets;
 	
-	/** Action map. */
-	typedef std::unordered_map<XrAction,olotInstance*> MapActions;
+	/** Action registry. */
+	typedef olotHandleRegistry<XrAction,olotInstance*> RegistryActions;
+	
+	/** Maximum number of gaze spaces tracked for the xrLocateSpace fast path. */
+	const static int MaxGazeSpaces = 8;
 	
 	
 	
 private:
+	olotLogWriter &pLogWriter;
+	
 	std::string pLayerName;
 	
 	bool pSupportsEyeGazeTracking;
 	bool pSupportsFacialTracking;
 	
-	MapInstances pInstances;
-	MapSessions pSessions;
-	MapSpaces pSpaces;
-	MapActionSets pActionSets;
-	MapActions pActions;
+	RegistryInstances pInstances;
+	RegistrySessions pSessions;
+	RegistrySpaces pSpaces;
+	RegistryActionSets pActionSets;
+	RegistryActions pActions;
+	
+	std::atomic<PFN_xrLocateSpace> pFastLocateSpace;
+	std::atomic<uint64_t> pGazeSpaces[ MaxGazeSpaces ];
+	std::atomic<int> pGazeSpaceCount;
+	std::atomic<bool> pGazeSpaceOverflow;
+	std::vector<uint64_t> pGazeSpacesOverflowed;
+	std::mutex pMutexGazeSpaces;
+	olotSeqLock pGazeSpacesLock;
 	
 	std::shared_ptr<olotOcsClient> pOcsClient;
 	
-	std::ofstream pLogFile;
-
-
-
-public:
-	std::mutex mutexLog;
+	olotConfig pConfig;
+	
 	
-
 	
 public:
 	/** \name Constructors and Destructors */
@@ -115,16 +128,15 @@ public:
 	/** Facial tracking is supported. */
 	inline bool GetSupportsFacialTracking() const{ return pSupportsFacialTracking; }
 	
+	/** Configuration. */
+	inline const olotConfig &GetConfig() const{ return pConfig; }
 	
 	
-	/** Instances. */
-	inline MapInstances &GetInstances(){ return pInstances; }
-	inline const MapInstances &GetInstances() const{ return pInstances; }
 	
 	/** Instance is present. */
 	bool HasInstance( XrInstance instance ) const;
 	
-	/** Instance by handle or nullptr. */
+	/** Instance by handle. Throws XR_ERROR_HANDLE_INVALID if absent. */
 	olotInstance::Ref GetInstance( XrInstance instance ) const;
 	
 	/** Add instance. */
@@ -133,23 +145,77 @@ public:
 	/** Remove instance. */
 	void RemoveInstance( XrInstance instance );
 	
-	
-	
-	/** Sessions. */
-	inline MapSessions &GetSessions(){ return pSessions; }
-	inline const MapSessions &GetSessions() const{ return pSessions; }
-	
-	/** Spaces. */
-	inline MapSpaces &GetSpaces(){ return pSpaces; }
-	inline const MapSpaces &GetSpaces() const{ return pSpaces; }
-	
-	/** Action sets. */
-	inline MapActionSets &GetActionSets(){ return pActionSets; }
-	inline const MapActionSets &GetActionSets() const{ return pActionSets; }
-	
-	/** Actions. */
-	inline MapActions &GetActions(){ return pActions; }
-	inline const MapActions &GetActions() const{ return pActions; }
+	/** Instance owning session. Wait-free. Throws XR_ERROR_HANDLE_INVALID if absent. */
+	olotInstance &GetSessionInstance( XrSession session ) const;
+	
+	/** Instance owning action set. Throws XR_ERROR_HANDLE_INVALID if absent. */
+	olotInstance &GetActionSetInstance( XrActionSet actionSet ) const;
+	
+	/** Instance owning action. Throws XR_ERROR_HANDLE_INVALID if absent. */
+	olotInstance &GetActionInstance( XrAction action ) const;
+	
+	/** Space by handle. Wait-free. Throws XR_ERROR_HANDLE_INVALID if absent. */
+	olotSpace GetSpace( XrSpace space ) const;
+	
+	/** Instance owning session or nullptr if absent. Wait-free and never throws. */
+	olotInstance *FindSessionInstance( XrSession session ) const;
+	
+	/** Space by handle. Returns false if absent. Wait-free and never throws. */
+	bool FindSpace( XrSpace space, olotSpace &value ) const;
+	
+	/**
+	 * Session registry. Lookups are wait-free and safe while other threads add or
+	 * remove handles.
+	 */
+	inline RegistrySessions &GetSessions(){ return pSessions; }
+	
+	/** Space registry. */
+	inline RegistrySpaces &GetSpaces(){ return pSpaces; }
+	
+	/** Action set registry. */
+	inline RegistryActionSets &GetActionSets(){ return pActionSets; }
+	
+	/** Action registry. */
+	inline RegistryActions &GetActions(){ return pActions; }
+	
+	/** Remove all sessions, spaces, action sets and actions of instance. */
+	void RemoveInstanceHandles( olotInstance *instance );
+	
+	/**
+	 * Next layer xrLocateSpace shared by all instances or nullptr if instances differ.
+	 * Spaces not bound to eye gaze are passed directly to this function.
+	 */
+	inline PFN_xrLocateSpace GetFastLocateSpace() const{
+		return pFastLocateSpace.load( std::memory_order_relaxed );
+	}
+	
+	/**
+	 * Space is bound to eye gaze. Lock-free without hashing.
+	 * 
+	 * Returns true for all spaces while more than MaxGazeSpaces gaze spaces are tagged.
+	 * Scans again if spaces have been tagged or untagged while scanning.
+	 */
+	inline bool IsGazeSpace( XrSpace space ) const{
+		const uint64_t key = pSpaceKey( space );
+		uint32_t sequence;
+		bool found;
+		
+		do{
+			sequence = pGazeSpacesLock.BeginRead();
+			found = pGazeSpaceOverflow.load( std::memory_order_relaxed );
+			
+			const int count = pGazeSpaceCount.load( std::memory_order_relaxed );
+			int i;
+			for( i=0; i<count && ! found; i++ ){
+				found = pGazeSpaces[ i ].load( std::memory_order_relaxed ) == key;
+			}
+		}while( pGazeSpacesLock.RetryRead( sequence ) );
+		
+		return found;
+	}
+	
+	/** Tag or untag space as bound to eye gaze. */
+	void SetGazeSpace( XrSpace space, bool gaze );
 	
 	
 	
@@ -159,14 +225,35 @@ public:
 	/** Drop VIVE SDK. */
 	void DropOcsClient();
 	
+	/** OCS client or nullptr if not acquired. */
+	inline olotOcsClient *GetOcsClient() const{ return pOcsClient.get(); }
+	
 	
 	
-	/** Base log stream. */
+	/** Log writer. */
+	inline olotLogWriter &GetLogWriter(){ return pLogWriter; }
+	
+	/**
+	 * Base log stream. Thread local and lock-free. Lines are written asynchronously
+	 * with a timestamp prefix.
+	 */
 	std::ostream &baseLogStream();
 
 	/** Log stream. */
 	std::ostream &log();
 	/*@}*/
+	
+	
+	
+private:
+	static inline uint64_t pSpaceKey( XrSpace space ){
+		uint64_t key = 0;
+		memcpy( &key, &space, sizeof( space ) );
+		return key;
+	}
+	
+	void pUpdateFastLocateSpace();
+	void pSetGazeSpace( uint64_t key, bool gaze );
 };
 
 #endif
@@ -0,0 +1,250 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sstream>
+
+#include "olotConfig.h"
+#include "olotApiLayer.h"
+
+
+// Definitions
+////////////////
+
+#define ENV_PREFIX "OCSEYEFACETRACKING_"
+
+
+
+// class olotConfig
+/////////////////////
+
+olotConfig::olotConfig() :
+pPorts{ 8888 },
+pIPv6( false ),
+pReceiveBufferSize( 0 ),
+pGazePredictionLimit( 50 ),
+pFilter( false ),
+pFilterMinCutoff( 1.0f ),
+pFilterBeta( 1.0f ),
+pFilterDerivativeCutoff( 1.0f ),
+pStatisticsInterval( 60 ),
+pLogLevel( olotLog::elInfo ),
+pLogFlushOnCrash( false ){
+}
+
+olotConfig::~olotConfig(){
+}
+
+
+
+// Management
+///////////////
+
+void olotConfig::LoadFromEnvironment(){
+	const char *value = getenv( ENV_PREFIX "PORT" );
+	if( value ){
+		ListPorts ports;
+		std::stringstream stream( value );
+		std::string item;
+		int port;
+		
+		while( std::getline( stream, item, ',' ) ){
+			if( ! pParseInt( ENV_PREFIX "PORT", item.c_str(), 1, 65535, port ) ){
+				ports.clear();
+				break;
+			}
+			ports.push_back( port );
+		}
+		
+		if( ! ports.empty() ){
+			pPorts = ports;
+		}
+	}
+	
+	value = getenv( ENV_PREFIX "BIND_ADDRESS" );
+	if( value ){
+		pBindAddress = value;
+	}
+	
+	value = getenv( ENV_PREFIX "IPV6" );
+	if( value ){
+		pParseBool( ENV_PREFIX "IPV6", value, pIPv6 );
+	}
+	
+	value = getenv( ENV_PREFIX "MULTICAST_GROUP" );
+	if( value ){
+		pMulticastGroup = value;
+	}
+	
+	value = getenv( ENV_PREFIX "RECEIVE_BUFFER_SIZE" );
+	if( value ){
+		pParseInt( ENV_PREFIX "RECEIVE_BUFFER_SIZE", value, 0, 1 << 30, pReceiveBufferSize );
+	}
+	
+	value = getenv( ENV_PREFIX "SHM_NAME" );
+	if( value ){
+		pShmName = value;
+	}
+	
+	value = getenv( ENV_PREFIX "GAZE_PREDICTION_LIMIT" );
+	if( value ){
+		pParseInt( ENV_PREFIX "GAZE_PREDICTION_LIMIT", value, 0, 1000, pGazePredictionLimit );
+	}
+	
+	value = getenv( ENV_PREFIX "FILTER" );
+	if( value ){
+		pParseBool( ENV_PREFIX "FILTER", value, pFilter );
+	}
+	
+	value = getenv( ENV_PREFIX "FILTER_MIN_CUTOFF" );
+	if( value ){
+		pParseFloat( ENV_PREFIX "FILTER_MIN_CUTOFF", value, 0.01f, 1000.0f, pFilterMinCutoff );
+	}
+	
+	value = getenv( ENV_PREFIX "FILTER_BETA" );
+	if( value ){
+		pParseFloat( ENV_PREFIX "FILTER_BETA", value, 0.0f, 1000.0f, pFilterBeta );
+	}
+	
+	value = getenv( ENV_PREFIX "FILTER_DERIVATIVE_CUTOFF" );
+	if( value ){
+		pParseFloat( ENV_PREFIX "FILTER_DERIVATIVE_CUTOFF", value, 0.01f, 1000.0f, pFilterDerivativeCutoff );
+	}
+	
+	value = getenv( ENV_PREFIX "PROFILE" );
+	if( value ){
+		pProfile = value;
+	}
+	
+	value = getenv( ENV_PREFIX "STATS_INTERVAL" );
+	if( value ){
+		pParseInt( ENV_PREFIX "STATS_INTERVAL", value, 0, 86400, pStatisticsInterval );
+	}
+	
+	value = getenv( ENV_PREFIX "STATS_FILE" );
+	if( value ){
+		pStatisticsFile = value;
+	}
+	
+	value = getenv( ENV_PREFIX "LOG_LEVEL" );
+	if( value && ! olotLog::ParseLevel( value, pLogLevel ) ){
+		OLOTLOG_WARNING( log(), "Invalid value '" << value << "' for " ENV_PREFIX "LOG_LEVEL" );
+	}
+	
+	value = getenv( ENV_PREFIX "LOG_FLUSH_ON_CRASH" );
+	if( value ){
+		pParseBool( ENV_PREFIX "LOG_FLUSH_ON_CRASH", value, pLogFlushOnCrash );
+	}
+}
+
+void olotConfig::LogConfig(){
+	if( ! olotLog::IsEnabled( olotLog::elInfo ) ){
+		return;
+	}
+	
+	std::ostream &stream = log() << "Ports:";
+	ListPorts::const_iterator iter;
+	for( iter = pPorts.cbegin(); iter != pPorts.cend(); iter++ ){
+		stream << " " << *iter;
+	}
+	stream << std::endl;
+	
+	OLOTLOG_INFO( log(), "Bind address: " << ( pBindAddress.empty() ? "any" : pBindAddress ) );
+	OLOTLOG_INFO( log(), "IPv6: " << ( pIPv6 ? "yes" : "no" ) );
+	OLOTLOG_INFO( log(), "Multicast group: " << ( pMulticastGroup.empty() ? "none" : pMulticastGroup ) );
+	OLOTLOG_INFO( log(), "Receive buffer size: " << pReceiveBufferSize );
+	OLOTLOG_INFO( log(), "Shared memory: " << ( pShmName.empty() ? "none" : pShmName ) );
+	OLOTLOG_INFO( log(), "Gaze prediction limit: " << pGazePredictionLimit << "ms" );
+	
+	if( pFilter ){
+		OLOTLOG_INFO( log(), "Filter: min cutoff " << pFilterMinCutoff << "Hz, beta " << pFilterBeta
+			<< ", derivative cutoff " << pFilterDerivativeCutoff << "Hz" );
+		
+	}else{
+		OLOTLOG_INFO( log(), "Filter: no" );
+	}
+	
+	OLOTLOG_INFO( log(), "Profile: " << ( pProfile.empty() ? "built-in" : pProfile ) );
+	OLOTLOG_INFO( log(), "Statistics interval: " << pStatisticsInterval << "s" );
+	OLOTLOG_INFO( log(), "Statistics file: " << ( pStatisticsFile.empty() ? "none" : pStatisticsFile ) );
+	OLOTLOG_INFO( log(), "Log level: " << olotLog::GetLevelName( pLogLevel ) );
+	OLOTLOG_INFO( log(), "Log flush on crash: " << ( pLogFlushOnCrash ? "yes" : "no" ) );
+}
+
+std::ostream &olotConfig::log(){
+	return olotApiLayer::Get().baseLogStream()
+		<< olotApiLayer::Get().GetLayerName() << ".Config: ";
+}
+
+
+
+// Private Functions
+//////////////////////
+
+bool olotConfig::pParseInt( const char *name, const char *value,
+int minimum, int maximum, int &result ){
+	char *end = nullptr;
+	errno = 0;
+	const long parsed = strtol( value, &end, 10 );
+	
+	if( errno != 0 || end == value || *end != 0 || parsed < minimum || parsed > maximum ){
+		OLOTLOG_WARNING( log(), "Invalid value '" << value << "' for " << name );
+		return false;
+	}
+	
+	result = ( int )parsed;
+	return true;
+}
+
+bool olotConfig::pParseFloat( const char *name, const char *value,
+float minimum, float maximum, float &result ){
+	char *end = nullptr;
+	errno = 0;
+	const float parsed = strtof( value, &end );
+	
+	if( errno != 0 || end == value || *end != 0 || ! ( parsed >= minimum && parsed <= maximum ) ){
+		OLOTLOG_WARNING( log(), "Invalid value '" << value << "' for " << name );
+		return false;
+	}
+	
+	result = parsed;
+	return true;
+}
+
+bool olotConfig::pParseBool( const char *name, const char *value, bool &result ){
+	if( strcmp( value, "1" ) == 0 ){
+		result = true;
+		return true;
+		
+	}else if( strcmp( value, "0" ) == 0 ){
+		result = false;
+		return true;
+		
+	}else{
+		OLOTLOG_WARNING( log(), "Invalid value '" << value << "' for " << name );
+		return false;
+	}
+}
@@ -0,0 +1,222 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _OLOTCONFIG_H_
+#define _OLOTCONFIG_H_
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "olotLog.h"
+
+
+/**
+ * Layer configuration.
+ * 
+ * Values are read from environment variables prefixed with OCSEYEFACETRACKING_. Invalid
+ * values are logged and ignored keeping the default value.
+ */
+class olotConfig{
+public:
+	/** Port list. */
+	typedef std::vector<int> ListPorts;
+	
+	
+	
+private:
+	ListPorts pPorts;
+	std::string pBindAddress;
+	bool pIPv6;
+	std::string pMulticastGroup;
+	int pReceiveBufferSize;
+	std::string pShmName;
+	int pGazePredictionLimit;
+	bool pFilter;
+	float pFilterMinCutoff;
+	float pFilterBeta;
+	float pFilterDerivativeCutoff;
+	std::string pProfile;
+	int pStatisticsInterval;
+	std::string pStatisticsFile;
+	olotLog::eLevel pLogLevel;
+	bool pLogFlushOnCrash;
+	
+	
+	
+public:
+	/** \name Constructors and Destructors */
+	/*@{*/
+	/** Create configuration with default values. */
+	olotConfig();
+	
+	/** Clean up configuration. */
+	~olotConfig();
+	/*@}*/
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/** Load configuration from environment variables. */
+	void LoadFromEnvironment();
+	
+	/** Log configuration. */
+	void LogConfig();
+	
+	/**
+	 * Ports to listen on.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_PORT. Comma separated list of ports.
+	 * Default is 8888.
+	 */
+	inline const ListPorts &GetPorts() const{ return pPorts; }
+	
+	/**
+	 * Address to bind to or empty string to bind to any address.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_BIND_ADDRESS. IPv4 or IPv6 address.
+	 */
+	inline const std::string &GetBindAddress() const{ return pBindAddress; }
+	
+	/**
+	 * Listen on IPv6 and IPv4 using dual-stack sockets if no bind address is set.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_IPV6. Set to 1 to enable. Default is 0.
+	 */
+	inline bool GetIPv6() const{ return pIPv6; }
+	
+	/**
+	 * Multicast group to join or empty string to not join any group.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_MULTICAST_GROUP. IPv4 or IPv6 address.
+	 */
+	inline const std::string &GetMulticastGroup() const{ return pMulticastGroup; }
+	
+	/**
+	 * Socket receive buffer size in bytes or 0 to use system default.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_RECEIVE_BUFFER_SIZE.
+	 */
+	inline int GetReceiveBufferSize() const{ return pReceiveBufferSize; }
+	
+	/**
+	 * Name of shared memory object to read frames from or empty string to receive OSC packets.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_SHM_NAME. If set no sockets are opened.
+	 * See olot_shm.h for the layout.
+	 */
+	inline const std::string &GetShmName() const{ return pShmName; }
+	
+	/**
+	 * Maximum time in milliseconds eye gaze is predicted ahead of the latest sample.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_GAZE_PREDICTION_LIMIT. 0 disables prediction.
+	 * Default is 50.
+	 */
+	inline int GetGazePredictionLimit() const{ return pGazePredictionLimit; }
+	
+	/**
+	 * Smooth received values using an adaptive low-pass filter.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_FILTER. Set to 1 to enable. Default is 0.
+	 */
+	inline bool GetFilter() const{ return pFilter; }
+	
+	/**
+	 * Filter cutoff frequency in Hz while values change slowly.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_FILTER_MIN_CUTOFF. Lower values remove more
+	 * jitter but add lag. Default is 1.
+	 */
+	inline float GetFilterMinCutoff() const{ return pFilterMinCutoff; }
+	
+	/**
+	 * Filter cutoff frequency increase in Hz per value change per second.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_FILTER_BETA. Higher values reduce lag of
+	 * fast changes. Default is 1.
+	 */
+	inline float GetFilterBeta() const{ return pFilterBeta; }
+	
+	/**
+	 * Cutoff frequency in Hz used for estimating the speed of value changes.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_FILTER_DERIVATIVE_CUTOFF. Default is 1.
+	 */
+	inline float GetFilterDerivativeCutoff() const{ return pFilterDerivativeCutoff; }
+	
+	/**
+	 * Path of expression remapping profile or empty string to use the built-in mapping.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_PROFILE. Loaded at instance creation.
+	 */
+	inline const std::string &GetProfile() const{ return pProfile; }
+	
+	/**
+	 * Interval in seconds between logging latency statistics.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_STATS_INTERVAL. 0 disables periodic logging.
+	 * Statistics are logged once more when the OCS client stops. Default is 60.
+	 */
+	inline int GetStatisticsInterval() const{ return pStatisticsInterval; }
+	
+	/**
+	 * Path of file to write latency statistics to or empty string if not used.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_STATS_FILE. The file is replaced with the
+	 * statistics collected so far each statistics interval before they are logged and
+	 * once more when the OCS client stops.
+	 */
+	inline const std::string &GetStatisticsFile() const{ return pStatisticsFile; }
+	
+	/**
+	 * Lowest level of logged messages.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_LOG_LEVEL. One of trace, debug, info, warning
+	 * or error. Default is info.
+	 */
+	inline olotLog::eLevel GetLogLevel() const{ return pLogLevel; }
+	
+	/**
+	 * Write pending log records if the application crashes.
+	 * 
+	 * Environment variable OCSEYEFACETRACKING_LOG_FLUSH_ON_CRASH. Set to 1 to install
+	 * handlers for crash signals. Default is 0.
+	 */
+	inline bool GetLogFlushOnCrash() const{ return pLogFlushOnCrash; }
+	
+	/** Log stream. */
+	std::ostream &log();
+	/*@}*/
+	
+	
+	
+private:
+	bool pParseInt( const char *name, const char *value, int minimum, int maximum, int &result );
+	bool pParseFloat( const char *name, const char *value, float minimum, float maximum, float &result );
+	bool pParseBool( const char *name, const char *value, bool &result );
+};
+
+#endif
@@ -0,0 +1,223 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <string.h>
+#include <algorithm>
+
+#include "olotExpressionFrame.h"
+#include "olotExpressionMapping.h"
+#include "olotEyeGazeTracker.h"
+
+
+// Definitions
+////////////////
+
+enum eSource{
+	esExpression,
+	esHtcEye
+};
+
+struct sConversion{
+	XrFaceExpressionFB output;
+	eSource source;
+	int input;
+};
+
+#define OLOT_EXPR( output, input ) { output, esExpression, olotOcsClient::input }
+#define OLOT_EYE( output, input ) { output, esHtcEye, input }
+
+/*
+fb expressions not converted. always 0:
+- brow lowerer, inner brow raiser and outer brow raiser
+- cheek raiser
+- lip tightener
+
+eye look expressions are converted from the eye states directly
+*/
+static const sConversion vConversionFB[] = {
+	OLOT_EXPR( XR_FACE_EXPRESSION_CHEEK_PUFF_L_FB, eeCheekPuffLeft ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_CHEEK_PUFF_R_FB, eeCheekPuffRight ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_CHEEK_SUCK_L_FB, eeCheekSuckLeft ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_CHEEK_SUCK_R_FB, eeCheekSuckRight ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_CHIN_RAISER_B_FB, eeMouthShrugLower ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_CHIN_RAISER_T_FB, eeMouthShrugUpper ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_DIMPLER_L_FB, eeMouthDimpleLeft ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_DIMPLER_R_FB, eeMouthDimpleRight ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_JAW_DROP_FB, eeJawOpen ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_JAW_SIDEWAYS_LEFT_FB, eeJawLeft ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_JAW_SIDEWAYS_RIGHT_FB, eeJawRight ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_JAW_THRUST_FB, eeJawForward ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_CORNER_DEPRESSOR_L_FB, eeMouthFrownLeft ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_CORNER_DEPRESSOR_R_FB, eeMouthFrownRight ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_CORNER_PULLER_L_FB, eeMouthSmileLeft ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_CORNER_PULLER_R_FB, eeMouthSmileRight ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_FUNNELER_LB_FB, eeMouthFunnel ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_FUNNELER_LT_FB, eeMouthFunnel ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_FUNNELER_RB_FB, eeMouthFunnel ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_FUNNELER_RT_FB, eeMouthFunnel ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_PRESSOR_L_FB, eeMouthPressLeft ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_PRESSOR_R_FB, eeMouthPressRight ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_PUCKER_L_FB, eeMouthPucker ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_PUCKER_R_FB, eeMouthPucker ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_STRETCHER_L_FB, eeMouthStretchLeft ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_STRETCHER_R_FB, eeMouthStretchRight ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_SUCK_LB_FB, eeMouthRollLower ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_SUCK_LT_FB, eeMouthRollUpper ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_SUCK_RB_FB, eeMouthRollLower ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIP_SUCK_RT_FB, eeMouthRollUpper ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LIPS_TOWARD_FB, eeMouthClose ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LOWER_LIP_DEPRESSOR_L_FB, eeMouthLowerDownLeft ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_LOWER_LIP_DEPRESSOR_R_FB, eeMouthLowerDownRight ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_MOUTH_LEFT_FB, eeMouthLeft ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_MOUTH_RIGHT_FB, eeMouthRight ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_NOSE_WRINKLER_L_FB, eeNoseSneerLeft ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_NOSE_WRINKLER_R_FB, eeNoseSneerRight ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_UPPER_LIP_RAISER_L_FB, eeMouthUpperUpLeft ),
+	OLOT_EXPR( XR_FACE_EXPRESSION_UPPER_LIP_RAISER_R_FB, eeMouthUpperUpRight ),
+	
+	OLOT_EYE( XR_FACE_EXPRESSION_EYES_CLOSED_L_FB, XR_EYE_EXPRESSION_LEFT_BLINK_HTC ),
+	OLOT_EYE( XR_FACE_EXPRESSION_EYES_CLOSED_R_FB, XR_EYE_EXPRESSION_RIGHT_BLINK_HTC ),
+	OLOT_EYE( XR_FACE_EXPRESSION_UPPER_LID_RAISER_L_FB, XR_EYE_EXPRESSION_LEFT_WIDE_HTC ),
+	OLOT_EYE( XR_FACE_EXPRESSION_UPPER_LID_RAISER_R_FB, XR_EYE_EXPRESSION_RIGHT_WIDE_HTC ),
+	OLOT_EYE( XR_FACE_EXPRESSION_LID_TIGHTENER_L_FB, XR_EYE_EXPRESSION_LEFT_SQUEEZE_HTC ),
+	OLOT_EYE( XR_FACE_EXPRESSION_LID_TIGHTENER_R_FB, XR_EYE_EXPRESSION_RIGHT_SQUEEZE_HTC )
+};
+
+static const int vConversionFBCount = sizeof( vConversionFB ) / sizeof( vConversionFB[ 0 ] );
+
+#undef OLOT_EYE
+#undef OLOT_EXPR
+
+static inline float clamp( float value ){
+	return std::min( std::max( value, 0.0f ), 1.0f );
+}
+
+
+
+// class olotExpressionFrame
+//////////////////////////////
+
+// Management
+///////////////
+
+void olotExpressionFrame::Clear( sFrame &frame ){
+	memset( &frame, 0, sizeof( frame ) );
+}
+
+void olotExpressionFrame::Compute( const olotOcsClient::sSnapshot &snapshot,
+const olotOcsSampleHistory &history, const olotExpressionMapping *mappingEye,
+const olotExpressionMapping *mappingLip, sFrame &frame ){
+	frame.version = snapshot.version;
+	frame.time = snapshot.time;
+	
+	memcpy( frame.eyeStates, snapshot.eyeStates, sizeof( frame.eyeStates ) );
+	olotEyeGazeTracker::CalcAngles( snapshot.eyeStates, frame.gazeHorizontal, frame.gazeVertical );
+	pCalcGazeMotion( snapshot, history, frame );
+	
+	if( mappingEye ){
+		mappingEye->Evaluate( snapshot.expressions, frame.htcEye );
+		
+	}else{
+		memset( frame.htcEye, 0, sizeof( frame.htcEye ) );
+	}
+	
+	if( mappingLip ){
+		mappingLip->Evaluate( snapshot.expressions, frame.htcLip );
+		
+	}else{
+		memset( frame.htcLip, 0, sizeof( frame.htcLip ) );
+	}
+	
+	pConvertFB( snapshot, frame );
+}
+
+
+
+// Private Functions
+//////////////////////
+
+void olotExpressionFrame::pConvertFB( const olotOcsClient::sSnapshot &snapshot, sFrame &frame ){
+	memset( frame.fb, 0, sizeof( frame.fb ) );
+	
+	int i;
+	for( i=0; i<vConversionFBCount; i++ ){
+		const sConversion &c = vConversionFB[ i ];
+		frame.fb[ c.output ] = c.source == esExpression
+			? snapshot.expressions[ c.input ] : frame.htcEye[ c.input ];
+	}
+	
+	// eye states range from -1 to 1. positive x looks right and positive y looks up
+	const float leftX = snapshot.eyeStates[ olotOcsClient::eesLeftEyeX ];
+	const float rightX = snapshot.eyeStates[ olotOcsClient::eesRightEyeX ];
+	const float y = snapshot.eyeStates[ olotOcsClient::eesEyesY ];
+	
+	frame.fb[ XR_FACE_EXPRESSION_EYES_LOOK_LEFT_L_FB ] = clamp( -leftX );
+	frame.fb[ XR_FACE_EXPRESSION_EYES_LOOK_RIGHT_L_FB ] = clamp( leftX );
+	frame.fb[ XR_FACE_EXPRESSION_EYES_LOOK_LEFT_R_FB ] = clamp( -rightX );
+	frame.fb[ XR_FACE_EXPRESSION_EYES_LOOK_RIGHT_R_FB ] = clamp( rightX );
+	frame.fb[ XR_FACE_EXPRESSION_EYES_LOOK_UP_L_FB ] = clamp( y );
+	frame.fb[ XR_FACE_EXPRESSION_EYES_LOOK_UP_R_FB ] = clamp( y );
+	frame.fb[ XR_FACE_EXPRESSION_EYES_LOOK_DOWN_L_FB ] = clamp( -y );
+	frame.fb[ XR_FACE_EXPRESSION_EYES_LOOK_DOWN_R_FB ] = clamp( -y );
+}
+
+void olotExpressionFrame::pCalcGazeMotion( const olotOcsClient::sSnapshot &snapshot,
+const olotOcsSampleHistory &history, sFrame &frame ){
+	int i;
+	
+	// the read thread can add samples after the snapshot has been published. samples
+	// newer than the snapshot are not part of it
+	int64_t newest = 0;
+	for( i=0; i<olotOcsClient::EyeStateCount; i++ ){
+		newest = std::max( newest, history.GetLastSampleTime(
+			olotOcsClient::EyeStateChannel( ( olotOcsClient::eEyeState )i ) ) );
+	}
+	
+	frame.gazeTime = std::min( newest, snapshot.time );
+	frame.gazeVelocityHorizontal = 0.0f;
+	frame.gazeVelocityVertical = 0.0f;
+	
+	if( frame.gazeTime == 0 ){
+		return;
+	}
+	
+	// the velocity is measured between the snapshot angles and the angles one velocity
+	// window earlier. channels without samples do not contribute
+	float eyeStatesOlder[ olotOcsClient::EyeStateCount ];
+	
+	for( i=0; i<olotOcsClient::EyeStateCount; i++ ){
+		if( ! history.GetValueAt( olotOcsClient::EyeStateChannel( ( olotOcsClient::eEyeState )i ),
+		frame.gazeTime - olotEyeGazeTracker::VelocityWindow, eyeStatesOlder[ i ] ) ){
+			eyeStatesOlder[ i ] = snapshot.eyeStates[ i ];
+		}
+	}
+	
+	float rotHorzOlder, rotVertOlder;
+	olotEyeGazeTracker::CalcAngles( eyeStatesOlder, rotHorzOlder, rotVertOlder );
+	
+	const float windowSeconds = ( float )olotEyeGazeTracker::VelocityWindow * 1e-9f;
+	frame.gazeVelocityHorizontal = ( frame.gazeHorizontal - rotHorzOlder ) / windowSeconds;
+	frame.gazeVelocityVertical = ( frame.gazeVertical - rotVertOlder ) / windowSeconds;
+}
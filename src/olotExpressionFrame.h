@@ -0,0 +1,113 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _OLOTEXPRESSIONFRAME_H_
+#define _OLOTEXPRESSIONFRAME_H_
+
+#include <stdint.h>
+
+#include "openxr/openxr.h"
+#include "olotOcsClient.h"
+
+class olotExpressionMapping;
+
+
+/**
+ * Canonical expression frame.
+ * 
+ * Computed by the instance once per published OCS snapshot. Trackers of all supported
+ * extensions copy their values from the frame instead of evaluating mappings per call.
+ */
+class olotExpressionFrame{
+public:
+	/** Number of HTC eye expressions. */
+	const static int HtcEyeCount = XR_FACIAL_EXPRESSION_EYE_COUNT_HTC;
+	
+	/** Number of HTC lip expressions. */
+	const static int HtcLipCount = XR_FACIAL_EXPRESSION_LIP_COUNT_HTC;
+	
+	/** Number of FB face expressions. */
+	const static int FbCount = XR_FACE_EXPRESSION_COUNT_FB;
+	
+	/** Frame values. Trivially copyable to be published using a seqlock. */
+	struct sFrame{
+		/** Version of the snapshot the frame is computed from. Version 0 is never used. */
+		uint32_t version;
+		
+		/** Receive time of the newest value in CLOCK_MONOTONIC nanoseconds or 0 if none. */
+		int64_t time;
+		
+		/** Eye states as received. */
+		float eyeStates[ olotOcsClient::EyeStateCount ];
+		
+		/** Horizontal and vertical gaze rotation in radians. */
+		float gazeHorizontal;
+		float gazeVertical;
+		
+		/** Arrival time of the newest eye state sample in CLOCK_MONOTONIC nanoseconds or 0 if none. */
+		int64_t gazeTime;
+		
+		/** Horizontal and vertical gaze angular velocity in radians per second. */
+		float gazeVelocityHorizontal;
+		float gazeVelocityVertical;
+		
+		/** XR_HTC_facial_tracking weights. */
+		float htcEye[ HtcEyeCount ];
+		float htcLip[ HtcLipCount ];
+		
+		/** XR_FB_face_tracking weights. */
+		float fb[ FbCount ];
+	};
+	
+	
+	
+public:
+	/** \name Management */
+	/*@{*/
+	/** Clear frame to version 0 with all weights 0. */
+	static void Clear( sFrame &frame );
+	
+	/**
+	 * Compute frame from snapshot.
+	 * 
+	 * HTC weights are evaluated using the mappings. Mappings can be nullptr in which case
+	 * the respective weights are 0. All other weights are converted from these values.
+	 * The gaze angular velocity is measured from the sample history over the velocity
+	 * window ending at the newest eye state sample.
+	 */
+	static void Compute( const olotOcsClient::sSnapshot &snapshot,
+		const olotOcsSampleHistory &history, const olotExpressionMapping *mappingEye,
+		const olotExpressionMapping *mappingLip, sFrame &frame );
+	/*@}*/
+	
+	
+	
+private:
+	static void pConvertFB( const olotOcsClient::sSnapshot &snapshot, sFrame &frame );
+	static void pCalcGazeMotion( const olotOcsClient::sSnapshot &snapshot,
+		const olotOcsSampleHistory &history, sFrame &frame );
+};
+
+#endif
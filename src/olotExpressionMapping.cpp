@@ -0,0 +1,363 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <math.h>
+#include <algorithm>
+
+#include "olotExpressionMapping.h"
+#include "olotApiLayer.h"
+#include "exceptions/exceptions.h"
+
+#if defined __x86_64__ && defined __linux__
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#define OLOT_EXPRESSION_MAPPING_CODE
+#endif
+
+
+// class olotExpressionMapping
+////////////////////////////////
+
+olotExpressionMapping::olotExpressionMapping( const sOperation *operations, int count,
+	int inputCount, int outputCount, FixedFunction fixedFunction ) :
+pInputCount( inputCount ),
+pOutputCount( outputCount ),
+pFixedFunction( fixedFunction ),
+pCode( nullptr ),
+pCodeSize( 0 )
+{
+	OLOTASSERT_TRUE( count >= 0, XR_ERROR_RUNTIME_FAILURE )
+	OLOTASSERT_TRUE( count == 0 || operations, XR_ERROR_RUNTIME_FAILURE )
+	OLOTASSERT_TRUE( inputCount > 0, XR_ERROR_RUNTIME_FAILURE )
+	OLOTASSERT_TRUE( outputCount > 0, XR_ERROR_RUNTIME_FAILURE )
+	
+	std::vector<bool> written( outputCount, false );
+	int i, j;
+	
+	for( i=0; i<count; i++ ){
+		const sOperation &operation = operations[ i ];
+		OLOTASSERT_TRUE( operation.operation >= eoCopy, XR_ERROR_RUNTIME_FAILURE )
+		OLOTASSERT_TRUE( operation.operation <= eoBlend, XR_ERROR_RUNTIME_FAILURE )
+		OLOTASSERT_TRUE( operation.output >= 0, XR_ERROR_RUNTIME_FAILURE )
+		OLOTASSERT_TRUE( operation.output < outputCount, XR_ERROR_RUNTIME_FAILURE )
+		OLOTASSERT_FALSE( written[ operation.output ], XR_ERROR_RUNTIME_FAILURE )
+		
+		for( j=0; j<3; j++ ){
+			OLOTASSERT_TRUE( operation.inputs[ j ] >= 0, XR_ERROR_RUNTIME_FAILURE )
+			OLOTASSERT_TRUE( operation.inputs[ j ] < inputCount, XR_ERROR_RUNTIME_FAILURE )
+		}
+		
+		written[ operation.output ] = true;
+		pOperations.push_back( operation );
+	}
+	
+	if( ! pFixedFunction ){
+		pCompileCode();
+	}
+}
+
+olotExpressionMapping::~olotExpressionMapping(){
+#ifdef OLOT_EXPRESSION_MAPPING_CODE
+	if( pCode ){
+		munmap( pCode, pCodeSize );
+	}
+#endif
+}
+
+
+
+// Management
+///////////////
+
+void olotExpressionMapping::EvaluateReference( const float *inputs, float *outputs ) const{
+	std::vector<sOperation>::const_iterator iter;
+	
+	for( iter = pOperations.cbegin(); iter != pOperations.cend(); iter++ ){
+		const sOperation &operation = *iter;
+		const float * const params = operation.parameters;
+		const float a = inputs[ operation.inputs[ 0 ] ];
+		const float b = inputs[ operation.inputs[ 1 ] ];
+		const float c = inputs[ operation.inputs[ 2 ] ];
+		
+		switch( operation.operation ){
+		case eoCopy:
+			outputs[ operation.output ] = a;
+			break;
+			
+		case eoMax:
+			outputs[ operation.output ] = std::max( a, b );
+			break;
+			
+		case eoRemap:
+			outputs[ operation.output ] = Remap( a, params[ 0 ], params[ 1 ] - params[ 0 ],
+				params[ 2 ], params[ 3 ] - params[ 2 ] );
+			break;
+			
+		case eoBlend:
+			outputs[ operation.output ] = Blend( a, b, c, params[ 0 ] );
+			break;
+		}
+	}
+}
+
+std::ostream &olotExpressionMapping::log(){
+	return olotApiLayer::Get().baseLogStream()
+		<< olotApiLayer::Get().GetLayerName() << ".ExpressionMapping: ";
+}
+
+
+
+// Private Functions
+//////////////////////
+
+#ifdef OLOT_EXPRESSION_MAPPING_CODE
+
+// writes x86-64 machine code. generated functions use the System V calling convention
+// with inputs in rdi and outputs in rsi. only caller saved registers are used. scalar
+// single precision instructions round exactly like the compiled reference evaluation.
+// constants are stored after the code and addressed relative to rip
+class cCodeWriter{
+public:
+	enum eOpcode{
+		eopLoad = 0x10,
+		eopStore = 0x11,
+		eopSqrt = 0x51,
+		eopAdd = 0x58,
+		eopMul = 0x59,
+		eopSub = 0x5c,
+		eopMin = 0x5d,
+		eopDiv = 0x5e,
+		eopMax = 0x5f
+	};
+	
+	std::vector<uint8_t> code;
+	
+private:
+	struct sConstantReference{
+		int position;
+		float value;
+	};
+	
+	std::vector<sConstantReference> pConstantReferences;
+	
+	// rdi and rsi point 128 bytes past the start of the arrays. the first 64 values are
+	// then addressed using 8 bit displacements like compiled code does
+	const static int BaseOffset = 128;
+	
+public:
+	cCodeWriter(){
+		// sub rdi, -128 and sub rsi, -128
+		const uint8_t bytes[] = { 0x48, 0x83, 0xef, 0x80, 0x48, 0x83, 0xee, 0x80 };
+		code.insert( code.end(), bytes, bytes + 8 );
+	}
+	
+	/** <opcode>ss xmm[reg], [rdi + input * 4] */
+	void Input( eOpcode opcode, int reg, int input ){
+		pMemory( opcode, reg, 7, input );
+	}
+	
+	/** movss [rsi + output * 4], xmm[reg] */
+	void Output( int reg, int output ){
+		pMemory( eopStore, reg, 6, output );
+	}
+	
+	/** <opcode>ss xmm[reg], xmm[source] */
+	void Register( eOpcode opcode, int reg, int source ){
+		pInstruction( opcode, 0xc0 | reg << 3 | source );
+	}
+	
+	/** xorps xmm[reg], xmm[reg] */
+	void Zero( int reg ){
+		const uint8_t bytes[] = { 0x0f, 0x57, ( uint8_t )( 0xc0 | reg << 3 | reg ) };
+		code.insert( code.end(), bytes, bytes + 3 );
+	}
+	
+	/** <opcode>ss xmm[reg], [rip + constant] */
+	void Constant( eOpcode opcode, int reg, float value ){
+		pInstruction( opcode, reg << 3 | 5 );
+		pConstantReferences.push_back( { ( int )code.size(), value } );
+		pInt32( 0 );
+	}
+	
+	/** Return and append constants. */
+	void Finish(){
+		code.push_back( 0xc3 );
+		code.resize( ( code.size() + 3 ) & ~( size_t )3, 0xcc );
+		
+		std::vector<sConstantReference>::const_iterator iter;
+		for( iter = pConstantReferences.cbegin(); iter != pConstantReferences.cend(); iter++ ){
+			// displacement is relative to the end of the instruction which ends with it
+			const int32_t displacement = ( int32_t )code.size() - ( iter->position + 4 );
+			memcpy( code.data() + iter->position, &displacement, 4 );
+			
+			uint8_t bytes[ 4 ];
+			memcpy( bytes, &iter->value, 4 );
+			code.insert( code.end(), bytes, bytes + 4 );
+		}
+	}
+	
+private:
+	void pMemory( eOpcode opcode, int reg, int base, int index ){
+		const int displacement = index * 4 - BaseOffset;
+		if( displacement < 128 ){
+			pInstruction( opcode, 0x40 | reg << 3 | base );
+			code.push_back( ( uint8_t )( int8_t )displacement );
+			
+		}else{
+			pInstruction( opcode, 0x80 | reg << 3 | base );
+			pInt32( displacement );
+		}
+	}
+	
+	void pInstruction( eOpcode opcode, int modrm ){
+		const uint8_t bytes[] = { 0xf3, 0x0f, ( uint8_t )opcode, ( uint8_t )modrm };
+		code.insert( code.end(), bytes, bytes + 4 );
+	}
+	
+	void pInt32( int32_t value ){
+		uint8_t bytes[ 4 ];
+		memcpy( bytes, &value, 4 );
+		code.insert( code.end(), bytes, bytes + 4 );
+	}
+};
+
+// subtracting +0 does not change any value including -0 and NaN. subtracting -0 does
+static bool isPositiveZero( float value ){
+	uint32_t bits;
+	memcpy( &bits, &value, 4 );
+	return bits == 0;
+}
+
+// dividing by a power of two yields the same result as multiplying by its reciprocal
+// if both are normal numbers. multiplying by 1 does not change any value
+static bool exactReciprocal( float value, float &reciprocal ){
+	int exponent;
+	if( ! isnormal( value ) || fabsf( frexpf( value, &exponent ) ) != 0.5f ){
+		return false;
+	}
+	
+	reciprocal = 1.0f / value;
+	return isnormal( reciprocal );
+}
+
+void olotExpressionMapping::pCompileCode(){
+	cCodeWriter writer;
+	float reciprocal;
+	
+	std::vector<sOperation>::const_iterator iter;
+	for( iter = pOperations.cbegin(); iter != pOperations.cend(); iter++ ){
+		const sOperation &operation = *iter;
+		const float * const params = operation.parameters;
+		
+		switch( operation.operation ){
+		case eoCopy:
+			writer.Input( cCodeWriter::eopLoad, 0, operation.inputs[ 0 ] );
+			writer.Output( 0, operation.output );
+			break;
+			
+		case eoMax:
+			// std::max(a, b) is (a < b) ? b : a which is maxss(b, a) including NaN
+			writer.Input( cCodeWriter::eopLoad, 0, operation.inputs[ 1 ] );
+			writer.Input( cCodeWriter::eopMax, 0, operation.inputs[ 0 ] );
+			writer.Output( 0, operation.output );
+			break;
+			
+		case eoRemap:
+			// std::min(x, 1) is (1 < x) ? 1 : x which is minss(1, x). std::max(x, 0) is
+			// (x < 0) ? 0 : x which is maxss(0, x). both including NaN
+			writer.Input( cCodeWriter::eopLoad, 0, operation.inputs[ 0 ] );
+			if( ! isPositiveZero( params[ 0 ] ) ){
+				writer.Constant( cCodeWriter::eopSub, 0, params[ 0 ] );
+			}
+			
+			if( exactReciprocal( params[ 1 ] - params[ 0 ], reciprocal ) ){
+				if( reciprocal != 1.0f ){
+					writer.Constant( cCodeWriter::eopMul, 0, reciprocal );
+				}
+				
+			}else{
+				writer.Constant( cCodeWriter::eopDiv, 0, params[ 1 ] - params[ 0 ] );
+			}
+			
+			writer.Constant( cCodeWriter::eopLoad, 1, 1.0f );
+			writer.Register( cCodeWriter::eopMin, 1, 0 );
+			writer.Zero( 2 );
+			writer.Register( cCodeWriter::eopMax, 2, 1 );
+			if( params[ 3 ] - params[ 2 ] != 1.0f ){
+				writer.Constant( cCodeWriter::eopMul, 2, params[ 3 ] - params[ 2 ] );
+			}
+			writer.Constant( cCodeWriter::eopAdd, 2, params[ 2 ] );
+			writer.Output( 2, operation.output );
+			break;
+			
+		case eoBlend:
+			writer.Input( cCodeWriter::eopLoad, 0, operation.inputs[ 0 ] );
+			writer.Register( cCodeWriter::eopMul, 0, 0 );
+			writer.Input( cCodeWriter::eopLoad, 1, operation.inputs[ 1 ] );
+			writer.Register( cCodeWriter::eopMul, 1, 1 );
+			writer.Register( cCodeWriter::eopAdd, 0, 1 );
+			writer.Register( cCodeWriter::eopSqrt, 0, 0 );
+			writer.Constant( cCodeWriter::eopMul, 0, params[ 0 ] );
+			writer.Input( cCodeWriter::eopMul, 0, operation.inputs[ 2 ] );
+			writer.Output( 0, operation.output );
+			break;
+		}
+	}
+	
+	writer.Finish();
+	
+	// the code is written before the memory becomes executable. systems refusing
+	// executable memory use the reference evaluation
+	const size_t pageSize = ( size_t )sysconf( _SC_PAGESIZE );
+	const size_t size = ( writer.code.size() + pageSize - 1 ) / pageSize * pageSize;
+	
+	void * const memory = mmap( nullptr, size, PROT_READ | PROT_WRITE,
+		MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+	if( memory == MAP_FAILED ){
+		OLOTLOG_WARNING( log(), "Failed allocating code memory. Using reference evaluation" );
+		return;
+	}
+	
+	memcpy( memory, writer.code.data(), writer.code.size() );
+	
+	if( mprotect( memory, size, PROT_READ | PROT_EXEC ) ){
+		munmap( memory, size );
+		OLOTLOG_WARNING( log(), "Failed making code memory executable. Using reference evaluation" );
+		return;
+	}
+	
+	pCode = memory;
+	pCodeSize = size;
+	pFixedFunction = reinterpret_cast<FixedFunction>( memory );
+}
+
+#else
+
+void olotExpressionMapping::pCompileCode(){
+}
+
+#endif
@@ -0,0 +1,177 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _OLOTEXPRESSIONMAPPING_H_
+#define _OLOTEXPRESSIONMAPPING_H_
+
+#include <math.h>
+#include <stddef.h>
+#include <memory>
+#include <vector>
+#include <ostream>
+#include <algorithm>
+
+
+/**
+ * Table driven mapping of input values to output weights.
+ * 
+ * Mappings known at compile time can provide a fixed function evaluating the operations
+ * using constant indices. Other mappings are compiled to machine code with constant
+ * indices on x86-64 Linux at construction time. Otherwise a scalar reference evaluation
+ * processes the operations one by one in the given order.
+ * 
+ * All evaluations produce bit identical results. The equivalence test in the tests
+ * directory verifies this.
+ * 
+ * Outputs not written by any operation are left unchanged.
+ */
+class olotExpressionMapping{
+public:
+	/** Reference. */
+	typedef std::shared_ptr<olotExpressionMapping> Ref;
+	
+	/** Fixed evaluation function. */
+	typedef void (*FixedFunction)( const float *inputs, float *outputs );
+	
+	/** Operation type. */
+	enum eOperation{
+		/** output = input[0] */
+		eoCopy,
+		
+		/** output = max(input[0], input[1]) */
+		eoMax,
+		
+		/**
+		 * output = clamp((input[0] - param[0]) / (param[1] - param[0])) * (param[3] - param[2]) + param[2]
+		 * 
+		 * Clamps to the range from 0 to 1.
+		 */
+		eoRemap,
+		
+		/** output = length(input[0], input[1]) * param[0] * input[2] */
+		eoBlend
+	};
+	
+	/** Number of operation types. */
+	const static int OperationCount = eoBlend + 1;
+	
+	/** Operation. Unused inputs and parameters are ignored. */
+	struct sOperation{
+		eOperation operation;
+		int output;
+		int inputs[ 3 ];
+		float parameters[ 4 ];
+	};
+	
+	
+	
+private:
+	const int pInputCount;
+	const int pOutputCount;
+	std::vector<sOperation> pOperations;
+	FixedFunction pFixedFunction;
+	void *pCode;
+	size_t pCodeSize;
+	
+	
+	
+public:
+	/** \name Constructors and Destructors */
+	/*@{*/
+	/**
+	 * Create mapping.
+	 * 
+	 * Indices have to be in range and each output can be written by one operation only.
+	 * If fixedFunction is not nullptr it has to evaluate the same operations. Otherwise
+	 * the operations are compiled to machine code if supported.
+	 */
+	olotExpressionMapping( const sOperation *operations, int count, int inputCount,
+		int outputCount, FixedFunction fixedFunction = nullptr );
+	
+	olotExpressionMapping( const olotExpressionMapping & ) = delete;
+	olotExpressionMapping &operator=( const olotExpressionMapping & ) = delete;
+	
+	/** Clean up mapping. */
+	~olotExpressionMapping();
+	/*@}*/
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/** Input count. */
+	inline int GetInputCount() const{ return pInputCount; }
+	
+	/** Output count. */
+	inline int GetOutputCount() const{ return pOutputCount; }
+	
+	/** Fixed evaluation function, compiled machine code or nullptr. */
+	inline FixedFunction GetFixedFunction() const{ return pFixedFunction; }
+	
+	/** Operations have been compiled to machine code. */
+	inline bool GetCompiled() const{ return pCode != nullptr; }
+	
+	/**
+	 * Evaluate mapping. Uses the fixed function or compiled machine code if available
+	 * and the reference evaluation otherwise.
+	 */
+	inline void Evaluate( const float *inputs, float *outputs ) const{
+		if( pFixedFunction ){
+			pFixedFunction( inputs, outputs );
+			
+		}else{
+			EvaluateReference( inputs, outputs );
+		}
+	}
+	
+	/** Evaluate mapping using the scalar reference evaluation. */
+	void EvaluateReference( const float *inputs, float *outputs ) const;
+	
+	/** Log stream. */
+	std::ostream &log();
+	/*@}*/
+	
+	
+	
+	/** \name Operations */
+	/*@{*/
+	/** Remap operation using precalculated ranges (to - from and mapTo - mapFrom). */
+	static inline float Remap( float value, float from, float range, float mapFrom, float mapRange ){
+		return std::max( std::min( ( value - from ) / range, 1.0f ), 0.0f ) * mapRange + mapFrom;
+	}
+	
+	/** Blend operation. */
+	static inline float Blend( float x, float y, float factor, float scale ){
+		return sqrtf( x * x + y * y ) * scale * factor;
+	}
+	/*@}*/
+	
+	
+	
+private:
+	void pCompileCode();
+};
+
+#endif
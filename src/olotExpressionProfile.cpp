@@ -0,0 +1,420 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include "olotExpressionProfile.h"
+#include "olotOcsAddressMap.h"
+#include "olotOcsClient.h"
+#include "olotApiLayer.h"
+#include "openxr/openxr_reflection.h"
+
+
+// Mapping tables
+///////////////////
+
+/*
+the built-in mapping tables are defined once as lists. they are expanded into operation
+tables and into fixed functions evaluating the operations using constant indices
+*/
+
+/*
+eye expressions not mapped:
+- XR_EYE_EXPRESSION_LEFT_SQUEEZE_HTC and XR_EYE_EXPRESSION_RIGHT_SQUEEZE_HTC. always 0
+- there is no explicit value mapping to the eye down, up, left and right values
+*/
+#define OLOT_MAPPING_EYE( COPY, MAX, REMAP, BLEND ) \
+	REMAP( XR_EYE_EXPRESSION_RIGHT_BLINK_HTC, eeRightEyeLidExpandedSqueeze, 0.0f, 0.75f, 0.0f, 1.0f ) \
+	REMAP( XR_EYE_EXPRESSION_LEFT_BLINK_HTC, eeLeftEyeLidExpandedSqueeze, 0.0f, 0.75f, 0.0f, 1.0f ) \
+	\
+	REMAP( XR_EYE_EXPRESSION_RIGHT_WIDE_HTC, eeRightEyeLidExpandedSqueeze, 0.75f, 1.0f, 0.0f, 1.0f ) \
+	REMAP( XR_EYE_EXPRESSION_LEFT_WIDE_HTC, eeLeftEyeLidExpandedSqueeze, 0.75f, 1.0f, 0.0f, 1.0f )
+
+/*
+ocs values not mapped:
+- olotOcsClient::eeNoseSneerLeft
+- olotOcsClient::eeNoseSneerRight
+- olotOcsClient::eeMouthShrugUpper
+- olotOcsClient::eeMouthDimpleLeft
+- olotOcsClient::eeMouthDimpleRight
+- olotOcsClient::eeMouthPressLeft
+- olotOcsClient::eeMouthPressRight
+- olotOcsClient::eeMouthStretchLeft
+- olotOcsClient::eeMouthStretchRight
+- olotOcsClient::eeTongueBendDown
+- olotOcsClient::eeTongueCurlUp
+- olotOcsClient::eeTongueSquish
+- olotOcsClient::eeTongueFlat
+- olotOcsClient::eeTongueTwistLeft
+- olotOcsClient::eeTongueTwistRight
+*/
+#define OLOT_MAPPING_LIP( COPY, MAX, REMAP, BLEND ) \
+	COPY( XR_LIP_EXPRESSION_JAW_RIGHT_HTC, eeJawRight ) \
+	COPY( XR_LIP_EXPRESSION_JAW_LEFT_HTC, eeJawLeft ) \
+	COPY( XR_LIP_EXPRESSION_JAW_FORWARD_HTC, eeJawForward ) \
+	COPY( XR_LIP_EXPRESSION_JAW_OPEN_HTC, eeJawOpen ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_POUT_HTC, eeMouthPucker ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_SMILE_RIGHT_HTC, eeMouthSmileRight ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_SMILE_LEFT_HTC, eeMouthSmileLeft ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_SAD_RIGHT_HTC, eeMouthFrownRight ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_SAD_LEFT_HTC, eeMouthFrownLeft ) \
+	COPY( XR_LIP_EXPRESSION_CHEEK_PUFF_RIGHT_HTC, eeCheekPuffRight ) \
+	COPY( XR_LIP_EXPRESSION_CHEEK_PUFF_LEFT_HTC, eeCheekPuffLeft ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_UPPER_UPRIGHT_HTC, eeMouthUpperUpRight ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_UPPER_UPLEFT_HTC, eeMouthUpperUpLeft ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_LOWER_DOWNRIGHT_HTC, eeMouthLowerDownRight ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_LOWER_DOWNLEFT_HTC, eeMouthLowerDownLeft ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_UPPER_INSIDE_HTC, eeMouthRollUpper ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_LOWER_INSIDE_HTC, eeMouthRollLower ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_LOWER_OVERLAY_HTC, eeMouthShrugLower ) \
+	COPY( XR_LIP_EXPRESSION_TONGUE_LEFT_HTC, eeTongueLeft ) \
+	COPY( XR_LIP_EXPRESSION_TONGUE_RIGHT_HTC, eeTongueRight ) \
+	COPY( XR_LIP_EXPRESSION_TONGUE_UP_HTC, eeTongueUp ) \
+	COPY( XR_LIP_EXPRESSION_TONGUE_DOWN_HTC, eeTongueDown ) \
+	COPY( XR_LIP_EXPRESSION_TONGUE_ROLL_HTC, eeTongueRoll ) \
+	\
+	COPY( XR_LIP_EXPRESSION_MOUTH_APE_SHAPE_HTC, eeMouthClose ) \
+	\
+	COPY( XR_LIP_EXPRESSION_MOUTH_UPPER_RIGHT_HTC, eeMouthRight ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_UPPER_LEFT_HTC, eeMouthLeft ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_LOWER_RIGHT_HTC, eeMouthRight ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_LOWER_LEFT_HTC, eeMouthLeft ) \
+	\
+	COPY( XR_LIP_EXPRESSION_MOUTH_UPPER_OVERTURN_HTC, eeMouthFunnel ) \
+	COPY( XR_LIP_EXPRESSION_MOUTH_LOWER_OVERTURN_HTC, eeMouthFunnel ) \
+	\
+	MAX( XR_LIP_EXPRESSION_CHEEK_SUCK_HTC, eeCheekSuckRight, eeCheekSuckLeft ) \
+	\
+	REMAP( XR_LIP_EXPRESSION_TONGUE_LONGSTEP1_HTC, eeTongueOut, 0.0f, 0.5f, 0.0f, 1.0f ) \
+	REMAP( XR_LIP_EXPRESSION_TONGUE_LONGSTEP2_HTC, eeTongueOut, 0.5f, 1.0f, 0.0f, 1.0f ) \
+	\
+	BLEND( XR_LIP_EXPRESSION_TONGUE_UPRIGHT_MORPH_HTC, eeTongueUp, eeTongueRight, eeTongueOut ) \
+	BLEND( XR_LIP_EXPRESSION_TONGUE_UPLEFT_MORPH_HTC, eeTongueUp, eeTongueLeft, eeTongueOut ) \
+	BLEND( XR_LIP_EXPRESSION_TONGUE_DOWNRIGHT_MORPH_HTC, eeTongueDown, eeTongueRight, eeTongueOut ) \
+	BLEND( XR_LIP_EXPRESSION_TONGUE_DOWNLEFT_MORPH_HTC, eeTongueDown, eeTongueLeft, eeTongueOut )
+
+static const float invSqrt2 = 1.0f / sqrtf( 2.0f );
+
+#define OLOT_COPY( output, input ) \
+	{ olotExpressionMapping::eoCopy, output, { olotOcsClient::input, 0, 0 }, { 0.0f, 0.0f, 0.0f, 0.0f } },
+
+#define OLOT_MAX( output, input1, input2 ) \
+	{ olotExpressionMapping::eoMax, output, { olotOcsClient::input1, olotOcsClient::input2, 0 }, \
+		{ 0.0f, 0.0f, 0.0f, 0.0f } },
+
+#define OLOT_REMAP( output, input, from, to, mapFrom, mapTo ) \
+	{ olotExpressionMapping::eoRemap, output, { olotOcsClient::input, 0, 0 }, { from, to, mapFrom, mapTo } },
+
+#define OLOT_BLEND( output, input1, input2, input3 ) \
+	{ olotExpressionMapping::eoBlend, output, { olotOcsClient::input1, olotOcsClient::input2, \
+		olotOcsClient::input3 }, { invSqrt2, 0.0f, 0.0f, 0.0f } },
+
+static const olotExpressionMapping::sOperation vMappingEye[] = {
+	OLOT_MAPPING_EYE( OLOT_COPY, OLOT_MAX, OLOT_REMAP, OLOT_BLEND )
+};
+
+static const olotExpressionMapping::sOperation vMappingLip[] = {
+	OLOT_MAPPING_LIP( OLOT_COPY, OLOT_MAX, OLOT_REMAP, OLOT_BLEND )
+};
+
+#undef OLOT_COPY
+#undef OLOT_MAX
+#undef OLOT_REMAP
+#undef OLOT_BLEND
+
+// same calculations as olotExpressionMapping::EvaluateReference(). ranges are constant
+#define OLOT_COPY( output, input ) \
+	outputs[ output ] = inputs[ olotOcsClient::input ];
+
+#define OLOT_MAX( output, input1, input2 ) \
+	outputs[ output ] = std::max( inputs[ olotOcsClient::input1 ], inputs[ olotOcsClient::input2 ] );
+
+#define OLOT_REMAP( output, input, from, to, mapFrom, mapTo ) \
+	outputs[ output ] = olotExpressionMapping::Remap( inputs[ olotOcsClient::input ], \
+		from, to - from, mapFrom, mapTo - mapFrom );
+
+#define OLOT_BLEND( output, input1, input2, input3 ) \
+	outputs[ output ] = olotExpressionMapping::Blend( inputs[ olotOcsClient::input1 ], \
+		inputs[ olotOcsClient::input2 ], inputs[ olotOcsClient::input3 ], invSqrt2 );
+
+static void evaluateBuiltinEye( const float *inputs, float *outputs ){
+	OLOT_MAPPING_EYE( OLOT_COPY, OLOT_MAX, OLOT_REMAP, OLOT_BLEND )
+}
+
+static void evaluateBuiltinLip( const float *inputs, float *outputs ){
+	OLOT_MAPPING_LIP( OLOT_COPY, OLOT_MAX, OLOT_REMAP, OLOT_BLEND )
+}
+
+#undef OLOT_COPY
+#undef OLOT_MAX
+#undef OLOT_REMAP
+#undef OLOT_BLEND
+
+#undef OLOT_MAPPING_EYE
+#undef OLOT_MAPPING_LIP
+
+
+// Expression names
+/////////////////////
+
+struct sExpressionName{
+	const char *name;
+	int value;
+};
+
+#define OLOT_EXPRESSION_NAME( name, value ) { #name, value },
+
+static const sExpressionName vNamesEye[] = {
+	XR_LIST_ENUM_XrEyeExpressionHTC( OLOT_EXPRESSION_NAME )
+};
+
+static const sExpressionName vNamesLip[] = {
+	XR_LIST_ENUM_XrLipExpressionHTC( OLOT_EXPRESSION_NAME )
+};
+
+#undef OLOT_EXPRESSION_NAME
+
+static bool findExpression( const sExpressionName *names, int nameCount, int expressionCount,
+const std::string &name, int &value ){
+	int i;
+	for( i=0; i<nameCount; i++ ){
+		if( names[ i ].value < expressionCount && name == names[ i ].name ){
+			value = names[ i ].value;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool parseInput( const std::string &name, int &input ){
+	const std::string address( "/" + name );
+	const olotOcsAddressMap::sChannel * const channel =
+		olotOcsAddressMap::Find( address.c_str(), address.size() );
+	if( ! channel || channel->type != olotOcsAddressMap::ectExpression ){
+		return false;
+	}
+	
+	input = channel->index;
+	return true;
+}
+
+static bool parseFloat( const std::string &text, float &value ){
+	char *end = nullptr;
+	value = strtof( text.c_str(), &end );
+	return end != text.c_str() && *end == 0 && isfinite( value );
+}
+
+
+
+// class olotExpressionProfile
+////////////////////////////////
+
+olotExpressionProfile::olotExpressionProfile() :
+pEyeOperations( vMappingEye, vMappingEye + sizeof( vMappingEye ) / sizeof( vMappingEye[ 0 ] ) ),
+pLipOperations( vMappingLip, vMappingLip + sizeof( vMappingLip ) / sizeof( vMappingLip[ 0 ] ) ),
+pEyeModified( false ),
+pLipModified( false ){
+}
+
+olotExpressionProfile::~olotExpressionProfile(){
+}
+
+
+
+// Management
+///////////////
+
+bool olotExpressionProfile::LoadFromFile( const std::string &path ){
+	std::ifstream stream( path );
+	if( ! stream.is_open() ){
+		OLOTLOG_WARNING( log(), "Failed reading profile '" << path << "'" );
+		return false;
+	}
+	
+	std::string line;
+	int lineNumber = 0;
+	int invalidCount = 0;
+	
+	while( std::getline( stream, line ) ){
+		lineNumber++;
+		
+		if( ! pParseLine( line ) ){
+			invalidCount++;
+			
+			OLOTLOG_WARNING( log(), "Invalid line " << lineNumber << " in profile '" << path << "': " << line );
+		}
+	}
+	
+	OLOTLOG_INFO( log(), "Loaded profile '" << path << "' (" << invalidCount << " invalid lines)" );
+	return true;
+}
+
+olotExpressionMapping::Ref olotExpressionProfile::CompileEyeMapping() const{
+	return olotExpressionMapping::Ref( new olotExpressionMapping( pEyeOperations.data(),
+		( int )pEyeOperations.size(), olotOcsClient::ExpressionCount,
+		XR_FACIAL_EXPRESSION_EYE_COUNT_HTC, pEyeModified ? nullptr : evaluateBuiltinEye ) );
+}
+
+olotExpressionMapping::Ref olotExpressionProfile::CompileLipMapping() const{
+	return olotExpressionMapping::Ref( new olotExpressionMapping( pLipOperations.data(),
+		( int )pLipOperations.size(), olotOcsClient::ExpressionCount,
+		XR_FACIAL_EXPRESSION_LIP_COUNT_HTC, pLipModified ? nullptr : evaluateBuiltinLip ) );
+}
+
+std::ostream &olotExpressionProfile::log(){
+	return olotApiLayer::Get().baseLogStream()
+		<< olotApiLayer::Get().GetLayerName() << ".ExpressionProfile: ";
+}
+
+
+
+// Private Functions
+//////////////////////
+
+bool olotExpressionProfile::pParseLine( const std::string &line ){
+	std::stringstream stream( line.substr( 0, line.find( '#' ) ) );
+	std::vector<std::string> tokens;
+	std::string token;
+	
+	while( stream >> token ){
+		tokens.push_back( token );
+	}
+	
+	if( tokens.empty() ){
+		return true;
+	}
+	if( tokens.size() < 3 || tokens[ 1 ] != "=" ){
+		return false;
+	}
+	
+	ListOperations *operations = nullptr;
+	bool *modified = nullptr;
+	int output;
+	
+	if( findExpression( vNamesEye, sizeof( vNamesEye ) / sizeof( vNamesEye[ 0 ] ),
+			XR_FACIAL_EXPRESSION_EYE_COUNT_HTC, tokens[ 0 ], output ) ){
+		operations = &pEyeOperations;
+		modified = &pEyeModified;
+		
+	}else if( findExpression( vNamesLip, sizeof( vNamesLip ) / sizeof( vNamesLip[ 0 ] ),
+			XR_FACIAL_EXPRESSION_LIP_COUNT_HTC, tokens[ 0 ], output ) ){
+		operations = &pLipOperations;
+		modified = &pLipModified;
+		
+	}else{
+		return false;
+	}
+	
+	const std::string &type = tokens[ 2 ];
+	const int argumentCount = ( int )tokens.size() - 3;
+	olotExpressionMapping::sOperation operation = {};
+	operation.output = output;
+	
+	if( type == "none" ){
+		if( argumentCount != 0 ){
+			return false;
+		}
+		pSetOperation( *operations, output, nullptr );
+		*modified = true;
+		return true;
+		
+	}else if( type == "copy" ){
+		operation.operation = olotExpressionMapping::eoCopy;
+		if( argumentCount != 1 || ! parseInput( tokens[ 3 ], operation.inputs[ 0 ] ) ){
+			return false;
+		}
+		
+	}else if( type == "max" ){
+		operation.operation = olotExpressionMapping::eoMax;
+		if( argumentCount != 2
+		|| ! parseInput( tokens[ 3 ], operation.inputs[ 0 ] )
+		|| ! parseInput( tokens[ 4 ], operation.inputs[ 1 ] ) ){
+			return false;
+		}
+		
+	}else if( type == "remap" ){
+		operation.operation = olotExpressionMapping::eoRemap;
+		operation.parameters[ 2 ] = 0.0f;
+		operation.parameters[ 3 ] = 1.0f;
+		if( ( argumentCount != 3 && argumentCount != 5 )
+		|| ! parseInput( tokens[ 3 ], operation.inputs[ 0 ] )
+		|| ! parseFloat( tokens[ 4 ], operation.parameters[ 0 ] )
+		|| ! parseFloat( tokens[ 5 ], operation.parameters[ 1 ] )
+		|| operation.parameters[ 0 ] == operation.parameters[ 1 ] ){
+			return false;
+		}
+		if( argumentCount == 5 && ( ! parseFloat( tokens[ 6 ], operation.parameters[ 2 ] )
+		|| ! parseFloat( tokens[ 7 ], operation.parameters[ 3 ] ) ) ){
+			return false;
+		}
+		
+	}else if( type == "blend" ){
+		operation.operation = olotExpressionMapping::eoBlend;
+		operation.parameters[ 0 ] = invSqrt2;
+		if( ( argumentCount != 3 && argumentCount != 4 )
+		|| ! parseInput( tokens[ 3 ], operation.inputs[ 0 ] )
+		|| ! parseInput( tokens[ 4 ], operation.inputs[ 1 ] )
+		|| ! parseInput( tokens[ 5 ], operation.inputs[ 2 ] ) ){
+			return false;
+		}
+		if( argumentCount == 4 && ! parseFloat( tokens[ 6 ], operation.parameters[ 0 ] ) ){
+			return false;
+		}
+		
+	}else{
+		return false;
+	}
+	
+	pSetOperation( *operations, output, &operation );
+	*modified = true;
+	return true;
+}
+
+void olotExpressionProfile::pSetOperation( ListOperations &operations, int output,
+const olotExpressionMapping::sOperation *operation ){
+	ListOperations::iterator iter;
+	for( iter = operations.begin(); iter != operations.end(); iter++ ){
+		if( iter->output == output ){
+			break;
+		}
+	}
+	
+	if( operation ){
+		if( iter != operations.end() ){
+			*iter = *operation;
+			
+		}else{
+			operations.push_back( *operation );
+		}
+		
+	}else if( iter != operations.end() ){
+		operations.erase( iter );
+	}
+}
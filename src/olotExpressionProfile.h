@@ -0,0 +1,117 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _OLOTEXPRESSIONPROFILE_H_
+#define _OLOTEXPRESSIONPROFILE_H_
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+#include "olotExpressionMapping.h"
+
+
+/**
+ * Expression remapping profile.
+ * 
+ * Defines the operations mapping OCS expressions to HTC eye and lip expressions. Starts
+ * with the built-in mapping. Loading a profile file replaces the operations of the
+ * expressions listed in the file. Each line has the form:
+ * 
+ * \code
+ * <expression> = copy <input>
+ * <expression> = max <input> <input>
+ * <expression> = remap <input> <from> <to> [<mapFrom> <mapTo>]
+ * <expression> = blend <input> <input> <input> [<scale>]
+ * <expression> = none
+ * \endcode
+ * 
+ * Expression is the name of an XrEyeExpressionHTC or XrLipExpressionHTC value, for example
+ * XR_LIP_EXPRESSION_JAW_OPEN_HTC. Input is the name of an OCS expression without leading
+ * slash, for example jawOpen. Remap maps from/to to mapFrom/mapTo which default to 0 and 1.
+ * Blend scale defaults to 1/sqrt(2). None leaves the expression at 0. Text after '#' is
+ * ignored. Invalid lines are logged and ignored.
+ * 
+ * Mappings not modified by a profile file evaluate the built-in mapping using fixed
+ * functions with constant indices. Modified mappings are compiled to machine code on
+ * x86-64 Linux.
+ */
+class olotExpressionProfile{
+public:
+	/** Operation list. */
+	typedef std::vector<olotExpressionMapping::sOperation> ListOperations;
+	
+	
+	
+private:
+	ListOperations pEyeOperations;
+	ListOperations pLipOperations;
+	bool pEyeModified;
+	bool pLipModified;
+	
+	
+	
+public:
+	/** \name Constructors and Destructors */
+	/*@{*/
+	/** Create profile with built-in mapping. */
+	olotExpressionProfile();
+	
+	/** Clean up profile. */
+	~olotExpressionProfile();
+	/*@}*/
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/** Eye expression operations. */
+	inline const ListOperations &GetEyeOperations() const{ return pEyeOperations; }
+	
+	/** Lip expression operations. */
+	inline const ListOperations &GetLipOperations() const{ return pLipOperations; }
+	
+	/** Load profile file. Returns false if the file can not be read. */
+	bool LoadFromFile( const std::string &path );
+	
+	/** Compile eye expression mapping. */
+	olotExpressionMapping::Ref CompileEyeMapping() const;
+	
+	/** Compile lip expression mapping. */
+	olotExpressionMapping::Ref CompileLipMapping() const;
+	
+	/** Log stream. */
+	std::ostream &log();
+	/*@}*/
+	
+	
+	
+private:
+	bool pParseLine( const std::string &line );
+	static void pSetOperation( ListOperations &operations, int output,
+		const olotExpressionMapping::sOperation *operation );
+};
+
+#endif
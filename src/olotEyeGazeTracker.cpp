@@ -24,6 +24,7 @@
 
 #include <string.h>
 #include <math.h>
+#include <algorithm>
 
 #include "olotEyeGazeTracker.h"
 #include "olotInstance.h"
@@ -32,6 +33,7 @@
 #include "olotOcsClient.h"
 #include "math/olotQuaternion.h"
 #include "exceptions/exceptions.h"
+#include "utils/olotClock.h"
 
 
 // class olotEyeGazeTracker
@@ -40,17 +42,20 @@
 olotEyeGazeTracker::olotEyeGazeTracker( olotInstance &instance ) :
 pInstance( instance ),
 pPathPose( XR_NULL_PATH ),
+pPathEyes( XR_NULL_PATH ),
+pBoundActions( MinBoundActionSlots, sBoundAction{ XR_NULL_HANDLE, XR_NULL_PATH } ),
+pBoundActionMask( ( uint32_t )MinBoundActionSlots - 1 ),
+pLastHit( 0 ),
 pActive( false ),
+pPredictionLimit( ( int64_t )olotApiLayer::Get().GetConfig().GetGazePredictionLimit() * 1000000 ),
 pOcsClient( nullptr ),
 pEyeEngineStarted( false )
 {
-	int i;
-	for( i=0; i<olotOcsClient::EyeStateCount; i++ ){
-		pOcsValues[ i ] = 0.0f;
-	}
+	olotExpressionFrame::Clear( pFrame );
 	
 	try{
 		pPathPose = instance.GetXrPathFor( "/user/eyes_ext/input/gaze_ext/pose" );
+		pPathEyes = instance.GetXrPathFor( "/user/eyes_ext" );
 		
 		memset( &pPose, 0, sizeof( pPose ) );
 		pPose.orientation.w = 1.0f;
@@ -73,23 +78,42 @@ olotEyeGazeTracker::~olotEyeGazeTracker(){
 // Management
 ///////////////
 
-bool olotEyeGazeTracker::Matches( XrAction action, XrPath /*subactionPath*/ ) const{
-	ListActions::const_iterator iter;
-	for( iter = pActions.cbegin(); iter != pActions.cend(); iter++ ){
-		if( *iter == action ){
-			// TODO check subactionPath
+static inline uint32_t hashBoundAction( XrAction action, XrPath subactionPath ){
+	const uint64_t key = ( ( uint64_t )action ^ ( subactionPath * 0xff51afd7ed558ccdULL ) )
+		* 0x9e3779b97f4a7c15ULL;
+	return ( uint32_t )( key >> 32 );
+}
+
+bool olotEyeGazeTracker::Matches( XrAction action, XrPath subactionPath ) const{
+	if( action == XR_NULL_HANDLE ){
+		return false;
+	}
+	
+	// applications usually query the same action multiple times in a row
+	const sBoundAction &last = pBoundActions[ pLastHit.load( std::memory_order_relaxed ) ];
+	if( last.action == action && last.subactionPath == subactionPath ){
+		return true;
+	}
+	
+	// the set is at most half full hence probing always ends at an unused slot
+	uint32_t index = hashBoundAction( action, subactionPath ) & pBoundActionMask;
+	
+	while( true ){
+		const sBoundAction &entry = pBoundActions[ index ];
+		if( entry.action == action && entry.subactionPath == subactionPath ){
+			pLastHit.store( index, std::memory_order_relaxed );
 			return true;
 		}
+		if( entry.action == XR_NULL_HANDLE ){
+			return false;
+		}
+		index = ( index + 1 ) & pBoundActionMask;
 	}
-	return false;
 }
 
 XrResult olotEyeGazeTracker::SuggestInteractionProfileBindings(
 const XrInteractionProfileSuggestedBinding &suggestedBindings ){
-	{
-	const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-	log() << "SuggestInteractionProfileBindings" << std::endl;
-	}
+	OLOTLOG_TRACE( log(), "SuggestInteractionProfileBindings" );
 	
 	// validate
 	if( suggestedBindings.countSuggestedBindings > 0 ){
@@ -101,10 +125,23 @@ const XrInteractionProfileSuggestedBinding &suggestedBindings ){
 		OLOTASSERT_TRUE( suggestedBindings.suggestedBindings[ i ].binding == pPathPose, XR_ERROR_VALIDATION_FAILURE )
 	}
 	
-	// clear
-	pActions.clear();
+	// clear. each bound action is added without subaction path and with the eyes subaction
+	// path. the set only grows if the bindings do not fit while keeping it at most half full
+	size_t slotCount = pBoundActions.size();
+	while( slotCount < ( size_t )suggestedBindings.countSuggestedBindings * 4 ){
+		slotCount <<= 1;
+	}
+	
+	if( slotCount != pBoundActions.size() ){
+		pBoundActions.resize( slotCount );
+	}
+	std::fill( pBoundActions.begin(), pBoundActions.end(), sBoundAction{ XR_NULL_HANDLE, XR_NULL_PATH } );
+	pBoundActionMask = ( uint32_t )slotCount - 1;
+	pLastHit.store( 0, std::memory_order_relaxed );
+	
 	for( i=0; i<suggestedBindings.countSuggestedBindings; i++ ){
-		pActions.push_back( suggestedBindings.suggestedBindings[ i ].action );
+		pAddBoundAction( suggestedBindings.suggestedBindings[ i ].action, XR_NULL_PATH );
+		pAddBoundAction( suggestedBindings.suggestedBindings[ i ].action, pPathEyes );
 	}
 	
 	return XR_SUCCESS;
@@ -125,18 +162,17 @@ static inline float linearStep( float value, float from, float to, float mapFrom
 static const float onePi = 3.14159265f / 180.0f;
 
 XrResult olotEyeGazeTracker::GetActionStatePose( XrActionStatePose &state ){
-	try{
-		pOcsClient->GetEyeStateValues( pOcsValues, olotOcsClient::EyeStateCount );
-		
-		const float eyeRightX = pOcsValues[ olotOcsClient::eesRightEyeX ];
-		const float eyeLeftX = pOcsValues[ olotOcsClient::eesLeftEyeX ];
-		const float eyesY = pOcsValues[ olotOcsClient::eesEyesY ];
-		
-		const float maxRotX = onePi * 45.0f;
-		const float maxRotY = onePi * 30.0f;
+	// pose only changes if new values have been published since the last call
+	const uint32_t version = pFrame.version;
+	pInstance.GetExpressionFrame( pFrame );
+	
+	if( pFrame.version != version ){
+		if( pFrame.time != 0 ){
+			pOcsClient->GetLatencyEyeGaze().Record( olotClock::Now() - pFrame.time );
+		}
 		
-		const float rotHorz = linearStep( ( eyeRightX + eyeLeftX ) / 2.0f, -1.0f, 1.0f, maxRotX, -maxRotX );
-		const float rotVert = linearStep( eyesY, -1.0f, 1.0f, -maxRotY, maxRotY );
+		const float rotHorz = pFrame.gazeHorizontal;
+		const float rotVert = pFrame.gazeVertical;
 		
 		// store position. since we do not know the origin we assume 0
 		// x: positive to the right
@@ -154,13 +190,10 @@ XrResult olotEyeGazeTracker::GetActionStatePose( XrActionStatePose &state ){
 		pPose.orientation.y = orientation.y;
 		pPose.orientation.z = orientation.z;
 		pPose.orientation.w = orientation.w;
-		
-		pActive = true;
-		
-	}catch( const olotException & ){
-		pActive = false;
 	}
 	
+	pActive = pFrame.version != 0;
+	
 	state.type = XR_TYPE_ACTION_STATE_POSE;
 	state.next = nullptr;
 	state.isActive = pActive ? XR_TRUE : XR_FALSE;
@@ -169,11 +202,15 @@ XrResult olotEyeGazeTracker::GetActionStatePose( XrActionStatePose &state ){
 }
 
 XrResult olotEyeGazeTracker::LocateSpace( const olotSpace &space,
-XrSpace /*baseSpace*/, XrTime /*time*/, XrSpaceLocation *location ){
+XrSpace /*baseSpace*/, XrTime time, XrSpaceLocation *location ){
 	location->locationFlags = 0;
 	
+	XrVector3f angularVelocity = { 0.0f, 0.0f, 0.0f };
+	
 	if( pActive ){
 		location->pose = pPose;
+		pPredict( pInstance.XrTimeToMonotonic( time ), location->pose, angularVelocity );
+		
 		location->locationFlags = XR_SPACE_LOCATION_POSITION_VALID_BIT
 			| XR_SPACE_LOCATION_POSITION_TRACKED_BIT
 			| XR_SPACE_LOCATION_ORIENTATION_VALID_BIT
@@ -196,7 +233,7 @@ XrSpace /*baseSpace*/, XrTime /*time*/, XrSpaceLocation *location ){
 			
 			if( pActive ){
 				sv.linearVelocity = { 0.0f, 0.0f, 0.0f };
-				sv.angularVelocity = { 0.0f, 0.0f, 0.0f };
+				sv.angularVelocity = angularVelocity;
 				sv.velocityFlags = XR_SPACE_VELOCITY_LINEAR_VALID_BIT
 					| XR_SPACE_VELOCITY_ANGULAR_VALID_BIT;
 			}
@@ -212,6 +249,18 @@ XrSpace /*baseSpace*/, XrTime /*time*/, XrSpaceLocation *location ){
 	return XR_SUCCESS;
 }
 
+void olotEyeGazeTracker::CalcAngles( const float *eyeStates, float &rotHorz, float &rotVert ){
+	const float eyeRightX = eyeStates[ olotOcsClient::eesRightEyeX ];
+	const float eyeLeftX = eyeStates[ olotOcsClient::eesLeftEyeX ];
+	const float eyesY = eyeStates[ olotOcsClient::eesEyesY ];
+	
+	const float maxRotX = onePi * 45.0f;
+	const float maxRotY = onePi * 30.0f;
+	
+	rotHorz = linearStep( ( eyeRightX + eyeLeftX ) / 2.0f, -1.0f, 1.0f, maxRotX, -maxRotX );
+	rotVert = linearStep( eyesY, -1.0f, 1.0f, -maxRotY, maxRotY );
+}
+
 std::ostream &olotEyeGazeTracker::log(){
 	return olotApiLayer::Get().baseLogStream() << olotApiLayer::Get().GetLayerName()
 		<< ".Instance[" << pInstance.GetId() << "].EyeGazeTracker: ";
@@ -227,3 +276,59 @@ void olotEyeGazeTracker::pCleanUp(){
 		pOcsClient->RemoveUsage();
 	}
 }
+
+void olotEyeGazeTracker::pAddBoundAction( XrAction action, XrPath subactionPath ){
+	if( action == XR_NULL_HANDLE ){
+		return;
+	}
+	
+	uint32_t index = hashBoundAction( action, subactionPath ) & pBoundActionMask;
+	
+	while( pBoundActions[ index ].action != XR_NULL_HANDLE ){
+		const sBoundAction &entry = pBoundActions[ index ];
+		if( entry.action == action && entry.subactionPath == subactionPath ){
+			return;
+		}
+		index = ( index + 1 ) & pBoundActionMask;
+	}
+	
+	pBoundActions[ index ].action = action;
+	pBoundActions[ index ].subactionPath = subactionPath;
+}
+
+bool olotEyeGazeTracker::pPredict( int64_t time, XrPosef &pose, XrVector3f &angularVelocity ) const{
+	// predicts from the same expression frame GetActionStatePose built the pose from
+	if( pFrame.gazeTime == 0 ){
+		return false;
+	}
+	
+	// extrapolate to later times but not further than the prediction limit. samples from a
+	// tracker which stopped sending are not extrapolated at all. earlier times interpolate
+	// along the velocity window the angular velocity has been measured over
+	const int64_t age = time - pFrame.gazeTime;
+	float velocityHorz = pFrame.gazeVelocityHorizontal;
+	float velocityVert = pFrame.gazeVelocityVertical;
+	
+	if( age > StaleTime ){
+		velocityHorz = 0.0f;
+		velocityVert = 0.0f;
+	}
+	
+	const float aheadSeconds = ( float )std::min( std::max( age, -VelocityWindow ), pPredictionLimit ) * 1e-9f;
+	const float maxRotX = onePi * 45.0f;
+	const float maxRotY = onePi * 30.0f;
+	
+	const float rotHorz = std::max( std::min( pFrame.gazeHorizontal + velocityHorz * aheadSeconds, maxRotX ), -maxRotX );
+	const float rotVert = std::max( std::min( pFrame.gazeVertical + velocityVert * aheadSeconds, maxRotY ), -maxRotY );
+	
+	const olotQuaternion orientation( olotQuaternion::CreateFromEuler( rotVert, rotHorz, 0.0f ) );
+	pose.orientation.x = orientation.x;
+	pose.orientation.y = orientation.y;
+	pose.orientation.z = orientation.z;
+	pose.orientation.w = orientation.w;
+	
+	angularVelocity.x = velocityVert;
+	angularVelocity.y = velocityHorz;
+	angularVelocity.z = 0.0f;
+	return true;
+}
@@ -27,9 +27,11 @@
 
 #include <memory>
 #include <vector>
+#include <atomic>
 
 #include "openxr/openxr.h"
 #include "olotOcsClient.h"
+#include "olotExpressionFrame.h"
 #include "olotStructs.h"
 
 class olotInstance;
@@ -43,8 +45,23 @@ public:
 	/** Reference. */
 	typedef std::shared_ptr<olotEyeGazeTracker> Ref;
 	
-	/** Action list. */
-	typedef std::vector<XrAction> ListActions;
+	/** Bound action and subaction path. Unused slots have action XR_NULL_HANDLE. */
+	struct sBoundAction{
+		XrAction action;
+		XrPath subactionPath;
+	};
+	
+	/** Open addressing set of bound actions. Size is a power of two. */
+	typedef std::vector<sBoundAction> ListBoundActions;
+	
+	/** Minimum number of bound action slots. */
+	const static int MinBoundActionSlots = 16;
+	
+	/** Time in nanoseconds over which the angular velocity is measured. */
+	const static int64_t VelocityWindow = 25000000;
+	
+	/** Time in nanoseconds after which samples are too old to predict from. */
+	const static int64_t StaleTime = 250000000;
 	
 	
 	
@@ -52,12 +69,16 @@ private:
 	olotInstance &pInstance;
 	
 	XrPath pPathPose;
-	ListActions pActions;
+	XrPath pPathEyes;
+	ListBoundActions pBoundActions;
+	uint32_t pBoundActionMask;
+	mutable std::atomic<uint32_t> pLastHit;
 	
-	float pOcsValues[ olotOcsClient::EyeStateCount ];
+	olotExpressionFrame::sFrame pFrame;
 	
 	bool pActive;
 	XrPosef pPose;
+	int64_t pPredictionLimit;
 	
 	olotOcsClient *pOcsClient;
 	bool pEyeEngineStarted;
@@ -84,7 +105,11 @@ public:
 	/** Pose path. */
 	inline XrPath GetPathPose() const{ return pPathPose; }
 	
-	/** Matches action. */
+	/**
+	 * Action with subaction path is bound to eye gaze.
+	 * 
+	 * Subaction path can be XR_NULL_PATH or "/user/eyes_ext". Constant time.
+	 */
 	bool Matches( XrAction action, XrPath subactionPath ) const;
 	
 	/** xrSuggestInteractionProfileBindings. */
@@ -98,6 +123,9 @@ public:
 	XrResult LocateSpace( const olotSpace &space, XrSpace baseSpace,
 		XrTime time, XrSpaceLocation *location );
 	
+	/** Horizontal and vertical gaze rotation in radians from eye states. */
+	static void CalcAngles( const float *eyeStates, float &rotHorz, float &rotVert );
+	
 	/** Log stream. */
 	std::ostream &log();
 	/*@}*/
@@ -106,6 +134,8 @@ public:
 	
 private:
 	void pCleanUp();
+	void pAddBoundAction( XrAction action, XrPath subactionPath );
+	bool pPredict( int64_t time, XrPosef &pose, XrVector3f &angularVelocity ) const;
 };
 
 #endif
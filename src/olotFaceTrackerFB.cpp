@@ -0,0 +1,125 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <string.h>
+
+#include "olotFaceTrackerFB.h"
+#include "olotInstance.h"
+#include "olotApiLayer.h"
+#include "olotOcsClient.h"
+#include "exceptions/exceptions.h"
+#include "utils/olotClock.h"
+
+
+
+// class olotFaceTrackerFB
+////////////////////////////
+
+olotFaceTrackerFB::olotFaceTrackerFB( olotInstance &instance,
+	const XrFaceTrackerCreateInfoFB &createInfo ) :
+pInstance( instance ),
+pOcsClient( nullptr ),
+pDestroyed( false )
+{
+	olotExpressionFrame::Clear( pFrame );
+	
+	OLOTASSERT_TRUE( createInfo.faceExpressionSet == XR_FACE_EXPRESSION_SET_DEFAULT_FB,
+		XR_ERROR_VALIDATION_FAILURE )
+	
+	pOcsClient = olotApiLayer::Get().AcquireOcsClient();
+}
+
+olotFaceTrackerFB::~olotFaceTrackerFB(){
+	pCleanUp();
+}
+
+
+
+// Management
+///////////////
+
+XrResult olotFaceTrackerFB::DestroyFaceTracker(){
+	OLOTASSERT_FALSE( pDestroyed, XR_ERROR_HANDLE_INVALID )
+	
+	pDestroyed = true;
+	return pInstance.DestroyFaceTrackerFB( this );
+}
+
+XrResult olotFaceTrackerFB::GetFaceExpressionWeights( const XrFaceExpressionInfoFB *expressionInfo,
+XrFaceExpressionWeightsFB *expressionWeights ){
+	// called every frame. failures are reported using result codes only
+	if( pDestroyed ){
+		return XR_ERROR_HANDLE_INVALID;
+	}
+	if( ! expressionInfo || ! expressionWeights || ! expressionWeights->weights
+	|| expressionWeights->weightCount != ( uint32_t )olotExpressionFrame::FbCount
+	|| expressionWeights->confidenceCount != XR_FACE_CONFIDENCE_COUNT_FB || ! expressionWeights->confidences ){
+		return XR_ERROR_VALIDATION_FAILURE;
+	}
+	
+	// weights are computed by the instance once per published snapshot
+	const uint32_t version = pFrame.version;
+	pInstance.GetExpressionFrame( pFrame );
+	
+	if( pFrame.version != version && pFrame.time != 0 && pOcsClient ){
+		pOcsClient->GetLatencyFacial().Record( olotClock::Now() - pFrame.time );
+	}
+	
+	// the initial values are published before any value has been received. weights are
+	// only valid once a value has been received
+	const bool active = pFrame.time != 0;
+	
+	memcpy( expressionWeights->weights, pFrame.fb, sizeof( pFrame.fb ) );
+	
+	// no confidence is reported by OCS. values are either fully trusted or not at all
+	uint32_t i;
+	for( i=0; i<expressionWeights->confidenceCount; i++ ){
+		expressionWeights->confidences[ i ] = active ? 1.0f : 0.0f;
+	}
+	
+	expressionWeights->status.isValid = active ? XR_TRUE : XR_FALSE;
+	expressionWeights->status.isEyeFollowingBlendshapesValid = active ? XR_TRUE : XR_FALSE;
+	
+	// sample time is the receive time of the newest value
+	expressionWeights->time = pFrame.time != 0 ? pInstance.MonotonicToXrTime( pFrame.time ) : 0;
+	
+	return XR_SUCCESS;
+}
+
+std::ostream &olotFaceTrackerFB::log(){
+	return olotApiLayer::Get().baseLogStream() << olotApiLayer::Get().GetLayerName()
+		<< ".Instance[" << pInstance.GetId() << "].FaceTrackerFB: ";
+}
+
+
+
+// Private Functions
+//////////////////////
+
+void olotFaceTrackerFB::pCleanUp(){
+	if( pOcsClient ){
+		pOcsClient->RemoveUsage();
+	}
+}
@@ -0,0 +1,92 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _OLOTFACETRACKERFB_H_
+#define _OLOTFACETRACKERFB_H_
+
+#include <memory>
+
+#include "openxr/openxr.h"
+#include "olotOcsClient.h"
+#include "olotExpressionFrame.h"
+
+class olotInstance;
+
+
+/**
+ * Face tracker class for XR_FB_face_tracking.
+ */
+class olotFaceTrackerFB{
+public:
+	/** Reference. */
+	typedef std::shared_ptr<olotFaceTrackerFB> Ref;
+	
+	
+	
+private:
+	olotInstance &pInstance;
+	
+	olotExpressionFrame::sFrame pFrame;
+	
+	olotOcsClient *pOcsClient;
+	bool pDestroyed;
+	
+	
+	
+public:
+	/** \name Constructors and Destructors */
+	/*@{*/
+	/** Create face tracker. */
+	olotFaceTrackerFB( olotInstance &instance, const XrFaceTrackerCreateInfoFB &createInfo );
+	
+	/** Clean up face tracker. */
+	~olotFaceTrackerFB();
+	/*@}*/
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/** Instance. */
+	inline olotInstance &GetInstance() const{ return pInstance; }
+	
+	/** xrDestroyFaceTrackerFB. */
+	XrResult DestroyFaceTracker();
+	
+	/** xrGetFaceExpressionWeightsFB. */
+	XrResult GetFaceExpressionWeights( const XrFaceExpressionInfoFB *expressionInfo,
+		XrFaceExpressionWeightsFB *expressionWeights );
+	
+	/** Log stream. */
+	std::ostream &log();
+	/*@}*/
+	
+	
+	
+private:
+	void pCleanUp();
+};
+
+#endif
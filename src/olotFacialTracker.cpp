@@ -22,16 +22,16 @@
  * SOFTWARE.
  */
 
-#include <chrono>
 #include <string.h>
 #include <math.h>
 
 #include "olotFacialTracker.h"
 #include "olotInstance.h"
-#include "olotInstance.h"
+#include "olotExpressionMapping.h"
 #include "olotApiLayer.h"
 #include "olotOcsClient.h"
 #include "exceptions/exceptions.h"
+#include "utils/olotClock.h"
 
 
 
@@ -41,16 +41,12 @@
 olotFacialTracker::olotFacialTracker( olotInstance &instance,
 	const XrFacialTrackerCreateInfoHTC &createInfo ) :
 pInstance( instance ),
-pWeights( nullptr ),
 pWeightCount( 0 ),
 pActive( false ),
 pOcsClient( nullptr ),
 pDestroyed( false )
 {
-	int i;
-	for( i=0; i<olotOcsClient::ExpressionCount; i++ ){
-		pOcsValues[ i ] = 0.0f;
-	}
+	olotExpressionFrame::Clear( pFrame );
 	
 	try{
 		switch( createInfo.facialTrackingType ){
@@ -81,24 +77,6 @@ olotFacialTracker::~olotFacialTracker(){
 // Management
 ///////////////
 
-static inline float clamp( float value ){
-	return std::max( std::min( value, 1.0f ), 0.0f );
-}
-
-static inline float linearStep( float value, float from, float to ){
-	return clamp( ( value - from ) / ( to - from ) );
-}
-
-static inline float linearStep( float value, float from, float to, float mapFrom, float mapTo ){
-	return linearStep( value, from, to ) * ( mapTo - mapFrom ) + mapFrom;
-}
-
-static inline float vec2Length( float x, float y ){
-	return sqrtf( x * x + y * y );
-}
-
-static const float invSqrt2 = 1.0f / sqrtf( 2.0f );
-
 XrResult olotFacialTracker::DestroyFacialTracker(){
 	OLOTASSERT_FALSE( pDestroyed, XR_ERROR_HANDLE_INVALID )
 	
@@ -107,114 +85,30 @@ XrResult olotFacialTracker::DestroyFacialTracker(){
 }
 
 XrResult olotFacialTracker::GetFacialExpressionsHTC( XrFacialExpressionsHTC *facialExpressions ){
-	OLOTASSERT_FALSE( pDestroyed, XR_ERROR_HANDLE_INVALID )
-	OLOTASSERT_TRUE( facialExpressions->expressionCount == pWeightCount, XR_ERROR_VALIDATION_FAILURE )
+	// called every frame. failures are reported using result codes only
+	if( pDestroyed ){
+		return XR_ERROR_HANDLE_INVALID;
+	}
+	if( ! facialExpressions || ! facialExpressions->expressionWeightings
+	|| facialExpressions->expressionCount != pWeightCount ){
+		return XR_ERROR_VALIDATION_FAILURE;
+	}
 	
-	const XrTime sampleTime = ( XrTime )std::clock();
+	// weights are computed by the instance once per published snapshot
+	const uint32_t version = pFrame.version;
+	pInstance.GetExpressionFrame( pFrame );
 	
-	try{
-		pOcsClient->GetExpressionValues( pOcsValues, olotOcsClient::ExpressionCount );
-		
-		if( pType == etEye ){
-			const float openessRight = pOcsValues[ olotOcsClient::eeRightEyeLidExpandedSqueeze ];
-			const float openessLeft = pOcsValues[ olotOcsClient::eeLeftEyeLidExpandedSqueeze ];
-			
-			pWeights[ XR_EYE_EXPRESSION_RIGHT_BLINK_HTC ] = linearStep( openessRight, 0.0f, 0.75f, 0.0f, 1.0f );
-			pWeights[ XR_EYE_EXPRESSION_LEFT_BLINK_HTC ] = linearStep( openessLeft, 0.0f, 0.75f, 0.0f, 1.0f );
-			
-			pWeights[ XR_EYE_EXPRESSION_RIGHT_WIDE_HTC ] = linearStep( openessRight, 0.75f, 1.0f, 0.0f, 1.0f );
-			pWeights[ XR_EYE_EXPRESSION_LEFT_WIDE_HTC ] = linearStep( openessLeft, 0.75f, 1.0f, 0.0f, 1.0f );
-			
-			pWeights[ XR_EYE_EXPRESSION_RIGHT_SQUEEZE_HTC ] = 0.0f;
-			pWeights[ XR_EYE_EXPRESSION_LEFT_SQUEEZE_HTC ] = 0.0f;
-			
-			// there is no explicit value mapping to the eye down, up, left and right values
-			
-			/*
-			not mapped ocs values:
-			*/
-			pActive = true;
-			
-		}else{
-			pWeights[ XR_LIP_EXPRESSION_JAW_RIGHT_HTC ] = pOcsValues[ olotOcsClient::eeJawRight ];
-			pWeights[ XR_LIP_EXPRESSION_JAW_LEFT_HTC ] = pOcsValues[ olotOcsClient::eeJawLeft ];
-			pWeights[ XR_LIP_EXPRESSION_JAW_FORWARD_HTC ] = pOcsValues[ olotOcsClient::eeJawForward ];
-			pWeights[ XR_LIP_EXPRESSION_JAW_OPEN_HTC ] = pOcsValues[ olotOcsClient::eeJawOpen ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_POUT_HTC ] = pOcsValues[ olotOcsClient::eeMouthPucker ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_SMILE_RIGHT_HTC ] = pOcsValues[ olotOcsClient::eeMouthSmileRight ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_SMILE_LEFT_HTC ] = pOcsValues[ olotOcsClient::eeMouthSmileLeft ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_SAD_RIGHT_HTC ] = pOcsValues[ olotOcsClient::eeMouthFrownRight ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_SAD_LEFT_HTC ] = pOcsValues[ olotOcsClient::eeMouthFrownLeft ];
-			pWeights[ XR_LIP_EXPRESSION_CHEEK_PUFF_RIGHT_HTC ] = pOcsValues[ olotOcsClient::eeCheekPuffRight ];
-			pWeights[ XR_LIP_EXPRESSION_CHEEK_PUFF_LEFT_HTC ] = pOcsValues[ olotOcsClient::eeCheekPuffLeft ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_UPPER_UPRIGHT_HTC ] = pOcsValues[ olotOcsClient::eeMouthUpperUpRight ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_UPPER_UPLEFT_HTC ] = pOcsValues[ olotOcsClient::eeMouthUpperUpLeft ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_LOWER_DOWNRIGHT_HTC ] = pOcsValues[ olotOcsClient::eeMouthLowerDownRight ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_LOWER_DOWNLEFT_HTC ] = pOcsValues[ olotOcsClient::eeMouthLowerDownLeft ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_UPPER_INSIDE_HTC ] = pOcsValues[ olotOcsClient::eeMouthRollUpper ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_LOWER_INSIDE_HTC ] = pOcsValues[ olotOcsClient::eeMouthRollLower ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_LOWER_OVERLAY_HTC ] = pOcsValues[ olotOcsClient::eeMouthShrugLower ];
-			pWeights[ XR_LIP_EXPRESSION_TONGUE_LEFT_HTC ] = pOcsValues[ olotOcsClient::eeTongueLeft ];
-			pWeights[ XR_LIP_EXPRESSION_TONGUE_RIGHT_HTC ] = pOcsValues[ olotOcsClient::eeTongueRight ];
-			pWeights[ XR_LIP_EXPRESSION_TONGUE_UP_HTC ] = pOcsValues[ olotOcsClient::eeTongueUp ];
-			pWeights[ XR_LIP_EXPRESSION_TONGUE_DOWN_HTC ] = pOcsValues[ olotOcsClient::eeTongueDown ];
-			pWeights[ XR_LIP_EXPRESSION_TONGUE_ROLL_HTC ] = pOcsValues[ olotOcsClient::eeTongueRoll ];
-			
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_APE_SHAPE_HTC ] = pOcsValues[ olotOcsClient::eeMouthClose ];
-			
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_UPPER_RIGHT_HTC ] = pOcsValues[ olotOcsClient::eeMouthRight ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_UPPER_LEFT_HTC ] = pOcsValues[ olotOcsClient::eeMouthLeft ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_LOWER_RIGHT_HTC ] = pOcsValues[ olotOcsClient::eeMouthRight ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_LOWER_LEFT_HTC ] = pOcsValues[ olotOcsClient::eeMouthLeft ];
-			
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_UPPER_OVERTURN_HTC ] = pOcsValues[ olotOcsClient::eeMouthFunnel ];
-			pWeights[ XR_LIP_EXPRESSION_MOUTH_LOWER_OVERTURN_HTC ] = pOcsValues[ olotOcsClient::eeMouthFunnel ];
-			
-			pWeights[ XR_LIP_EXPRESSION_CHEEK_SUCK_HTC ] = std::max(
-				pOcsValues[ olotOcsClient::eeCheekSuckRight ], pOcsValues[ olotOcsClient::eeCheekSuckLeft ] );
-			
-			const float tongueOut = pOcsValues[ olotOcsClient::eeTongueOut ];
-			const float tongueUp = pOcsValues[ olotOcsClient::eeTongueUp ];
-			const float tongueDown = pOcsValues[ olotOcsClient::eeTongueDown ];
-			const float tongueRight = pOcsValues[ olotOcsClient::eeTongueRight ];
-			const float tongueLeft = pOcsValues[ olotOcsClient::eeTongueLeft ];
-			
-			pWeights[ XR_LIP_EXPRESSION_TONGUE_LONGSTEP1_HTC ] = linearStep( tongueOut, 0.0f, 0.5f, 0.0f, 1.0f );
-			pWeights[ XR_LIP_EXPRESSION_TONGUE_LONGSTEP2_HTC ] = linearStep( tongueOut, 0.5f, 1.0f, 0.0f, 1.0f );
-			
-			pWeights[ XR_LIP_EXPRESSION_TONGUE_UPRIGHT_MORPH_HTC ] = vec2Length( tongueUp, tongueRight ) * invSqrt2 * tongueOut;
-			pWeights[ XR_LIP_EXPRESSION_TONGUE_UPLEFT_MORPH_HTC ] = vec2Length( tongueUp, tongueLeft ) * invSqrt2 * tongueOut;
-			pWeights[ XR_LIP_EXPRESSION_TONGUE_DOWNRIGHT_MORPH_HTC ] = vec2Length( tongueDown, tongueRight ) * invSqrt2 * tongueOut;
-			pWeights[ XR_LIP_EXPRESSION_TONGUE_DOWNLEFT_MORPH_HTC ] = vec2Length( tongueDown, tongueLeft ) * invSqrt2 * tongueOut;
-			
-			/*
-			not mapped ocs values:
-			- olotOcsClient::eeNoseSneerLeft
-			- olotOcsClient::eeNoseSneerRight
-			- olotOcsClient::eeMouthShrugUpper
-			- olotOcsClient::eeMouthDimpleLeft
-			- olotOcsClient::eeMouthDimpleRight
-			- olotOcsClient::eeMouthPressLeft
-			- olotOcsClient::eeMouthPressRight
-			- olotOcsClient::eeMouthStretchLeft
-			- olotOcsClient::eeMouthStretchRight
-			- olotOcsClient::eeTongueBendDown
-			- olotOcsClient::eeTongueCurlUp
-			- olotOcsClient::eeTongueSquish
-			- olotOcsClient::eeTongueFlat
-			- olotOcsClient::eeTongueTwistLeft
-			- olotOcsClient::eeTongueTwistRight
-			*/
-			pActive = true;
-		}
-		
-	}catch( const olotException & ){
-		pActive = false;
+	if( pFrame.version != version && pFrame.time != 0 && pOcsClient ){
+		pOcsClient->GetLatencyFacial().Record( olotClock::Now() - pFrame.time );
 	}
 	
-	facialExpressions->sampleTime = sampleTime;
+	pActive = pFrame.version != 0;
+	
+	// sample time is the receive time of the newest value
+	facialExpressions->sampleTime = pFrame.time != 0 ? pInstance.MonotonicToXrTime( pFrame.time ) : 0;
 	
-	memcpy( facialExpressions->expressionWeightings, pWeights, sizeof( float ) * pWeightCount );
+	memcpy( facialExpressions->expressionWeightings, pType == etEye ? pFrame.htcEye : pFrame.htcLip,
+		sizeof( float ) * pWeightCount );
 	
 	facialExpressions->isActive = pActive ? XR_TRUE : XR_FALSE;
 	
@@ -235,18 +129,13 @@ void olotFacialTracker::pCleanUp(){
 	if( pOcsClient ){
 		pOcsClient->RemoveUsage();
 	}
-	
-	if( pWeights ){
-		delete [] pWeights;
-	}
 }
 
 void olotFacialTracker::pCreateEyeTracker(){
 	pType = etEye;
 	
-	pWeights = new float[ 14 ];
-	pWeightCount = 14;
-	memset( pWeights, 0, sizeof( float ) * pWeightCount );
+	pWeightCount = olotExpressionFrame::HtcEyeCount;
+	OLOTASSERT_NOTNULL( pInstance.GetMappingEye(), XR_ERROR_RUNTIME_FAILURE )
 	
 	pOcsClient = olotApiLayer::Get().AcquireOcsClient();
 }
@@ -254,9 +143,8 @@ void olotFacialTracker::pCreateEyeTracker(){
 void olotFacialTracker::pCreateLipTracker(){
 	pType = etLip;
 	
-	pWeights = new float[ 37 ];
-	pWeightCount = 37;
-	memset( pWeights, 0, sizeof( float ) * pWeightCount );
+	pWeightCount = olotExpressionFrame::HtcLipCount;
+	OLOTASSERT_NOTNULL( pInstance.GetMappingLip(), XR_ERROR_RUNTIME_FAILURE )
 	
 	pOcsClient = olotApiLayer::Get().AcquireOcsClient();
 }
@@ -31,6 +31,7 @@
 #include "openxr/openxr.h"
 #include "olotStructs.h"
 #include "olotOcsClient.h"
+#include "olotExpressionFrame.h"
 
 class olotInstance;
 
@@ -55,9 +56,8 @@ private:
 	olotInstance &pInstance;
 	eType pType;
 	
-	float pOcsValues[ olotOcsClient::ExpressionCount ];
+	olotExpressionFrame::sFrame pFrame;
 	
-	float *pWeights;
 	uint32_t pWeightCount;
 	
 	bool pActive;
@@ -27,6 +27,9 @@
 
 #include "olotInstance.h"
 #include "olotApiLayer.h"
+#include "olotExpressionProfile.h"
+#include "utils/olotClock.h"
+#include "utils/olotPerfectHash.h"
 #include "exceptions/exceptions.h"
 
 
@@ -38,12 +41,22 @@
 	try{\
 		return c;\
 	}catch( const olotException &e ){\
-		const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );\
-		olotApiLayer::Get().log() << fn << " failed:" << std::endl;\
+		OLOTLOG_ERROR( olotApiLayer::Get().log(), fn << " failed:" );\
 		e.PrintError( olotApiLayer::Get().baseLogStream() );\
 		return e.GetResult();\
 	}
 
+// per frame hooks report failures using result codes only. throwing on every frame
+// captures a backtrace each time which can stall the render thread
+#define OXR_FRAME_CALL(fn,c) \
+	{\
+		const XrResult result = c;\
+		if( XR_FAILED( result ) ){\
+			OLOTLOG_DEBUG( olotApiLayer::Get().log(), fn << " failed: " << result );\
+		}\
+		return result;\
+	}
+
 
 static XrResult fxrGetSystemProperties( XrInstance instance, XrSystemId systemId,
 XrSystemProperties *properties ){
@@ -92,32 +105,34 @@ const XrSessionCreateInfo *createInfo, XrSession *session ){
 
 static XrResult fxrDestroySession( XrSession session ){
 	OXR_CHAIN_CALL( "xrDestroySession", olotApiLayer::Get().
-		GetSessions()[ session ]->DestroySession( session ) );
+		GetSessionInstance( session ).DestroySession( session ) );
 }
 
 static XrResult fxrGetActionStatePose( XrSession session,
 const XrActionStateGetInfo *getInfo, XrActionStatePose *state ){
-	OXR_CHAIN_CALL( "xrGetActionStatePose", olotApiLayer::Get().
-		GetSessions()[ session ]->GetActionStatePose( session, getInfo, state ) );
+	olotInstance * const instance = olotApiLayer::Get().FindSessionInstance( session );
+	OXR_FRAME_CALL( "xrGetActionStatePose", instance
+		? instance->GetActionStatePose( session, getInfo, state ) : XR_ERROR_HANDLE_INVALID )
 }
 
 static XrResult fxrLocateSpace( XrSpace space, XrSpace baseSpace, XrTime time,
 XrSpaceLocation *location ){
-	try{
-		const olotSpace &s = olotApiLayer::Get().GetSpaces()[ space ];
-		return s.instance->LocateSpace( s, baseSpace, time, location );
-	}catch( const olotException &e ){
-		const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-		olotApiLayer::Get().log() << "xrLocateSpace failed:" << std::endl;
-		e.PrintError( olotApiLayer::Get().baseLogStream() );
-		return e.GetResult();
+	// spaces not bound to eye gaze are passed through without looking them up
+	const olotApiLayer &apiLayer = olotApiLayer::Get();
+	const PFN_xrLocateSpace nextLocateSpace = apiLayer.GetFastLocateSpace();
+	if( nextLocateSpace && ! apiLayer.IsGazeSpace( space ) ){
+		return nextLocateSpace( space, baseSpace, time, location );
 	}
+	
+	olotSpace s;
+	OXR_FRAME_CALL( "xrLocateSpace", apiLayer.FindSpace( space, s )
+		? s.instance->LocateSpace( s, baseSpace, time, location ) : XR_ERROR_HANDLE_INVALID )
 }
 
 static XrResult fxrCreateActionSpace( XrSession session,
 const XrActionSpaceCreateInfo *createInfo, XrSpace *space ){
 	try{
-		return olotApiLayer::Get().GetSessions()[ session ]->
+		return olotApiLayer::Get().GetSessionInstance( session ).
 			CreateActionSpace( session, createInfo, space );
 		
 	}catch( const olotException &e ){
@@ -129,7 +144,7 @@ const XrActionSpaceCreateInfo *createInfo, XrSpace *space ){
 static XrResult fxrCreateReferenceSpace( XrSession session,
 const XrReferenceSpaceCreateInfo *createInfo, XrSpace *space ){
 	try{
-		return olotApiLayer::Get().GetSessions()[ session ]->
+		return olotApiLayer::Get().GetSessionInstance( session ).
 			CreateReferenceSpace( session, createInfo, space );
 		
 	}catch( const olotException &e ){
@@ -139,7 +154,7 @@ const XrReferenceSpaceCreateInfo *createInfo, XrSpace *space ){
 }
 
 static XrResult fxrDestroySpace( XrSpace space ){
-	OXR_CHAIN_CALL( "xrDestroySpace", olotApiLayer::Get().GetSpaces()[ space ].
+	OXR_CHAIN_CALL( "xrDestroySpace", olotApiLayer::Get().GetSpace( space ).
 		instance->DestroySpace( space ) );
 }
 
@@ -151,24 +166,37 @@ const XrActionSetCreateInfo *createInfo, XrActionSet *actionSet ){
 
 static XrResult fxrDestroyActionSet( XrActionSet actionSet ){
 	OXR_CHAIN_CALL( "xrDestroyActionSet", olotApiLayer::Get().
-		GetActionSets()[ actionSet ]->DestroyActionSet( actionSet ) );
+		GetActionSetInstance( actionSet ).DestroyActionSet( actionSet ) );
 }
 
 static XrResult fxrCreateAction( XrActionSet actionSet,
 const XrActionCreateInfo *createInfo, XrAction *action ){
 	OXR_CHAIN_CALL( "xrCreateActionSet", olotApiLayer::Get().
-		GetActionSets()[ actionSet ]->CreateAction( actionSet, createInfo, action ) );
+		GetActionSetInstance( actionSet ).CreateAction( actionSet, createInfo, action ) );
 }
 
 static XrResult fxrDestroyAction( XrAction action ){
 	OXR_CHAIN_CALL( "xrDestroyAction", olotApiLayer::Get().
-		GetActions()[ action ]->DestroyAction( action ) );
+		GetActionInstance( action ).DestroyAction( action ) );
+}
+
+static XrResult fxrSyncActions( XrSession session, const XrActionsSyncInfo *syncInfo ){
+	olotInstance * const instance = olotApiLayer::Get().FindSessionInstance( session );
+	OXR_FRAME_CALL( "xrSyncActions", instance
+		? instance->SyncActions( session, syncInfo ) : XR_ERROR_HANDLE_INVALID )
+}
+
+static XrResult fxrWaitFrame( XrSession session, const XrFrameWaitInfo *frameWaitInfo,
+XrFrameState *frameState ){
+	olotInstance * const instance = olotApiLayer::Get().FindSessionInstance( session );
+	OXR_FRAME_CALL( "xrWaitFrame", instance
+		? instance->WaitFrame( session, frameWaitInfo, frameState ) : XR_ERROR_HANDLE_INVALID )
 }
 
 static XrResult fxrCreateFacialTrackerHTC( XrSession session,
 const XrFacialTrackerCreateInfoHTC *createInfo, XrFacialTrackerHTC *facialTracker ){
 	OXR_CHAIN_CALL( "xrCreateFacialTrackerHTC", olotApiLayer::Get().
-		GetSessions()[ session ]->CreateFacialTracker( session, createInfo, facialTracker ) );
+		GetSessionInstance( session ).CreateFacialTracker( session, createInfo, facialTracker ) );
 }
 
 static XrResult fxrDestroyFacialTrackerHTC( XrFacialTrackerHTC facialTracker ){
@@ -176,13 +204,73 @@ static XrResult fxrDestroyFacialTrackerHTC( XrFacialTrackerHTC facialTracker ){
 		DestroyFacialTracker() );
 }
 
-static XrResult fxrGetFacialExpressionsHTC( XrFacialTrackerHTC facialTracker,
-XrFacialExpressionsHTC *facialExpressions ){
-	OXR_CHAIN_CALL( "xrGetFacialExpressionsHTC", ( ( olotFacialTracker* )facialTracker )->
-		GetFacialExpressionsHTC( facialExpressions ) );
+static XrResult fxrCreateFaceTrackerFB( XrSession session,
+const XrFaceTrackerCreateInfoFB *createInfo, XrFaceTrackerFB *faceTracker ){
+	OXR_CHAIN_CALL( "xrCreateFaceTrackerFB", olotApiLayer::Get().
+		GetSessionInstance( session ).CreateFaceTrackerFB( session, createInfo, faceTracker ) );
 }
 
+static XrResult fxrDestroyFaceTrackerFB( XrFaceTrackerFB faceTracker ){
+	OXR_CHAIN_CALL( "xrDestroyFaceTrackerFB", ( ( olotFaceTrackerFB* )faceTracker )->
+		DestroyFaceTracker() );
+}
 
+static XrResult fxrGetFaceExpressionWeightsFB( XrFaceTrackerFB faceTracker,
+const XrFaceExpressionInfoFB *expressionInfo, XrFaceExpressionWeightsFB *expressionWeights ){
+	OXR_FRAME_CALL( "xrGetFaceExpressionWeightsFB", faceTracker
+		? ( ( olotFaceTrackerFB* )faceTracker )->GetFaceExpressionWeights( expressionInfo, expressionWeights )
+		: XR_ERROR_HANDLE_INVALID )
+}
+
+static XrResult fxrGetFacialExpressionsHTC( XrFacialTrackerHTC facialTracker,
+XrFacialExpressionsHTC *facialExpressions ){
+	OXR_FRAME_CALL( "xrGetFacialExpressionsHTC", facialTracker
+		? ( ( olotFacialTracker* )facialTracker )->GetFacialExpressionsHTC( facialExpressions )
+		: XR_ERROR_HANDLE_INVALID )
+}
+
+#define OLOT_HOOKS\
+	OLOT_HOOK( "xrGetSystemProperties", fxrGetSystemProperties )\
+	OLOT_HOOK( "xrSuggestInteractionProfileBindings", fxrSuggestInteractionProfileBindings )\
+	OLOT_HOOK( "xrDestroyInstance", fxrDestroyInstance )\
+	OLOT_HOOK( "xrCreateSession", fxrCreateSession )\
+	OLOT_HOOK( "xrDestroySession", fxrDestroySession )\
+	OLOT_HOOK( "xrGetActionStatePose", fxrGetActionStatePose )\
+	OLOT_HOOK( "xrLocateSpace", fxrLocateSpace )\
+	OLOT_HOOK( "xrCreateActionSpace", fxrCreateActionSpace )\
+	OLOT_HOOK( "xrCreateReferenceSpace", fxrCreateReferenceSpace )\
+	OLOT_HOOK( "xrDestroySpace", fxrDestroySpace )\
+	OLOT_HOOK( "xrCreateActionSet", fxrCreateActionSet )\
+	OLOT_HOOK( "xrDestroyActionSet", fxrDestroyActionSet )\
+	OLOT_HOOK( "xrCreateAction", fxrCreateAction )\
+	OLOT_HOOK( "xrDestroyAction", fxrDestroyAction )\
+	OLOT_HOOK( "xrSyncActions", fxrSyncActions )\
+	OLOT_HOOK( "xrWaitFrame", fxrWaitFrame )\
+	OLOT_HOOK( "xrCreateFacialTrackerHTC", fxrCreateFacialTrackerHTC )\
+	OLOT_HOOK( "xrDestroyFacialTrackerHTC", fxrDestroyFacialTrackerHTC )\
+	OLOT_HOOK( "xrGetFacialExpressionsHTC", fxrGetFacialExpressionsHTC )\
+	OLOT_HOOK( "xrCreateFaceTrackerFB", fxrCreateFaceTrackerFB )\
+	OLOT_HOOK( "xrDestroyFaceTrackerFB", fxrDestroyFaceTrackerFB )\
+	OLOT_HOOK( "xrGetFaceExpressionWeightsFB", fxrGetFaceExpressionWeightsFB )
+
+#define OLOT_HOOK(fn, f) fn,
+static constexpr const char *vHookNames[] = { OLOT_HOOKS };
+#undef OLOT_HOOK
+
+#define OLOT_HOOK(fn, f) ( PFN_xrVoidFunction )f,
+static const PFN_xrVoidFunction vHookFunctions[] = { OLOT_HOOKS };
+#undef OLOT_HOOK
+
+#undef OLOT_HOOKS
+
+typedef olotPerfectHash<sizeof( vHookNames ) / sizeof( vHookNames[ 0 ] ), olotInstance::HookTableSize> HookHash;
+static constexpr HookHash vHookHash( vHookNames );
+static_assert( vHookHash.IsValid(), "no perfect hash found for hooked functions" );
+
+
+
+#undef OXR_FRAME_CALL
+#undef OXR_CHAIN_CALL
 
 // class olotInstance
 ///////////////////////
@@ -201,6 +289,7 @@ pId( pNextId++ ),
 pInstance( instance ),
 pEnableEyeGaze( false ),
 pEnableFacial( false ),
+pEnableFaceTrackingFB( false ),
 pNextXrGetInstanceProcAddr( nextXrGetInstanceProcAddr ),
 pXrStringToPath( nullptr ),
 pNextXrGetSystemProperties( nullptr ),
@@ -217,8 +306,24 @@ pNextXrCreateActionSet( nullptr ),
 pNextXrDestroyActionSet( nullptr ),
 pNextXrCreateAction( nullptr ),
 pNextXrDestroyAction( nullptr ),
-pPathProfileEyeGaze( XR_NULL_PATH )
+pNextXrSyncActions( nullptr ),
+pNextXrWaitFrame( nullptr ),
+pNextXrConvertTimespecTimeToTime( nullptr ),
+pPathProfileEyeGaze( XR_NULL_PATH ),
+pSnapshotTaken( false ),
+pXrTimeOffset( 0 ),
+pXrTimeConverted( false ),
+pXrTimeMinLead( INT64_MAX )
 {
+	memset( &pSnapshotWork, 0, sizeof( pSnapshotWork ) );
+	olotExpressionFrame::Clear( pFrameWork );
+	
+	int j;
+	for( j=0; j<HookTableSize; j++ ){
+		pNextFunctions[ j ].hash.store( 0, std::memory_order_relaxed );
+		pNextFunctions[ j ].function.store( nullptr, std::memory_order_relaxed );
+	}
+	
 	try{
 		OLOT_GET_NEXT_FUNC( "xrStringToPath", pXrStringToPath );
 		
@@ -236,6 +341,9 @@ pPathProfileEyeGaze( XR_NULL_PATH )
 		OLOT_GET_NEXT_FUNC( "xrDestroyActionSet", pNextXrDestroyActionSet );
 		OLOT_GET_NEXT_FUNC( "xrCreateAction", pNextXrCreateAction );
 		OLOT_GET_NEXT_FUNC( "xrDestroyAction", pNextXrDestroyAction );
+		OLOT_GET_NEXT_FUNC( "xrSyncActions", pNextXrSyncActions );
+		OLOT_GET_NEXT_FUNC( "xrWaitFrame", pNextXrWaitFrame );
+		OLOT_GET_NEXT_FUNC_OPT( "xrConvertTimespecTimeToTimeKHR", pNextXrConvertTimespecTimeToTime );
 		
 		pPathProfileEyeGaze = GetXrPathFor( "/interaction_profiles/ext/eye_gaze_interaction" );
 		
@@ -245,40 +353,42 @@ pPathProfileEyeGaze( XR_NULL_PATH )
 		for( i=0; i<info.enabledExtensionCount; i++ ){
 			if( strcmp( info.enabledExtensionNames[ i ], XR_EXT_EYE_GAZE_INTERACTION_EXTENSION_NAME ) == 0 ){
 				if( ! apiLayer.GetSupportsEyeGazeTracking() ){
-					{
-					const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-					log() << "Enable eye gaze interaction requested but not supported" << std::endl;
-					}
+					OLOTLOG_WARNING( log(), "Enable eye gaze interaction requested but not supported" );
 					OLOTASSERT_SUCCESS( XR_ERROR_EXTENSION_NOT_PRESENT )
 				}
 				pEnableEyeGaze = true;
 				
 			}else if( strcmp( info.enabledExtensionNames[ i ], XR_HTC_FACIAL_TRACKING_EXTENSION_NAME ) == 0 ){
 				if( ! apiLayer.GetSupportsEyeGazeTracking() ){
-					{
-					const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-					log() << "Enable facial tracking requested but not supported" << std::endl;
-					}
+					OLOTLOG_WARNING( log(), "Enable facial tracking requested but not supported" );
 					OLOTASSERT_SUCCESS( XR_ERROR_EXTENSION_NOT_PRESENT )
 				}
 				pEnableFacial = true;
+				
+			}else if( strcmp( info.enabledExtensionNames[ i ], XR_FB_FACE_TRACKING_EXTENSION_NAME ) == 0 ){
+				if( ! apiLayer.GetSupportsFacialTracking() ){
+					OLOTLOG_WARNING( log(), "Enable FB face tracking requested but not supported" );
+					OLOTASSERT_SUCCESS( XR_ERROR_EXTENSION_NOT_PRESENT )
+				}
+				pEnableFaceTrackingFB = true;
 			}
 		}
 		
-		{
-		const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-		log() << "Enable eye gaze interaction: " << ( pEnableEyeGaze ? "yes" : "no" ) << std::endl;
-		log() << "Enable facial tracking: " << ( pEnableFacial ? "yes" : "no" ) << std::endl;
-		}
+		OLOTLOG_INFO( log(), "Enable eye gaze interaction: " << ( pEnableEyeGaze ? "yes" : "no" ) );
+		OLOTLOG_INFO( log(), "Enable facial tracking: " << ( pEnableFacial ? "yes" : "no" ) );
+		OLOTLOG_INFO( log(), "Enable FB face tracking: " << ( pEnableFaceTrackingFB ? "yes" : "no" ) );
 		
 		if( pEnableEyeGaze ){
-			{
-			const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-			log() << "Create eye gaze tracker" << std::endl;
-			}
+			OLOTLOG_DEBUG( log(), "Create eye gaze tracker" );
 			pEyeGazeTracker = std::make_shared<olotEyeGazeTracker>( *this );
 		}
 		
+		if( pEnableFacial || pEnableFaceTrackingFB ){
+			pLoadProfile();
+		}
+		
+		pInitXrTimeOffset();
+		
 	}catch( const olotException & ){
 		pCleanUp();
 		throw;
@@ -297,37 +407,60 @@ olotInstance::~olotInstance(){
 // Management
 ///////////////
 
-#define OLOT_GET_INST_PROC_ADDR(fn, f)\
-	if( name == fn ){\
-		*function = ( PFN_xrVoidFunction )f;\
-		return XR_SUCCESS;\
+XrResult olotInstance::GetInstanceProcAddr( const char *name, PFN_xrVoidFunction *function ) const{
+	OLOTASSERT_NOTNULL( name, XR_ERROR_VALIDATION_FAILURE )
+	OLOTASSERT_NOTNULL( function, XR_ERROR_VALIDATION_FAILURE )
+	
+	const int hook = vHookHash.Find( name );
+	if( hook != -1 && strcmp( name, vHookNames[ hook ] ) == 0 ){
+		*function = vHookFunctions[ hook ];
+		return XR_SUCCESS;
+	}
+	
+	// functions of the next layer are cached in slots starting at the perfect hash slot.
+	// entries are identified by the full 64-bit hash. hash 0 marks a free slot and hash 1
+	// a slot being filled. filled slots never change hence lookups are wait-free
+	uint64_t hash = HookHash::Hash( name );
+	if( hash < 2 ){
+		hash += 2;
 	}
-
-XrResult olotInstance::GetInstanceProcAddr( const std::string &name, PFN_xrVoidFunction *function ) const{
-	OLOT_GET_INST_PROC_ADDR( "xrGetSystemProperties", fxrGetSystemProperties )
-	OLOT_GET_INST_PROC_ADDR( "xrSuggestInteractionProfileBindings", fxrSuggestInteractionProfileBindings );
-	OLOT_GET_INST_PROC_ADDR( "xrDestroyInstance", fxrDestroyInstance );
-	OLOT_GET_INST_PROC_ADDR( "xrCreateSession", fxrCreateSession );
-	OLOT_GET_INST_PROC_ADDR( "xrDestroySession", fxrDestroySession );
-	OLOT_GET_INST_PROC_ADDR( "xrGetActionStatePose", fxrGetActionStatePose );
-	OLOT_GET_INST_PROC_ADDR( "xrLocateSpace", fxrLocateSpace );
-	OLOT_GET_INST_PROC_ADDR( "xrCreateActionSpace", fxrCreateActionSpace );
-	OLOT_GET_INST_PROC_ADDR( "xrCreateReferenceSpace", fxrCreateReferenceSpace );
-	OLOT_GET_INST_PROC_ADDR( "xrDestroySpace", fxrDestroySpace );
-	OLOT_GET_INST_PROC_ADDR( "xrCreateActionSet", fxrCreateActionSet );
-	OLOT_GET_INST_PROC_ADDR( "xrDestroyActionSet", fxrDestroyActionSet );
-	OLOT_GET_INST_PROC_ADDR( "xrCreateAction", fxrCreateAction );
-	OLOT_GET_INST_PROC_ADDR( "xrDestroyAction", fxrDestroyAction );
 	
-	OLOT_GET_INST_PROC_ADDR( "xrCreateFacialTrackerHTC", fxrCreateFacialTrackerHTC );
-	OLOT_GET_INST_PROC_ADDR( "xrDestroyFacialTrackerHTC", fxrDestroyFacialTrackerHTC );
-	OLOT_GET_INST_PROC_ADDR( "xrGetFacialExpressionsHTC", fxrGetFacialExpressionsHTC );
+	const int slot = vHookHash.SlotOf( name );
+	int i;
 	
-	return pNextXrGetInstanceProcAddr( pInstance, name.c_str(), function );
+	for( i=0; i<NextFunctionProbes; i++ ){
+		const sNextFunction &entry = pNextFunctions[ ( slot + i ) & ( HookTableSize - 1 ) ];
+		const uint64_t entryHash = entry.hash.load( std::memory_order_acquire );
+		if( entryHash == hash ){
+			*function = entry.function.load( std::memory_order_relaxed );
+			return XR_SUCCESS;
+		}
+		if( entryHash == 0 ){
+			break;
+		}
+	}
+	
+	const XrResult result = pNextXrGetInstanceProcAddr( pInstance, name, function );
+	if( XR_FAILED( result ) || ! *function ){
+		return result;
+	}
+	
+	// functions are not cached if all probed slots are in use
+	for( i=0; i<NextFunctionProbes; i++ ){
+		sNextFunction &entry = pNextFunctions[ ( slot + i ) & ( HookTableSize - 1 ) ];
+		uint64_t expected = 0;
+		if( entry.hash.compare_exchange_strong( expected, 1, std::memory_order_relaxed ) ){
+			entry.function.store( *function, std::memory_order_relaxed );
+			entry.hash.store( hash, std::memory_order_release );
+			break;
+		}
+		if( expected == hash ){
+			break;
+		}
+	}
+	return result;
 }
 
-#undef OLOT_GET_INST_PROC_ADDR
-
 XrResult olotInstance::GetSystemProperties( XrSystemId systemId, XrSystemProperties *properties ){
 	OLOTASSERT_NOTNULL( properties, XR_ERROR_VALIDATION_FAILURE )
 	
@@ -349,6 +482,11 @@ XrResult olotInstance::GetSystemProperties( XrSystemId systemId, XrSystemPropert
 			p.supportLipFacialTracking = apiLayer.GetSupportsFacialTracking() ? XR_TRUE : XR_FALSE;
 			}break;
 			
+		case XR_TYPE_SYSTEM_FACE_TRACKING_PROPERTIES_FB:{
+			XrSystemFaceTrackingPropertiesFB &p = *( ( XrSystemFaceTrackingPropertiesFB* )next );
+			p.supportsFaceTracking = apiLayer.GetSupportsFacialTracking() ? XR_TRUE : XR_FALSE;
+			}break;
+			
 		default:
 			break;
 		}
@@ -366,7 +504,9 @@ const XrInteractionProfileSuggestedBinding *suggestedBindings ){
 	}
 	
 	if( pEyeGazeTracker ){
-		return pEyeGazeTracker->SuggestInteractionProfileBindings( *suggestedBindings );
+		const XrResult result = pEyeGazeTracker->SuggestInteractionProfileBindings( *suggestedBindings );
+		pUpdateGazeSpaces();
+		return result;
 		
 	}else{
 		return XR_ERROR_FEATURE_UNSUPPORTED;
@@ -374,42 +514,9 @@ const XrInteractionProfileSuggestedBinding *suggestedBindings ){
 }
 
 XrResult olotInstance::DestroyInstance(){
-	{
-	const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-	log() << "Destroy instance" << std::endl;
-	}
-	
-	olotApiLayer &apiLayer = olotApiLayer::Get();
-	
-	olotApiLayer::MapSessions &sessions = apiLayer.GetSessions();
-	for( olotApiLayer::MapSessions::iterator iter = sessions.begin(); iter != sessions.end(); ){
-		if( this == iter->second ){
-			iter = sessions.erase( iter );
-			
-		}else{
-			iter++;
-		}
-	}
+	OLOTLOG_DEBUG( log(), "Destroy instance" );
 	
-	olotApiLayer::MapActionSets &actionSets = apiLayer.GetActionSets();
-	for( olotApiLayer::MapActionSets::iterator iter = actionSets.begin(); iter != actionSets.end(); ){
-		if( this == iter->second ){
-			iter = actionSets.erase( iter );
-			
-		}else{
-			iter++;
-		}
-	}
-	
-	olotApiLayer::MapActions &actions = apiLayer.GetActions();
-	for( olotApiLayer::MapActions::iterator iter = actions.begin(); iter != actions.end(); ){
-		if( this == iter->second ){
-			iter = actions.erase( iter );
-			
-		}else{
-			iter++;
-		}
-	}
+	olotApiLayer::Get().RemoveInstanceHandles( this );
 	
 	return pNextXrDestroyInstance( pInstance );
 }
@@ -417,32 +524,26 @@ XrResult olotInstance::DestroyInstance(){
 XrResult olotInstance::CreateSession( const XrSessionCreateInfo *createInfo, XrSession *session ){
 	const XrResult result = pNextXrCreateSession( pInstance, createInfo, session );
 	if( XR_SUCCEEDED( result ) ){
-		olotApiLayer::Get().GetSessions()[ *session ] = this;
+		olotApiLayer::Get().GetSessions().Set( *session, this );
 	}
 	return result;
 }
 
 XrResult olotInstance::DestroySession( XrSession session ){
-	olotApiLayer::MapSessions::iterator iter( olotApiLayer::Get().GetSessions().find( session ) );
-	if( iter != olotApiLayer::Get().GetSessions().end() ){
-		olotApiLayer::Get().GetSessions().erase( iter );
-	}
+	olotApiLayer::Get().GetSessions().Remove( session );
 	return pNextXrDestroySession( session );
 }
 
 XrResult olotInstance::CreateActionSet( const XrActionSetCreateInfo *createInfo, XrActionSet *actionSet ){
 	const XrResult result = pNextXrCreateActionSet( pInstance, createInfo, actionSet );
 	if( XR_SUCCEEDED( result ) ){
-		olotApiLayer::Get().GetActionSets()[ *actionSet ] = this;
+		olotApiLayer::Get().GetActionSets().Set( *actionSet, this );
 	}
 	return result;
 }
 
 XrResult olotInstance::DestroyActionSet( XrActionSet actionSet ){
-	olotApiLayer::MapActionSets::iterator iter( olotApiLayer::Get().GetActionSets().find( actionSet ) );
-	if( iter != olotApiLayer::Get().GetActionSets().end() ){
-		olotApiLayer::Get().GetActionSets().erase( iter );
-	}
+	olotApiLayer::Get().GetActionSets().Remove( actionSet );
 	return pNextXrDestroyActionSet( actionSet );
 }
 
@@ -450,16 +551,13 @@ XrResult olotInstance::CreateAction( XrActionSet actionSet,
 const XrActionCreateInfo *createInfo, XrAction *action ){
 	const XrResult result = pNextXrCreateAction( actionSet, createInfo, action );
 	if( XR_SUCCEEDED( result ) ){
-		olotApiLayer::Get().GetActions()[ *action ] = this;
+		olotApiLayer::Get().GetActions().Set( *action, this );
 	}
 	return result;
 }
 
 XrResult olotInstance::DestroyAction( XrAction action ){
-	olotApiLayer::MapActions::iterator iter( olotApiLayer::Get().GetActions().find( action ) );
-	if( iter != olotApiLayer::Get().GetActions().end() ){
-		olotApiLayer::Get().GetActions().erase( iter );
-	}
+	olotApiLayer::Get().GetActions().Remove( action );
 	return pNextXrDestroyAction( action );
 }
 
@@ -467,8 +565,12 @@ XrResult olotInstance::CreateActionSpace( XrSession session,
 const XrActionSpaceCreateInfo *createInfo, XrSpace *space ){
 	const XrResult result = pNextXrCreateActionSpace( session, createInfo, space );
 	if( XR_SUCCEEDED( result ) ){
-		olotApiLayer::Get().GetSpaces()[ *space ] =
-			{ *space, this, createInfo->action, createInfo->subactionPath };
+		olotApiLayer::Get().GetSpaces().Set( *space,
+			{ *space, this, createInfo->action, createInfo->subactionPath } );
+		
+		if( pEyeGazeTracker && pEyeGazeTracker->Matches( createInfo->action, createInfo->subactionPath ) ){
+			olotApiLayer::Get().SetGazeSpace( *space, true );
+		}
 	}
 	return result;
 }
@@ -477,22 +579,24 @@ XrResult olotInstance::CreateReferenceSpace( XrSession session,
 const XrReferenceSpaceCreateInfo *createInfo, XrSpace *space ){
 	const XrResult result = pNextXrCreateReferenceSpace( session, createInfo, space );
 	if( XR_SUCCEEDED( result ) ){
-		olotApiLayer::Get().GetSpaces()[ *space ] =
-			{ *space, this, XR_NULL_HANDLE, XR_NULL_PATH };
+		olotApiLayer::Get().GetSpaces().Set( *space,
+			{ *space, this, XR_NULL_HANDLE, XR_NULL_PATH } );
 	}
 	return result;
 }
 
 XrResult olotInstance::DestroySpace( XrSpace space ){
-	olotApiLayer::MapSpaces::iterator iter( olotApiLayer::Get().GetSpaces().find( space ) );
-	if( iter != olotApiLayer::Get().GetSpaces().end() ){
-		olotApiLayer::Get().GetSpaces().erase( iter );
-	}
+	olotApiLayer::Get().GetSpaces().Remove( space );
+	olotApiLayer::Get().SetGazeSpace( space, false );
 	return pNextXrDestroySpace( space );
 }
 
 XrResult olotInstance::GetActionStatePose( XrSession session,
 const XrActionStateGetInfo *getInfo, XrActionStatePose *state ){
+	if( ! getInfo || ! state ){
+		return XR_ERROR_VALIDATION_FAILURE;
+	}
+	
 	if( pEyeGazeTracker && pEyeGazeTracker->Matches( getInfo->action, getInfo->subactionPath ) ){
 		return pEyeGazeTracker->GetActionStatePose( *state );
 	}
@@ -503,12 +607,31 @@ const XrActionStateGetInfo *getInfo, XrActionStatePose *state ){
 XrResult olotInstance::LocateSpace( const olotSpace &space, XrSpace baseSpace,
 XrTime time, XrSpaceLocation* location ){
 	if( pEyeGazeTracker && pEyeGazeTracker->Matches( space.action, space.subactionPath ) ){
+		if( ! location ){
+			return XR_ERROR_VALIDATION_FAILURE;
+		}
 		return pEyeGazeTracker->LocateSpace( space, baseSpace, time, location );
 	}
 	
 	return pNextXrLocateSpace( space.space, baseSpace, time, location );
 }
 
+XrResult olotInstance::SyncActions( XrSession session, const XrActionsSyncInfo *syncInfo ){
+	const XrResult result = pNextXrSyncActions( session, syncInfo );
+	UpdateSnapshot();
+	return result;
+}
+
+XrResult olotInstance::WaitFrame( XrSession session, const XrFrameWaitInfo *frameWaitInfo,
+XrFrameState *frameState ){
+	const XrResult result = pNextXrWaitFrame( session, frameWaitInfo, frameState );
+	if( XR_SUCCEEDED( result ) && ! pXrTimeConverted ){
+		pCalibrateXrTimeOffset( *frameState );
+	}
+	UpdateSnapshot();
+	return result;
+}
+
 XrResult olotInstance::CreateFacialTracker( XrSession /*session*/,
 const XrFacialTrackerCreateInfoHTC *createInfo, XrFacialTrackerHTC *facialTracker ){
 	OLOTASSERT_TRUE( pEnableFacial, XR_ERROR_FEATURE_UNSUPPORTED )
@@ -533,8 +656,65 @@ XrResult olotInstance::DestroyFacialTracker( olotFacialTracker *facialTracker ){
 	return XR_SUCCESS;
 }
 
+XrResult olotInstance::CreateFaceTrackerFB( XrSession /*session*/,
+const XrFaceTrackerCreateInfoFB *createInfo, XrFaceTrackerFB *faceTracker ){
+	OLOTASSERT_TRUE( pEnableFaceTrackingFB, XR_ERROR_FEATURE_UNSUPPORTED )
+	OLOTASSERT_NOTNULL( createInfo, XR_ERROR_VALIDATION_FAILURE )
+	OLOTASSERT_NOTNULL( faceTracker, XR_ERROR_VALIDATION_FAILURE )
+	
+	const olotFaceTrackerFB::Ref ft( std::make_shared<olotFaceTrackerFB>( *this, *createInfo ) );
+	pFaceTrackersFB.push_back( ft );
+	*faceTracker = ( XrFaceTrackerFB )ft.get();
+	return XR_SUCCESS;
+}
+
+XrResult olotInstance::DestroyFaceTrackerFB( olotFaceTrackerFB *faceTracker ){
+	OLOTASSERT_NOTNULL( faceTracker, XR_ERROR_RUNTIME_FAILURE )
+	
+	ListFaceTrackersFB::iterator iter;
+	for( iter = pFaceTrackersFB.begin(); iter != pFaceTrackersFB.end(); iter++ ){
+		if( iter->get() == faceTracker ){
+			pFaceTrackersFB.erase( iter );
+			break;
+		}
+	}
+	
+	return XR_SUCCESS;
+}
+
 
 
+void olotInstance::UpdateSnapshot(){
+	if( ! pEnableEyeGaze && ! pEnableFacial && ! pEnableFaceTrackingFB ){
+		return;
+	}
+	
+	olotOcsClient * const ocsClient = olotApiLayer::Get().GetOcsClient();
+	if( ! ocsClient ){
+		return;
+	}
+	
+	// xrWaitFrame and xrSyncActions can be called from different threads. only writers
+	// are serialized. readers never block. the expression frame is computed once per
+	// published snapshot no matter how many trackers or extensions read it
+	const std::lock_guard<std::mutex> guard( pMutexSnapshot );
+	const uint32_t version = pSnapshotWork.version;
+	ocsClient->GetSnapshot( pSnapshotWork );
+	if( pSnapshotWork.version != version ){
+		olotExpressionFrame::Compute( pSnapshotWork, ocsClient->GetHistory(),
+			pMappingEye.get(), pMappingLip.get(), pFrameWork );
+		pFrame.Store( pFrameWork );
+	}
+	pSnapshotTaken.store( true, std::memory_order_release );
+}
+
+void olotInstance::GetExpressionFrame( olotExpressionFrame::sFrame &frame ){
+	if( ! pSnapshotTaken.load( std::memory_order_acquire ) ){
+		UpdateSnapshot();
+	}
+	pFrame.Load( frame );
+}
+
 XrPath olotInstance::GetXrPathFor( const std::string &path ) const{
 	XrPath xrp = XR_NULL_PATH;
 	OLOTASSERT_SUCCESS( pXrStringToPath( pInstance, path.c_str(), &xrp ) )
@@ -553,3 +733,78 @@ std::ostream &olotInstance::log(){
 
 void olotInstance::pCleanUp(){
 }
+
+void olotInstance::pLoadProfile(){
+	// profiles are compiled once per instance. facial trackers share the mappings
+	olotExpressionProfile profile;
+	
+	const std::string &path = olotApiLayer::Get().GetConfig().GetProfile();
+	if( ! path.empty() ){
+		profile.LoadFromFile( path );
+	}
+	
+	pMappingEye = profile.CompileEyeMapping();
+	pMappingLip = profile.CompileLipMapping();
+}
+
+void olotInstance::pInitXrTimeOffset(){
+	// the offset is constant since XR_KHR_convert_timespec_time is defined using
+	// CLOCK_MONOTONIC. converting once avoids calling into the runtime per conversion
+	if( pNextXrConvertTimespecTimeToTime ){
+		timespec now;
+		clock_gettime( CLOCK_MONOTONIC, &now );
+		
+		XrTime time;
+		if( XR_SUCCEEDED( pNextXrConvertTimespecTimeToTime( pInstance, &now, &time ) ) ){
+			pXrTimeOffset.store( ( int64_t )time - olotClock::FromTimespec( now ), std::memory_order_relaxed );
+			pXrTimeConverted = true;
+		}
+	}
+	
+	if( pXrTimeConverted ){
+		OLOTLOG_INFO( log(), "XrTime offset from XR_KHR_convert_timespec_time: "
+			<< pXrTimeOffset.load( std::memory_order_relaxed ) << "ns" );
+		
+	}else{
+		OLOTLOG_INFO( log(), "XR_KHR_convert_timespec_time not supported. Calibrating XrTime offset" );
+	}
+}
+
+void olotInstance::pCalibrateXrTimeOffset( const XrFrameState &frameState ){
+	// the predicted display time is in the future by at least one display period. the
+	// smallest lead beyond the display period seen so far is the closest estimate of the
+	// offset. if it is small the runtime uses CLOCK_MONOTONIC as XrTime like most Linux
+	// runtimes do. without a display period the lead can not be separated from the offset
+	const int64_t period = ( int64_t )frameState.predictedDisplayPeriod;
+	if( period <= 0 ){
+		return;
+	}
+	
+	const int64_t lead = ( int64_t )frameState.predictedDisplayTime - period - olotClock::Now();
+	if( lead >= pXrTimeMinLead ){
+		return;
+	}
+	
+	const bool first = pXrTimeMinLead == INT64_MAX;
+	pXrTimeMinLead = lead;
+	
+	const int64_t offset = lead > -1000000000LL && lead < 1000000000LL ? 0 : lead;
+	if( offset == pXrTimeOffset.load( std::memory_order_relaxed ) && ! first ){
+		return;
+	}
+	
+	pXrTimeOffset.store( offset, std::memory_order_relaxed );
+	
+	OLOTLOG_INFO( log(), "XrTime offset calibrated: " << offset << "ns" );
+}
+
+// suggested eye gaze bindings can change after action spaces have been created. tag all
+// action spaces of this instance again
+void olotInstance::pUpdateGazeSpaces(){
+	olotApiLayer &apiLayer = olotApiLayer::Get();
+	apiLayer.GetSpaces().ForEach( [ this, &apiLayer ]( const olotSpace &space ){
+		if( space.instance == this && space.action != XR_NULL_HANDLE ){
+			apiLayer.SetGazeSpace( space.space, pEyeGazeTracker->Matches( space.action, space.subactionPath ) );
+		}
+	} );
+}
@@ -28,12 +28,24 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <mutex>
+#include <atomic>
 
 #include "openxr/openxr.h"
 
+#ifndef XR_USE_TIMESPEC
+#define XR_USE_TIMESPEC
+#endif
+#include "openxr/openxr_platform.h"
+
 #include "olotEyeGazeTracker.h"
 #include "olotFacialTracker.h"
+#include "olotFaceTrackerFB.h"
+#include "olotExpressionFrame.h"
 #include "olotStructs.h"
+#include "olotOcsClient.h"
+#include "olotExpressionMapping.h"
+#include "utils/olotSeqLock.h"
 
 
 /**
@@ -47,6 +59,15 @@ public:
 	/** Facial trackers map. */
 	typedef std::vector<olotFacialTracker::Ref> ListFacialTrackers;
 	
+	/** FB face trackers map. */
+	typedef std::vector<olotFaceTrackerFB::Ref> ListFaceTrackersFB;
+	
+	/** Number of slots of the hooked function table and the next function cache. */
+	const static int HookTableSize = 64;
+	
+	/** Number of next function cache slots probed per lookup. */
+	const static int NextFunctionProbes = 4;
+	
 	
 	
 private:
@@ -57,6 +78,7 @@ private:
 	
 	bool pEnableEyeGaze;
 	bool pEnableFacial;
+	bool pEnableFaceTrackingFB;
 	
 	PFN_xrGetInstanceProcAddr const pNextXrGetInstanceProcAddr;
 	
@@ -76,11 +98,34 @@ private:
 	PFN_xrDestroyActionSet pNextXrDestroyActionSet;
 	PFN_xrCreateAction pNextXrCreateAction;
 	PFN_xrDestroyAction pNextXrDestroyAction;
+	PFN_xrSyncActions pNextXrSyncActions;
+	PFN_xrWaitFrame pNextXrWaitFrame;
+	PFN_xrConvertTimespecTimeToTimeKHR pNextXrConvertTimespecTimeToTime;
 	
 	XrPath pPathProfileEyeGaze;
 	
 	olotEyeGazeTracker::Ref pEyeGazeTracker;
 	ListFacialTrackers pFacialTrackers;
+	ListFaceTrackersFB pFaceTrackersFB;
+	olotExpressionMapping::Ref pMappingEye;
+	olotExpressionMapping::Ref pMappingLip;
+	
+	std::mutex pMutexSnapshot;
+	olotOcsClient::sSnapshot pSnapshotWork;
+	olotExpressionFrame::sFrame pFrameWork;
+	olotSeqLockValue<olotExpressionFrame::sFrame> pFrame;
+	std::atomic<bool> pSnapshotTaken;
+	
+	std::atomic<int64_t> pXrTimeOffset;
+	bool pXrTimeConverted;
+	int64_t pXrTimeMinLead;
+	
+	struct sNextFunction{
+		std::atomic<uint64_t> hash;
+		std::atomic<PFN_xrVoidFunction> function;
+	};
+	
+	mutable sNextFunction pNextFunctions[ HookTableSize ];
 	
 	
 	
@@ -105,8 +150,13 @@ public:
 	/** Instance. */
 	inline XrInstance GetInstance() const{ return pInstance; }
 	
-	/** Get function. */
-	XrResult GetInstanceProcAddr( const std::string &name, PFN_xrVoidFunction *function ) const;
+	/**
+	 * Get function.
+	 * 
+	 * Hooked functions are found using a compile time perfect hash. Functions resolved
+	 * by the next layer are cached to avoid walking down the layer chain again.
+	 */
+	XrResult GetInstanceProcAddr( const char *name, PFN_xrVoidFunction *function ) const;
 	
 	/** xrGetSystemProperties. */
 	XrResult GetSystemProperties( XrSystemId systemId, XrSystemProperties *properties );
@@ -156,6 +206,12 @@ public:
 	XrResult LocateSpace( const olotSpace &space, XrSpace baseSpace,
 		XrTime time, XrSpaceLocation *location );
 	
+	/** xrSyncActions. */
+	XrResult SyncActions( XrSession session, const XrActionsSyncInfo *syncInfo );
+	
+	/** xrWaitFrame. */
+	XrResult WaitFrame( XrSession session, const XrFrameWaitInfo *frameWaitInfo, XrFrameState *frameState );
+	
 	/** xrCreateFacialTrackerHTC. */
 	XrResult CreateFacialTracker( XrSession session,
 		const XrFacialTrackerCreateInfoHTC *createInfo, XrFacialTrackerHTC *facialTracker );
@@ -163,11 +219,37 @@ public:
 	/** xrDestroyFacialTrackerHTC. */
 	XrResult DestroyFacialTracker( olotFacialTracker *facialTracker );
 	
+	/** xrCreateFaceTrackerFB. */
+	XrResult CreateFaceTrackerFB( XrSession session,
+		const XrFaceTrackerCreateInfoFB *createInfo, XrFaceTrackerFB *faceTracker );
 	
+	/** xrDestroyFaceTrackerFB. */
+	XrResult DestroyFaceTrackerFB( olotFaceTrackerFB *faceTracker );
+	
+	
+	
+	/**
+	 * Convert XrTime to CLOCK_MONOTONIC nanoseconds.
+	 * 
+	 * XrTime and CLOCK_MONOTONIC differ by a constant offset. The offset is obtained using
+	 * XR_KHR_convert_timespec_time if supported by the runtime. Otherwise the offset is
+	 * calibrated using the predicted display times returned by xrWaitFrame.
+	 */
+	inline int64_t XrTimeToMonotonic( XrTime time ) const{
+		return ( int64_t )time - pXrTimeOffset.load( std::memory_order_relaxed );
+	}
+	
+	/** Convert CLOCK_MONOTONIC nanoseconds to XrTime. */
+	inline XrTime MonotonicToXrTime( int64_t time ) const{
+		return ( XrTime )( time + pXrTimeOffset.load( std::memory_order_relaxed ) );
+	}
 	
 	/** Get XrPath for string. */
 	XrPath GetXrPathFor( const std::string &path ) const;
 	
+	/** Next layer xrLocateSpace. */
+	inline PFN_xrLocateSpace GetNextXrLocateSpace() const{ return pNextXrLocateSpace; }
+	
 	/** Eye gazer tracker. */
 	inline olotEyeGazeTracker::Ref &GetEyeGazeTracker(){ return pEyeGazeTracker; }
 	inline const olotEyeGazeTracker::Ref &GetEyeGazeTracker() const{ return pEyeGazeTracker; }
@@ -176,6 +258,32 @@ public:
 	inline ListFacialTrackers &GetFacialTrackers(){ return pFacialTrackers; }
 	inline const ListFacialTrackers &GetFacialTrackers() const{ return pFacialTrackers; }
 	
+	/** FB face trackers. */
+	inline ListFaceTrackersFB &GetFaceTrackersFB(){ return pFaceTrackersFB; }
+	inline const ListFaceTrackersFB &GetFaceTrackersFB() const{ return pFaceTrackersFB; }
+	
+	/** Eye expression mapping compiled from the profile at instance creation. */
+	inline const olotExpressionMapping::Ref &GetMappingEye() const{ return pMappingEye; }
+	
+	/** Lip expression mapping compiled from the profile at instance creation. */
+	inline const olotExpressionMapping::Ref &GetMappingLip() const{ return pMappingLip; }
+	
+	/**
+	 * Update snapshot of OCS values.
+	 * 
+	 * Called once per frame by xrWaitFrame and xrSyncActions. If new values have been
+	 * published the expression frame is computed from them. All trackers read the same
+	 * expression frame until the next update.
+	 */
+	void UpdateSnapshot();
+	
+	/**
+	 * Copy expression frame.
+	 * 
+	 * Updates the snapshot first if no snapshot has been taken yet.
+	 */
+	void GetExpressionFrame( olotExpressionFrame::sFrame &frame );
+	
 	/** Log stream. */
 	std::ostream &log();
 	/*@}*/
@@ -184,6 +292,10 @@ public:
 	
 private:
 	void pCleanUp();
+	void pLoadProfile();
+	void pInitXrTimeOffset();
+	void pCalibrateXrTimeOffset( const XrFrameState &frameState );
+	void pUpdateGazeSpaces();
 };
 
 #endif
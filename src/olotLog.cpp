@@ -0,0 +1,65 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <strings.h>
+
+#include "olotLog.h"
+
+
+// Definitions
+////////////////
+
+static const char * const vLevelNames[] = { "trace", "debug", "info", "warning", "error" };
+
+
+
+// class olotLog
+//////////////////
+
+olotLog::eLevel olotLog::pLevel = olotLog::elInfo;
+
+
+
+// Management
+///////////////
+
+void olotLog::SetLevel( eLevel level ){
+	pLevel = level;
+}
+
+const char *olotLog::GetLevelName( eLevel level ){
+	return vLevelNames[ level ];
+}
+
+bool olotLog::ParseLevel( const char *name, eLevel &level ){
+	int i;
+	for( i=elTrace; i<=elError; i++ ){
+		if( strcasecmp( name, vLevelNames[ i ] ) == 0 ){
+			level = ( eLevel )i;
+			return true;
+		}
+	}
+	return false;
+}
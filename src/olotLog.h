@@ -0,0 +1,128 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _OLOTLOG_H_
+#define _OLOTLOG_H_
+
+#include <ostream>
+
+
+/**
+ * Lowest log level compiled into the library. Logging below this level is removed by the
+ * preprocessor. 0 is trace, 1 is debug, 2 is info, 3 is warning and 4 is error.
+ */
+#ifndef OLOT_LOG_COMPILED_LEVEL
+#define OLOT_LOG_COMPILED_LEVEL 0
+#endif
+
+
+/**
+ * Log levels.
+ * 
+ * The active level is set once from the configuration. Messages below the active level
+ * are not formatted. Use the OLOTLOG_* macros which skip evaluating the message arguments.
+ */
+class olotLog{
+public:
+	/** Log level. */
+	enum eLevel{
+		elTrace,
+		elDebug,
+		elInfo,
+		elWarning,
+		elError
+	};
+	
+	
+	
+private:
+	static eLevel pLevel;
+	
+	
+	
+public:
+	/** \name Management */
+	/*@{*/
+	/** Active level. */
+	static inline eLevel GetLevel(){ return pLevel; }
+	
+	/** Set active level. */
+	static void SetLevel( eLevel level );
+	
+	/** Messages of level are logged. */
+	static inline bool IsEnabled( eLevel level ){ return level >= pLevel; }
+	
+	/** Name of level. */
+	static const char *GetLevelName( eLevel level );
+	
+	/** Level from case insensitive name. Returns false if name is not a level. */
+	static bool ParseLevel( const char *name, eLevel &level );
+	/*@}*/
+};
+
+
+// macros expand to a single statement and have to be followed by a semicolon
+#define OLOTLOG_LEVEL( level, stream, message )\
+	do{\
+		if( olotLog::IsEnabled( level ) ){\
+			( stream ) << message << std::endl;\
+		}\
+	}while( false )
+
+// compiled out levels keep the arguments referenced. the statement is never executed
+#define OLOTLOG_DISABLED( stream, message )\
+	do{\
+		if( false ){\
+			( stream ) << message << std::endl;\
+		}\
+	}while( false )
+
+#if OLOT_LOG_COMPILED_LEVEL <= 0
+#define OLOTLOG_TRACE( stream, message ) OLOTLOG_LEVEL( olotLog::elTrace, stream, message )
+#else
+#define OLOTLOG_TRACE( stream, message ) OLOTLOG_DISABLED( stream, message )
+#endif
+
+#if OLOT_LOG_COMPILED_LEVEL <= 1
+#define OLOTLOG_DEBUG( stream, message ) OLOTLOG_LEVEL( olotLog::elDebug, stream, message )
+#else
+#define OLOTLOG_DEBUG( stream, message ) OLOTLOG_DISABLED( stream, message )
+#endif
+
+#if OLOT_LOG_COMPILED_LEVEL <= 2
+#define OLOTLOG_INFO( stream, message ) OLOTLOG_LEVEL( olotLog::elInfo, stream, message )
+#else
+#define OLOTLOG_INFO( stream, message ) OLOTLOG_DISABLED( stream, message )
+#endif
+
+#if OLOT_LOG_COMPILED_LEVEL <= 3
+#define OLOTLOG_WARNING( stream, message ) OLOTLOG_LEVEL( olotLog::elWarning, stream, message )
+#else
+#define OLOTLOG_WARNING( stream, message ) OLOTLOG_DISABLED( stream, message )
+#endif
+
+#define OLOTLOG_ERROR( stream, message ) OLOTLOG_LEVEL( olotLog::elError, stream, message )
+
+#endif
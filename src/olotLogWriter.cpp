@@ -0,0 +1,494 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <algorithm>
+#include <chrono>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+
+#include "olotLogWriter.h"
+#include "utils/olotClock.h"
+
+
+// Definitions
+////////////////
+
+// length of "[YYYY-MM-DD HH:MM:SS] "
+#define TIME_PREFIX_LENGTH 22
+
+// size of buffer used to format records before writing them to the file
+#define WRITE_BUFFER_SIZE 65536
+
+// number of attempts a signal handler tries to take over writing records
+#define SIGNAL_FLUSH_ATTEMPTS 1000000
+
+static const int vCrashSignals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+static const int vCrashSignalCount = sizeof( vCrashSignals ) / sizeof( vCrashSignals[ 0 ] );
+
+static struct sigaction vPreviousActions[ vCrashSignalCount ];
+static olotLogWriter *vCrashWriter = nullptr;
+
+
+// write all bytes retrying interrupted and partial writes. async-signal-safe
+static void writeFully( int file, const char *data, int length ){
+	while( length > 0 ){
+		const ssize_t written = write( file, data, length );
+		if( written < 0 ){
+			if( errno == EINTR ){
+				continue;
+			}
+			return;
+		}
+		data += written;
+		length -= ( int )written;
+	}
+}
+
+static inline char *formatDigits( char *out, unsigned int value, int digits ){
+	int i;
+	for( i=digits-1; i>=0; i-- ){
+		out[ i ] = '0' + ( char )( value % 10 );
+		value /= 10;
+	}
+	return out + digits;
+}
+
+// format realtime nanoseconds as local time prefix. uses the civil from days algorithm
+// instead of localtime which is neither fast nor async-signal-safe
+static void formatTime( char *out, int64_t time, int64_t utcOffset ){
+	const int64_t seconds = time / 1000000000LL + utcOffset;
+	int64_t days = seconds / 86400;
+	int64_t secondOfDay = seconds % 86400;
+	if( secondOfDay < 0 ){
+		secondOfDay += 86400;
+		days--;
+	}
+	
+	days += 719468;
+	const int64_t era = ( days >= 0 ? days : days - 146096 ) / 146097;
+	const unsigned int dayOfEra = ( unsigned int )( days - era * 146097 );
+	const unsigned int yearOfEra = ( dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096 ) / 365;
+	const unsigned int dayOfYear = dayOfEra - ( 365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100 );
+	const unsigned int monthShifted = ( 5 * dayOfYear + 2 ) / 153;
+	const unsigned int day = dayOfYear - ( 153 * monthShifted + 2 ) / 5 + 1;
+	const unsigned int month = monthShifted < 10 ? monthShifted + 3 : monthShifted - 9;
+	const unsigned int year = ( unsigned int )( ( int64_t )yearOfEra + era * 400 + ( month <= 2 ? 1 : 0 ) );
+	
+	*out++ = '[';
+	out = formatDigits( out, year, 4 );
+	*out++ = '-';
+	out = formatDigits( out, month, 2 );
+	*out++ = '-';
+	out = formatDigits( out, day, 2 );
+	*out++ = ' ';
+	out = formatDigits( out, ( unsigned int )( secondOfDay / 3600 ), 2 );
+	*out++ = ':';
+	out = formatDigits( out, ( unsigned int )( secondOfDay / 60 % 60 ), 2 );
+	*out++ = ':';
+	out = formatDigits( out, ( unsigned int )( secondOfDay % 60 ), 2 );
+	*out++ = ']';
+	*out = ' ';
+}
+
+static void crashHandler( int signal, siginfo_t *info, void * ){
+	if( vCrashWriter ){
+		vCrashWriter->FlushFromSignal();
+	}
+	
+	// restore the previous action so it runs with its own flags and mask. faults raised by
+	// the kernel happen again once this handler returns and reach the previous action with
+	// the original signal information. other signals are raised again and delivered as
+	// soon as this handler returns
+	int i;
+	for( i=0; i<vCrashSignalCount; i++ ){
+		if( vCrashSignals[ i ] == signal ){
+			sigaction( signal, &vPreviousActions[ i ], nullptr );
+			break;
+		}
+	}
+	
+	if( ! info || info->si_code <= 0 ){
+		raise( signal );
+	}
+}
+
+
+// Log stream buffer
+//////////////////////
+
+// stream buffer of thread local log stream. complete lines are added as records to the
+// log writer whenever the stream is flushed. lines longer than the buffer are split
+class cLogStreamBuffer : public std::streambuf{
+private:
+	olotLogWriter &pWriter;
+	char pBuffer[ olotLogWriter::MaxRecordLength ];
+	
+public:
+	cLogStreamBuffer( olotLogWriter &writer ) : pWriter( writer ){
+		setp( pBuffer, pBuffer + sizeof( pBuffer ) );
+	}
+	
+	~cLogStreamBuffer() override{
+		pAddLines();
+		if( pptr() > pbase() ){
+			pWriter.Add( pbase(), ( int )( pptr() - pbase() ) );
+		}
+	}
+	
+protected:
+	int overflow( int c ) override{
+		pAddLines();
+		
+		if( pptr() == epptr() ){
+			pWriter.Add( pbase(), ( int )( pptr() - pbase() ) );
+			setp( pBuffer, pBuffer + sizeof( pBuffer ) );
+		}
+		
+		if( ! traits_type::eq_int_type( c, traits_type::eof() ) ){
+			*pptr() = traits_type::to_char_type( c );
+			pbump( 1 );
+		}
+		return traits_type::not_eof( c );
+	}
+	
+	int sync() override{
+		pAddLines();
+		return 0;
+	}
+	
+private:
+	void pAddLines(){
+		char * const end = pptr();
+		char *start = pbase();
+		char *next;
+		
+		for( next=start; next<end; next++ ){
+			if( *next == '\n' ){
+				pWriter.Add( start, ( int )( next - start ) );
+				start = next + 1;
+			}
+		}
+		
+		// keep incomplete line
+		const int remaining = ( int )( end - start );
+		if( remaining > 0 && start != pBuffer ){
+			memmove( pBuffer, start, remaining );
+		}
+		setp( pBuffer, pBuffer + sizeof( pBuffer ) );
+		pbump( remaining );
+	}
+};
+
+
+
+// class olotLogWriter
+////////////////////////
+
+olotLogWriter::olotLogWriter( const char *path ) :
+pFile( -1 ),
+pSlots( nullptr ),
+pWriteBuffer( nullptr ),
+pHead( 0 ),
+pTail( 0 ),
+pConsuming( false ),
+pDropped( 0 ),
+pUtcOffset( 0 ),
+pUtcOffsetMinute( -1 ),
+pStop( false )
+{
+	pFile = open( path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+	
+	pSlots = new sSlot[ SlotCount ];
+	pWriteBuffer = new char[ WRITE_BUFFER_SIZE ];
+	
+	int i;
+	for( i=0; i<SlotCount; i++ ){
+		pSlots[ i ].sequence.store( ( uint64_t )i, std::memory_order_relaxed );
+	}
+	
+	pUpdateUtcOffset();
+	
+	pThread.reset( new std::thread( &olotLogWriter::pRunThread, this ) );
+}
+
+olotLogWriter::~olotLogWriter(){
+	if( vCrashWriter == this ){
+		int i;
+		for( i=0; i<vCrashSignalCount; i++ ){
+			sigaction( vCrashSignals[ i ], &vPreviousActions[ i ], nullptr );
+		}
+		vCrashWriter = nullptr;
+	}
+	
+	Stop();
+	
+	if( pFile != -1 ){
+		close( pFile );
+	}
+	delete [] pWriteBuffer;
+	delete [] pSlots;
+}
+
+
+
+// Management
+///////////////
+
+std::ostream &olotLogWriter::Stream(){
+	// the buffer is bound to this writer for the lifetime of the thread. see Stream()
+	// documentation for the lifetime requirement
+	thread_local cLogStreamBuffer buffer( *this );
+	thread_local std::ostream stream( &buffer );
+	return stream;
+}
+
+bool olotLogWriter::Add( const char *text, int length ){
+	length = std::min( std::max( length, 0 ), ( int )MaxRecordLength );
+	const uint64_t count = length > 0 ? ( uint64_t )( ( length + SlotTextSize - 1 ) / SlotTextSize ) : 1;
+	
+	// claim consecutive slots. the writer frees slots in order hence if the last slot is
+	// free all slots before it are free too
+	uint64_t head = pHead.load( std::memory_order_relaxed );
+	while( true ){
+		const uint64_t last = head + count - 1;
+		const int64_t difference = ( int64_t )( pSlots[ last & ( SlotCount - 1 ) ].sequence.load(
+			std::memory_order_acquire ) - last );
+		
+		if( difference == 0 ){
+			if( pHead.compare_exchange_weak( head, head + count, std::memory_order_relaxed ) ){
+				break;
+			}
+			
+		}else if( difference < 0 ){
+			pDropped.fetch_add( 1, std::memory_order_relaxed );
+			return false;
+			
+		}else{
+			head = pHead.load( std::memory_order_relaxed );
+		}
+	}
+	
+	sSlot &first = pSlots[ head & ( SlotCount - 1 ) ];
+	first.time = olotClock::RealtimeCoarse();
+	first.length = ( uint32_t )length;
+	first.count = ( uint32_t )count;
+	
+	uint64_t i;
+	for( i=0; i<count; i++ ){
+		sSlot &slot = pSlots[ ( head + i ) & ( SlotCount - 1 ) ];
+		const int offset = ( int )i * SlotTextSize;
+		memcpy( slot.text, text + offset, std::min( length - offset, ( int )SlotTextSize ) );
+		slot.sequence.store( head + i + 1, std::memory_order_release );
+	}
+	
+	// without writer thread records are written right away
+	if( pStop.load( std::memory_order_acquire ) ){
+		Flush();
+	}
+	
+	return true;
+}
+
+void olotLogWriter::Flush(){
+	while( pConsuming.exchange( true, std::memory_order_acquire ) ){
+		std::this_thread::yield();
+	}
+	
+	pWritePending();
+	pConsuming.store( false, std::memory_order_release );
+}
+
+void olotLogWriter::Stop(){
+	if( pThread ){
+		pStop.store( true, std::memory_order_release );
+		pThread->join();
+		pThread.reset();
+	}
+	
+	Flush();
+}
+
+void olotLogWriter::InstallCrashHandler(){
+	if( vCrashWriter ){
+		return;
+	}
+	
+	struct sigaction action = {};
+	action.sa_sigaction = crashHandler;
+	action.sa_flags = SA_SIGINFO;
+	sigemptyset( &action.sa_mask );
+	
+	vCrashWriter = this;
+	
+	int i;
+	for( i=0; i<vCrashSignalCount; i++ ){
+		sigaction( vCrashSignals[ i ], &action, &vPreviousActions[ i ] );
+	}
+}
+
+void olotLogWriter::FlushFromSignal(){
+	// the writing thread can not be waited for since it could be the crashed one
+	int i;
+	for( i=0; i<SIGNAL_FLUSH_ATTEMPTS; i++ ){
+		if( ! pConsuming.exchange( true, std::memory_order_acquire ) ){
+			pWritePending();
+			pConsuming.store( false, std::memory_order_release );
+			return;
+		}
+	}
+}
+
+
+
+// Private Functions
+//////////////////////
+
+void olotLogWriter::pRunThread(){
+	while( ! pStop.load( std::memory_order_acquire ) ){
+		pUpdateUtcOffset();
+		
+		bool written = false;
+		if( ! pConsuming.exchange( true, std::memory_order_acquire ) ){
+			written = pWritePending();
+			pConsuming.store( false, std::memory_order_release );
+		}
+		
+		if( ! written ){
+			std::this_thread::sleep_for( std::chrono::milliseconds( ( int )WriteInterval ) );
+		}
+	}
+}
+
+// write records until the first not fully written one. caller has to own pConsuming.
+// async-signal-safe
+bool olotLogWriter::pWritePending(){
+	char * const buffer = pWriteBuffer;
+	const int size = WRITE_BUFFER_SIZE;
+	const int64_t utcOffset = pUtcOffset.load( std::memory_order_relaxed );
+	uint64_t tail = pTail.load( std::memory_order_relaxed );
+	bool written = false;
+	int used = 0;
+	
+	while( true ){
+		const sSlot &first = pSlots[ tail & ( SlotCount - 1 ) ];
+		if( first.sequence.load( std::memory_order_acquire ) != tail + 1 ){
+			break;
+		}
+		
+		const uint32_t count = first.count;
+		uint32_t i;
+		for( i=1; i<count; i++ ){
+			if( pSlots[ ( tail + i ) & ( SlotCount - 1 ) ].sequence.load(
+					std::memory_order_acquire ) != tail + i + 1 ){
+				break;
+			}
+		}
+		if( i < count ){
+			break;
+		}
+		
+		const int length = ( int )first.length;
+		if( used + TIME_PREFIX_LENGTH + length + 1 > size ){
+			if( pFile != -1 ){
+				writeFully( pFile, buffer, used );
+			}
+			used = 0;
+		}
+		
+		formatTime( buffer + used, first.time, utcOffset );
+		used += TIME_PREFIX_LENGTH;
+		
+		for( i=0; i<count; i++ ){
+			const int offset = ( int )i * SlotTextSize;
+			const int chunk = std::min( length - offset, ( int )SlotTextSize );
+			memcpy( buffer + used, pSlots[ ( tail + i ) & ( SlotCount - 1 ) ].text, chunk );
+			used += chunk;
+		}
+		buffer[ used++ ] = '\n';
+		
+		for( i=0; i<count; i++ ){
+			pSlots[ ( tail + i ) & ( SlotCount - 1 ) ].sequence.store(
+				tail + i + SlotCount, std::memory_order_release );
+		}
+		
+		tail += count;
+		written = true;
+	}
+	
+	pTail.store( tail, std::memory_order_relaxed );
+	
+	const uint64_t dropped = pDropped.exchange( 0, std::memory_order_relaxed );
+	if( dropped > 0 ){
+		if( used + TIME_PREFIX_LENGTH + 48 > size ){
+			if( pFile != -1 ){
+				writeFully( pFile, buffer, used );
+			}
+			used = 0;
+		}
+		
+		formatTime( buffer + used, olotClock::RealtimeCoarse(), utcOffset );
+		used += TIME_PREFIX_LENGTH;
+		
+		char digits[ 20 ];
+		uint64_t value = dropped;
+		int digitCount = 0;
+		do{
+			digits[ digitCount++ ] = '0' + ( char )( value % 10 );
+			value /= 10;
+		}while( value > 0 );
+		while( digitCount > 0 ){
+			buffer[ used++ ] = digits[ --digitCount ];
+		}
+		
+		static const char message[] = " log records dropped\n";
+		memcpy( buffer + used, message, sizeof( message ) - 1 );
+		used += sizeof( message ) - 1;
+	}
+	
+	if( used > 0 && pFile != -1 ){
+		writeFully( pFile, buffer, used );
+	}
+	
+	return written;
+}
+
+// local time offset is refreshed once per minute to follow daylight saving changes
+void olotLogWriter::pUpdateUtcOffset(){
+	const time_t now = time( nullptr );
+	const int64_t minute = ( int64_t )now / 60;
+	if( minute == pUtcOffsetMinute ){
+		return;
+	}
+	
+	tm local;
+	if( localtime_r( &now, &local ) ){
+		pUtcOffset.store( local.tm_gmtoff, std::memory_order_relaxed );
+	}
+	pUtcOffsetMinute = minute;
+}
@@ -0,0 +1,158 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _OLOTLOGWRITER_H_
+#define _OLOTLOGWRITER_H_
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <ostream>
+#include <stdint.h>
+
+
+/**
+ * Asynchronous log writer.
+ * 
+ * Threads write log lines to a thread local stream. Each completed line is stored as a
+ * record in a lock-free multi-producer ring buffer together with a coarse realtime
+ * timestamp. A background thread formats the timestamps and writes the records to the
+ * log file. Logging never blocks. If the ring buffer is full records are dropped and
+ * counted. Pending records are written when the writer is stopped and, if the crash
+ * handler is installed, when a crash signal is received.
+ */
+class olotLogWriter{
+public:
+	/** Number of ring buffer slots. Has to be a power of two. */
+	const static int SlotCount = 1024;
+	
+	/** Size in bytes of slot. */
+	const static int SlotSize = 256;
+	
+	/** Maximum number of slots used by a single record. Longer records are truncated. */
+	const static int MaxRecordSlots = 16;
+	
+	/** Interval in milliseconds the writer thread checks for new records. */
+	const static int WriteInterval = 10;
+	
+	
+	
+private:
+	struct sSlot{
+		std::atomic<uint64_t> sequence;
+		int64_t time;
+		uint32_t length;
+		uint32_t count;
+		char text[ SlotSize - 24 ];
+	};
+	
+	
+	
+public:
+	/** Text size of slot. */
+	const static int SlotTextSize = sizeof( sSlot::text );
+	
+	/** Maximum length of record. */
+	const static int MaxRecordLength = SlotTextSize * MaxRecordSlots;
+	
+	
+	
+private:
+	int pFile;
+	sSlot *pSlots;
+	char *pWriteBuffer;
+	alignas( 64 ) std::atomic<uint64_t> pHead;
+	alignas( 64 ) std::atomic<uint64_t> pTail;
+	std::atomic<bool> pConsuming;
+	std::atomic<uint64_t> pDropped;
+	std::atomic<int64_t> pUtcOffset;
+	int64_t pUtcOffsetMinute;
+	std::atomic<bool> pStop;
+	std::unique_ptr<std::thread> pThread;
+	
+	
+	
+public:
+	/** \name Constructors and Destructors */
+	/*@{*/
+	/** Create log writer truncating file and start writer thread. */
+	olotLogWriter( const char *path );
+	
+	/** Write pending records and clean up log writer. */
+	~olotLogWriter();
+	/*@}*/
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/**
+	 * Thread local log stream.
+	 * 
+	 * Each line written to the stream becomes one record. Lines are stored when the stream
+	 * is flushed, for example using std::endl.
+	 * 
+	 * The stream of a thread is bound to the first writer it is requested from. The writer
+	 * has to outlive all threads using the stream. Use Stop() instead of destroying it.
+	 */
+	std::ostream &Stream();
+	
+	/**
+	 * Add record. Lock-free and never blocks.
+	 * 
+	 * Text is truncated to MaxRecordLength. Returns false if the record has been dropped.
+	 */
+	bool Add( const char *text, int length );
+	
+	/** Write pending records. Safe to be called from any thread. */
+	void Flush();
+	
+	/**
+	 * Stop writer thread and write pending records.
+	 * 
+	 * Records added afterwards are written right away by the adding thread.
+	 */
+	void Stop();
+	
+	/**
+	 * Install handlers writing pending records on crash signals.
+	 * 
+	 * Previously installed actions are restored after writing and handle the signal.
+	 */
+	void InstallCrashHandler();
+	
+	/** Write pending records from a signal handler. */
+	void FlushFromSignal();
+	/*@}*/
+	
+	
+	
+private:
+	void pRunThread();
+	bool pWritePending();
+	void pUpdateUtcOffset();
+};
+
+#endif
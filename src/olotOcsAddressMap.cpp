@@ -0,0 +1,138 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "olotOcsAddressMap.h"
+#include "olotOcsClient.h"
+#include "utils/olotPerfectHash.h"
+
+
+// Definitions
+////////////////
+
+typedef olotOcsAddressMap::sChannel sChannel;
+
+static constexpr sChannel vChannels[] = {
+	{ "/cheekPuffLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeCheekPuffLeft },
+	{ "/cheekPuffRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeCheekPuffRight },
+	{ "/cheekSuckLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeCheekSuckLeft },
+	{ "/cheekSuckRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeCheekSuckRight },
+	{ "/jawOpen", olotOcsAddressMap::ectExpression, olotOcsClient::eeJawOpen },
+	{ "/jawForward", olotOcsAddressMap::ectExpression, olotOcsClient::eeJawForward },
+	{ "/jawLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeJawLeft },
+	{ "/jawRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeJawRight },
+	{ "/noseSneerLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeNoseSneerLeft },
+	{ "/noseSneerRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeNoseSneerRight },
+	{ "/mouthFunnel", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthFunnel },
+	{ "/mouthPucker", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthPucker },
+	{ "/mouthLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthLeft },
+	{ "/mouthRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthRight },
+	{ "/mouthRollUpper", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthRollUpper },
+	{ "/mouthRollLower", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthRollLower },
+	{ "/mouthShrugUpper", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthShrugUpper },
+	{ "/mouthShrugLower", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthShrugLower },
+	{ "/mouthClose", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthClose },
+	{ "/mouthSmileLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthSmileLeft },
+	{ "/mouthSmileRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthSmileRight },
+	{ "/mouthFrownLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthFrownLeft },
+	{ "/mouthFrownRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthFrownRight },
+	{ "/mouthDimpleLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthDimpleLeft },
+	{ "/mouthDimpleRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthDimpleRight },
+	{ "/mouthUpperUpLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthUpperUpLeft },
+	{ "/mouthUpperUpRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthUpperUpRight },
+	{ "/mouthLowerDownLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthLowerDownLeft },
+	{ "/mouthLowerDownRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthLowerDownRight },
+	{ "/mouthPressLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthPressLeft },
+	{ "/mouthPressRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthPressRight },
+	{ "/mouthStretchLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthStretchLeft },
+	{ "/mouthStretchRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeMouthStretchRight },
+	{ "/tongueOut", olotOcsAddressMap::ectExpression, olotOcsClient::eeTongueOut },
+	{ "/tongueUp", olotOcsAddressMap::ectExpression, olotOcsClient::eeTongueUp },
+	{ "/tongueDown", olotOcsAddressMap::ectExpression, olotOcsClient::eeTongueDown },
+	{ "/tongueLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeTongueLeft },
+	{ "/tongueRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeTongueRight },
+	{ "/tongueRoll", olotOcsAddressMap::ectExpression, olotOcsClient::eeTongueRoll },
+	{ "/tongueBendDown", olotOcsAddressMap::ectExpression, olotOcsClient::eeTongueBendDown },
+	{ "/tongueCurlUp", olotOcsAddressMap::ectExpression, olotOcsClient::eeTongueCurlUp },
+	{ "/tongueSquish", olotOcsAddressMap::ectExpression, olotOcsClient::eeTongueSquish },
+	{ "/tongueFlat", olotOcsAddressMap::ectExpression, olotOcsClient::eeTongueFlat },
+	{ "/tongueTwistLeft", olotOcsAddressMap::ectExpression, olotOcsClient::eeTongueTwistLeft },
+	{ "/tongueTwistRight", olotOcsAddressMap::ectExpression, olotOcsClient::eeTongueTwistRight },
+	{ "/leftEyeLidExpandedSqueeze", olotOcsAddressMap::ectExpression, olotOcsClient::eeLeftEyeLidExpandedSqueeze },
+	{ "/rightEyeLidExpandedSqueeze", olotOcsAddressMap::ectExpression, olotOcsClient::eeRightEyeLidExpandedSqueeze },
+	{ "/leftEyeX", olotOcsAddressMap::ectEyeState, olotOcsClient::eesLeftEyeX },
+	{ "/rightEyeX", olotOcsAddressMap::ectEyeState, olotOcsClient::eesRightEyeX },
+	{ "/eyesY", olotOcsAddressMap::ectEyeState, olotOcsClient::eesEyesY },
+};
+
+static constexpr int vChannelCount = ( int )( sizeof( vChannels ) / sizeof( sChannel ) );
+
+static_assert( vChannelCount == olotOcsClient::ExpressionCount + olotOcsClient::EyeStateCount,
+	"channel table does not cover all expressions and eye states" );
+
+// the perfect hash is built over the addresses of the channel table
+struct sAddresses{
+	const char *names[ vChannelCount ];
+};
+
+static constexpr sAddresses buildAddresses(){
+	sAddresses addresses{};
+	int i = 0;
+	for( i=0; i<vChannelCount; i++ ){
+		addresses.names[ i ] = vChannels[ i ].address;
+	}
+	return addresses;
+}
+
+static constexpr sAddresses vAddresses = buildAddresses();
+
+typedef olotPerfectHash<vChannelCount, olotOcsAddressMap::TableSize, olotPerfectHashCaseless> AddressHash;
+static constexpr AddressHash vAddressHash( vAddresses.names );
+
+static_assert( vAddressHash.IsValid(), "no perfect hash seed found for channel table" );
+
+
+
+// class olotOcsAddressMap
+////////////////////////////
+
+// Management
+///////////////
+
+const sChannel *olotOcsAddressMap::Find( const char *address, size_t length ){
+	const int index = vAddressHash.Find( address, length );
+	if( index == -1 ){
+		return nullptr;
+	}
+	
+	const sChannel &channel = vChannels[ index ];
+	size_t i;
+	for( i=0; i<length; i++ ){
+		if( ! channel.address[ i ] || olotPerfectHashCaseless::Fold( channel.address[ i ] )
+		!= olotPerfectHashCaseless::Fold( address[ i ] ) ){
+			return nullptr;
+		}
+	}
+	
+	return channel.address[ length ] ? nullptr : &channel;
+}
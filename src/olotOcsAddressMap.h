@@ -0,0 +1,65 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _OLOTOCSADDRESSMAP_H_
+#define _OLOTOCSADDRESSMAP_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/**
+ * Maps OCS addresses to channels.
+ * 
+ * Uses a perfect hash table generated at compile time over all known addresses. Lookups
+ * are case insensitive, do not allocate memory and require a single table probe.
+ */
+class olotOcsAddressMap{
+public:
+	/** Channel type. */
+	enum eChannelType{
+		ectExpression,
+		ectEyeState
+	};
+	
+	/** Channel. */
+	struct sChannel{
+		const char *address;
+		eChannelType type;
+		int index;
+	};
+	
+	/** Number of hash table slots. Has to be a power of two. */
+	const static int TableSize = 512;
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/** Channel matching address or nullptr if address is not known. */
+	static const sChannel *Find( const char *address, size_t length );
+	/*@}*/
+};
+
+#endif
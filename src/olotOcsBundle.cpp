@@ -0,0 +1,213 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <string.h>
+
+#include "olotOcsBundle.h"
+#include "exceptions/exceptions.h"
+
+
+// Definitions
+////////////////
+
+static const char * const vBundleTag = "#bundle";
+static const size_t vBundleTagLength = 8; // including null terminator
+static const size_t vBundleHeaderLength = vBundleTagLength + 8;
+
+static inline uint32_t readUInt32( const uint8_t *data ){
+	return ( uint32_t )data[ 0 ] << 24
+		| ( ( uint32_t )data[ 1 ] << 16 )
+		| ( ( uint32_t )data[ 2 ] << 8 )
+		| ( ( uint32_t )data[ 3 ] );
+}
+
+
+
+// class olotOcsBundle
+////////////////////////
+
+olotOcsBundle::olotOcsBundle() :
+pMessageCount( 0 ),
+pSourceCount( 0 ),
+pSourceReplace( 0 ),
+pDroppedCount( 0 )
+{
+	pMessages.resize( 64 );
+}
+
+olotOcsBundle::~olotOcsBundle(){
+}
+
+
+
+// Management
+///////////////
+
+bool olotOcsBundle::Parse( const uint8_t *data, size_t length, int64_t receiveTime, uint64_t source ){
+	OLOTASSERT_NOTNULL( data, XR_ERROR_RUNTIME_FAILURE )
+	
+	// messages of a packet are either all appended or none of them
+	const int restoreCount = pMessageCount;
+	if( ! pParseElement( data, length, 0, receiveTime, source ) ){
+		pMessageCount = restoreCount;
+		return false;
+	}
+	return true;
+}
+
+void olotOcsBundle::Clear(){
+	pMessageCount = 0;
+}
+
+const olotOcsMessage &olotOcsBundle::GetMessageAt( int index ) const{
+	OLOTASSERT_TRUE( index >= 0, XR_ERROR_RUNTIME_FAILURE )
+	OLOTASSERT_TRUE( index < pMessageCount, XR_ERROR_RUNTIME_FAILURE )
+	return pMessages[ index ];
+}
+
+uint64_t olotOcsBundle::GetLatestTimetag( uint64_t source ) const{
+	int i;
+	for( i=0; i<pSourceCount; i++ ){
+		if( pSources[ i ].source == source ){
+			return pSources[ i ].latestTimetag;
+		}
+	}
+	return 0;
+}
+
+int olotOcsBundle::TakeDroppedCount(){
+	const int count = pDroppedCount;
+	pDroppedCount = 0;
+	return count;
+}
+
+
+
+// Private Functions
+//////////////////////
+
+bool olotOcsBundle::pParseElement( const uint8_t *data, size_t length, int depth,
+int64_t receiveTime, uint64_t source ){
+	if( length == 0 ){
+		return false;
+	}
+	
+	switch( data[ 0 ] ){
+	case '#':
+		return pParseBundle( data, length, depth, receiveTime, source );
+		
+	case '/':
+		return pParseMessage( data, length, receiveTime );
+		
+	default:
+		return false;
+	}
+}
+
+bool olotOcsBundle::pParseBundle( const uint8_t *data, size_t length, int depth,
+int64_t receiveTime, uint64_t source ){
+	if( depth == MaxDepth || length < vBundleHeaderLength ){
+		return false;
+	}
+	if( memcmp( data, vBundleTag, vBundleTagLength ) != 0 ){
+		return false;
+	}
+	
+	// timetag is a 64-bit NTP timestamp. the nested bundles are required to have a timetag
+	// equal or later than the enclosing bundle hence only the top level bundle is checked.
+	// each source has its own clock so timetags are only compared within the same source.
+	// a large jump back is a clock step or a restarted sender and starts over
+	const uint64_t timetag = ( ( uint64_t )readUInt32( data + vBundleTagLength ) << 32 )
+		| ( uint64_t )readUInt32( data + vBundleTagLength + 4 );
+	
+	const bool checkTimetag = depth == 0 && timetag != TimetagImmediately;
+	if( checkTimetag ){
+		const uint64_t latestTimetag = pGetSource( source ).latestTimetag;
+		if( timetag < latestTimetag && latestTimetag - timetag < TimetagResetJump ){
+			pDroppedCount++;
+			return false;
+		}
+	}
+	
+	size_t i = vBundleHeaderLength;
+	while( i < length ){
+		if( length - i < 4 ){
+			return false;
+		}
+		
+		const size_t elementLength = readUInt32( data + i );
+		i += 4;
+		
+		if( elementLength % 4 != 0 || elementLength > length - i ){
+			return false;
+		}
+		if( ! pParseElement( data + i, elementLength, depth + 1, receiveTime, source ) ){
+			return false;
+		}
+		
+		i += elementLength;
+	}
+	
+	if( checkTimetag ){
+		pGetSource( source ).latestTimetag = timetag;
+	}
+	return true;
+}
+
+olotOcsBundle::sSource &olotOcsBundle::pGetSource( uint64_t source ){
+	int i;
+	for( i=0; i<pSourceCount; i++ ){
+		if( pSources[ i ].source == source ){
+			return pSources[ i ];
+		}
+	}
+	
+	// more sources than tracked replace the entries in round robin order
+	if( pSourceCount < MaxSources ){
+		i = pSourceCount++;
+		
+	}else{
+		i = pSourceReplace;
+		pSourceReplace = ( pSourceReplace + 1 ) % MaxSources;
+	}
+	
+	pSources[ i ].source = source;
+	pSources[ i ].latestTimetag = 0;
+	return pSources[ i ];
+}
+
+bool olotOcsBundle::pParseMessage( const uint8_t *data, size_t length, int64_t receiveTime ){
+	if( pMessageCount == ( int )pMessages.size() ){
+		pMessages.resize( pMessages.size() * 2 );
+	}
+	
+	olotOcsMessage &message = pMessages[ pMessageCount ];
+	if( ! message.Parse( data, length ) ){
+		return false;
+	}
+	message.SetReceiveTime( receiveTime );
+	
+	pMessageCount++;
+	return true;
+}
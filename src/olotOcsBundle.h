@@ -0,0 +1,128 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _OLOTOCSBUNDLE_H_
+#define _OLOTOCSBUNDLE_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+#include "olotOcsMessage.h"
+
+
+/**
+ * OCS Bundle.
+ * 
+ * Collects the messages of one or more received packets. Each packet can be either a
+ * single message or a bundle containing messages and nested bundles. Nested bundles
+ * are flattened. Messages are collected in the order they appear in the packets.
+ */
+class olotOcsBundle{
+public:
+	/** Timetag indicating the bundle has to be applied immediately. */
+	const static uint64_t TimetagImmediately = 1;
+	
+	/** Maximum nesting depth of bundles. */
+	const static int MaxDepth = 8;
+	
+	/** Maximum number of sources the latest timetag is tracked for. */
+	const static int MaxSources = 8;
+	
+	/**
+	 * Timetag jump backwards treated as clock reset of the source instead of an outdated
+	 * bundle. One second in NTP timestamp units.
+	 */
+	const static uint64_t TimetagResetJump = ( uint64_t )1 << 32;
+	
+	
+	
+private:
+	struct sSource{
+		uint64_t source;
+		uint64_t latestTimetag;
+	};
+	
+	std::vector<olotOcsMessage> pMessages;
+	int pMessageCount;
+	sSource pSources[ MaxSources ];
+	int pSourceCount;
+	int pSourceReplace;
+	int pDroppedCount;
+	
+	
+	
+public:
+	/** \name Constructors and Destructors */
+	/*@{*/
+	/** Create OCS Bundle. */
+	olotOcsBundle();
+	
+	/** Clean up OCS Bundle. */
+	~olotOcsBundle();
+	/*@}*/
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/**
+	 * Parse packet and append the contained messages.
+	 * 
+	 * If the packet is malformed no messages are appended and false is returned. Bundles
+	 * with a timetag older than the latest bundle timetag seen from the same source are
+	 * outdated and dropped unless the timetag jumped back by TimetagResetJump or more.
+	 * Source identifies the sender, for example a hash of the sender address. The receive
+	 * time in CLOCK_MONOTONIC nanoseconds is assigned to all messages.
+	 */
+	bool Parse( const uint8_t *data, size_t length, int64_t receiveTime, uint64_t source );
+	
+	/** Remove all messages. Latest timetags and dropped count are kept. */
+	void Clear();
+	
+	/** Message count. */
+	inline int GetMessageCount() const{ return pMessageCount; }
+	
+	/** Message at index. */
+	const olotOcsMessage &GetMessageAt( int index ) const;
+	
+	/** Latest timetag of bundles parsed from source or 0 if none has been parsed yet. */
+	uint64_t GetLatestTimetag( uint64_t source ) const;
+	
+	/** Number of outdated bundles dropped since the last call. Resets the count. */
+	int TakeDroppedCount();
+	/*@}*/
+	
+	
+	
+private:
+	bool pParseElement( const uint8_t *data, size_t length, int depth, int64_t receiveTime,
+		uint64_t source );
+	bool pParseBundle( const uint8_t *data, size_t length, int depth, int64_t receiveTime,
+		uint64_t source );
+	sSource &pGetSource( uint64_t source );
+	bool pParseMessage( const uint8_t *data, size_t length, int64_t receiveTime );
+};
+
+#endif
@@ -23,52 +23,405 @@
  */
 
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <climits>
+#include <fstream>
+#include <stdio.h>
 #include <string.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
 #include <unistd.h>
+#include <errno.h>
 
 #include "olotApiLayer.h"
 #include "olotOcsClient.h"
 #include "olotOcsMessage.h"
+#include "olotOcsBundle.h"
+#include "olotOcsAddressMap.h"
+#include "olot_shm.h"
+#include "utils/olotClock.h"
 #include "exceptions/exceptions.h"
 
 
 // Callback
 /////////////
 
-static void fThreadRead( olotOcsClient *ocsclient, bool *exitThread ){
-	{
-	const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-	ocsclient->log() << "Enter read thread" << std::endl;
+// arrival time of datagram in CLOCK_MONOTONIC nanoseconds. uses the kernel receive time
+// if present otherwise the current time
+static int64_t receiveTime( const msghdr &header, int64_t realtimeOffset, int64_t now ){
+	cmsghdr *cmsg;
+	for( cmsg = CMSG_FIRSTHDR( &header ); cmsg; cmsg = CMSG_NXTHDR( ( msghdr* )&header, cmsg ) ){
+		if( cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_TIMESTAMPNS ){
+			timespec time;
+			memcpy( &time, CMSG_DATA( cmsg ), sizeof( time ) );
+			return std::min( olotClock::FromTimespec( time ) - realtimeOffset, now );
+		}
+	}
+	return now;
+}
+
+// jitter is the change of the inter-arrival time between consecutive datagrams or frames
+static inline void recordArrival( olotHistogram &jitter, int64_t arrival,
+int64_t &lastArrival, int64_t &lastInterval ){
+	if( lastArrival != 0 ){
+		const int64_t interval = arrival - lastArrival;
+		if( lastInterval != -1 ){
+			jitter.Record( std::abs( interval - lastInterval ) );
+		}
+		lastInterval = interval;
+	}
+	lastArrival = arrival;
+}
+
+// statistics are logged periodically by the read thread using a timer serviced by the
+// same epoll wait. statistics are reset after logging so each log covers one interval
+static int createStatisticsTimer( olotOcsClient *ocsclient, int epoll ){
+	const int statisticsInterval = olotApiLayer::Get().GetConfig().GetStatisticsInterval();
+	if( statisticsInterval <= 0 ){
+		return -1;
 	}
 	
-	const int sock = ocsclient->OpenSocket();
-	if( sock != -1 ){
-		uint8_t buffer[ 4096 ];
-		olotOcsMessage message;
+	int timer = timerfd_create( CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK );
+	if( timer != -1 ){
+		itimerspec interval = {};
+		interval.it_interval.tv_sec = statisticsInterval;
+		interval.it_value.tv_sec = statisticsInterval;
+		
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.fd = timer;
+		
+		if( timerfd_settime( timer, 0, &interval, nullptr ) == -1
+		|| epoll_ctl( epoll, EPOLL_CTL_ADD, timer, &event ) == -1 ){
+			close( timer );
+			timer = -1;
+		}
+	}
+	
+	if( timer == -1 ){
+		OLOTLOG_WARNING( ocsclient->log(), "Read thread: failed creating statistics timer" );
+	}
+	return timer;
+}
+
+// map shared memory ring. returns nullptr if the object does not exist yet or is not
+// initialized by the producer. mapped writable since the waiting flag is written
+static olot_shm_ring *openSharedMemory( olotOcsClient *ocsclient, const std::string &name ){
+	const int fd = shm_open( name.c_str(), O_RDWR | O_CLOEXEC, 0 );
+	if( fd == -1 ){
+		return nullptr;
+	}
+	
+	struct stat info;
+	void *memory = MAP_FAILED;
+	
+	if( fstat( fd, &info ) == 0 && info.st_size >= ( off_t )sizeof( olot_shm_ring ) ){
+		memory = mmap( nullptr, sizeof( olot_shm_ring ), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+	}
+	close( fd );
+	
+	if( memory == MAP_FAILED ){
+		return nullptr;
+	}
+	
+	olot_shm_ring * const ring = ( olot_shm_ring* )memory;
+	if( ! olot_shm_valid( ring ) ){
+		munmap( memory, sizeof( olot_shm_ring ) );
+		return nullptr;
+	}
+	
+	OLOTLOG_INFO( ocsclient->log(), "Read thread: opened shared memory " << name );
+	return ring;
+}
+
+// read frames from shared memory ring until the exit event is signaled. while the ring is
+// mapped the read thread blocks on the ring futex and polls the epoll events in between
+static void readSharedMemory( olotOcsClient *ocsclient, const std::string &name,
+int epoll, int eventExit, int timerStatistics ){
+	const int batchSize = olotOcsClient::ReceiveBatchSize;
+	olot_shm_frame frames[ batchSize ];
+	int64_t times[ batchSize ];
+	epoll_event events[ olotOcsClient::MaxEpollEvents ];
+	olot_shm_ring *ring = nullptr;
+	uint64_t tail = 0, lost = 0;
+	bool exitThread = false;
+	int i;
+	
+	timespec waitTimeout = {};
+	waitTimeout.tv_nsec = ( long )olotOcsClient::ShmWaitTimeout * 1000000L;
+	
+	olotHistogram &parseTimes = ocsclient->GetParseTimes();
+	olotHistogram &arrivalJitter = ocsclient->GetArrivalJitter();
+	int64_t lastArrival = 0, lastInterval = -1;
+	
+	OLOTLOG_INFO( ocsclient->log(), "Read thread: waiting for shared memory " << name );
+	
+	while( ! exitThread ){
+		const int eventCount = epoll_wait( epoll, events, olotOcsClient::MaxEpollEvents,
+			ring ? 0 : olotOcsClient::ShmOpenRetryInterval );
+		if( eventCount == -1 && errno != EINTR ){
+			OLOTLOG_ERROR( ocsclient->log(), "Read thread: failed waiting for epoll events" );
+			break;
+		}
 		
-		while( ! *exitThread ){
-			sockaddr_in senderAddress = {};
-			socklen_t senderAddressLen = sizeof( senderAddress );
+		for( i=0; i<eventCount; i++ ){
+			const int fd = events[ i ].data.fd;
+			if( fd == eventExit ){
+				exitThread = true;
+				break;
+			}
 			
-			const ssize_t length = ( size_t )recvfrom( sock, buffer, sizeof( buffer ), 0,
-				( sockaddr* )&senderAddress, &senderAddressLen );
-			if( length != -1 ){
-				if( message.Parse( buffer, length ) ){
-					ocsclient->ProcessData( message );
+			if( fd == timerStatistics ){
+				uint64_t expirations;
+				if( read( timerStatistics, &expirations, sizeof( expirations ) ) == sizeof( expirations ) ){
+					ocsclient->ReportStatistics( true );
+					
+					if( lost > 0 ){
+						OLOTLOG_WARNING( ocsclient->log(), "Read thread: " << lost
+							<< " shared memory frames overwritten before being read" );
+						lost = 0;
+					}
 				}
-				
-			}else if( length == 0 ){
+			}
+		}
+		
+		if( exitThread ){
+			break;
+		}
+		
+		if( ! ring ){
+			ring = openSharedMemory( ocsclient, name );
+			if( ring ){
+				tail = __atomic_load_n( &ring->head, __ATOMIC_ACQUIRE );
+				ocsclient->SetStopWakeAddress( &ring->signal );
+			}
+			continue;
+		}
+		
+		// a restarted producer initializes the ring again starting over at frame 0
+		const uint64_t head = __atomic_load_n( &ring->head, __ATOMIC_ACQUIRE );
+		if( head < tail ){
+			tail = head;
+		}
+		
+		// the producer wakes the read thread only if waiting is set. head is checked again
+		// after setting waiting to not miss a frame written in between. stopping the thread
+		// requests the stop before incrementing signal. a stop requested after the check
+		// below therefore changes signal after it has been read and the wait returns
+		if( head == tail ){
+			const uint32_t signal = __atomic_load_n( &ring->signal, __ATOMIC_SEQ_CST );
+			if( ocsclient->GetStopRequested() ){
 				break;
 			}
+			__atomic_store_n( &ring->waiting, 1, __ATOMIC_SEQ_CST );
+			if( __atomic_load_n( &ring->head, __ATOMIC_SEQ_CST ) == tail ){
+				syscall( SYS_futex, &ring->signal, FUTEX_WAIT, signal, &waitTimeout, nullptr, 0 );
+			}
+			__atomic_store_n( &ring->waiting, 0, __ATOMIC_RELAXED );
+			continue;
+		}
+		
+		// frames older than the ring size have been overwritten already
+		if( head - tail > OLOT_SHM_FRAME_COUNT ){
+			lost += head - tail - OLOT_SHM_FRAME_COUNT;
+			tail = head - OLOT_SHM_FRAME_COUNT;
 		}
 		
-		ocsclient->CloseSocket();
+		const int64_t now = olotClock::Now();
+		int count = 0;
+		
+		while( tail < head && count < batchSize ){
+			if( olot_shm_read( ring, tail, frames + count ) ){
+				const int64_t time = frames[ count ].time;
+				times[ count ] = time > 0 ? std::min( time, now ) : now;
+				recordArrival( arrivalJitter, times[ count ], lastArrival, lastInterval );
+				count++;
+				
+			}else{
+				lost++;
+			}
+			tail++;
+		}
+		
+		if( count > 0 ){
+			ocsclient->ProcessData( frames, times, count );
+			
+			// parse time is measured per batch and recorded as average per frame
+			parseTimes.Record( ( olotClock::Now() - now ) / count, count );
+		}
 	}
 	
-	const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-	ocsclient->log() << "Exit read thread" << std::endl;
+	if( ring ){
+		ocsclient->SetStopWakeAddress( nullptr );
+		munmap( ring, sizeof( olot_shm_ring ) );
+	}
+}
+
+// source key of datagram sender. hashes address and port using 64-bit FNV-1a
+static uint64_t sourceKey( const msghdr &header ){
+	const uint8_t * const address = ( const uint8_t* )header.msg_name;
+	uint64_t hash = 0xcbf29ce484222325ULL;
+	socklen_t i;
+	for( i=0; i<header.msg_namelen; i++ ){
+		hash = ( hash ^ address[ i ] ) * 0x100000001b3ULL;
+	}
+	return hash;
+}
+
+static void fThreadRead( olotOcsClient *ocsclient, int eventExit ){
+	OLOTLOG_DEBUG( ocsclient->log(), "Enter read thread" );
+	
+	const int epoll = epoll_create1( EPOLL_CLOEXEC );
+	if( epoll == -1 ){
+		OLOTLOG_ERROR( ocsclient->log(), "Read thread: failed creating epoll" );
+		return;
+	}
+	
+	// the exit event and all sockets are serviced by the same epoll wait. sockets are
+	// non-blocking and drained completely each time they become readable
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.fd = eventExit;
+	bool exitThread = epoll_ctl( epoll, EPOLL_CTL_ADD, eventExit, &event ) == -1;
+	
+	// shared memory replaces the sockets. no sockets are opened in this case
+	const std::string &shmName = olotApiLayer::Get().GetConfig().GetShmName();
+	
+	if( shmName.empty() ){
+		const std::vector<int> &sockets = ocsclient->OpenSockets();
+		std::vector<int>::const_iterator iterSocket;
+		for( iterSocket = sockets.cbegin(); iterSocket != sockets.cend(); iterSocket++ ){
+			event.data.fd = *iterSocket;
+			if( epoll_ctl( epoll, EPOLL_CTL_ADD, *iterSocket, &event ) == -1 ){
+				exitThread = true;
+			}
+		}
+	}
+	
+	const int timerStatistics = createStatisticsTimer( ocsclient, epoll );
+	
+	if( exitThread ){
+		OLOTLOG_ERROR( ocsclient->log(), "Read thread: failed adding epoll events" );
+	}
+	
+	// receive buffers are allocated once and reused for every batch. recvmmsg returns
+	// all pending datagrams up to the batch size in a single call. the control buffers
+	// receive the kernel receive timestamps
+	const int batchSize = olotOcsClient::ReceiveBatchSize;
+	const int bufferSize = olotOcsClient::ReceiveBufferSize;
+	const int controlSize = CMSG_SPACE( sizeof( timespec ) );
+	
+	std::unique_ptr<uint8_t[]> buffers( new uint8_t[ batchSize * bufferSize ] );
+	std::unique_ptr<uint64_t[]> controls( new uint64_t[ batchSize * controlSize / sizeof( uint64_t ) ] );
+	epoll_event events[ olotOcsClient::MaxEpollEvents ];
+	olotOcsBundle bundle;
+	mmsghdr headers[ batchSize ];
+	iovec vectors[ batchSize ];
+	sockaddr_storage senders[ batchSize ];
+	int i, j;
+	
+	olotHistogram &parseTimes = ocsclient->GetParseTimes();
+	olotHistogram &arrivalJitter = ocsclient->GetArrivalJitter();
+	int64_t lastArrival = 0, lastInterval = -1;
+	
+	if( ! exitThread && ! shmName.empty() ){
+		readSharedMemory( ocsclient, shmName, epoll, eventExit, timerStatistics );
+		exitThread = true;
+	}
+	
+	while( ! exitThread ){
+		const int eventCount = epoll_wait( epoll, events, olotOcsClient::MaxEpollEvents, -1 );
+		if( eventCount == -1 ){
+			if( errno == EINTR ){
+				continue;
+			}
+			
+			OLOTLOG_ERROR( ocsclient->log(), "Read thread: failed waiting for epoll events" );
+			break;
+		}
+		
+		for( i=0; i<eventCount; i++ ){
+			const int fd = events[ i ].data.fd;
+			if( fd == eventExit ){
+				exitThread = true;
+				break;
+			}
+			
+			if( fd == timerStatistics ){
+				uint64_t expirations;
+				if( read( timerStatistics, &expirations, sizeof( expirations ) ) == sizeof( expirations ) ){
+					ocsclient->ReportStatistics( true );
+				}
+				continue;
+			}
+			
+			while( true ){
+				memset( headers, 0, sizeof( headers ) );
+				for( j=0; j<batchSize; j++ ){
+					vectors[ j ].iov_base = buffers.get() + bufferSize * j;
+					vectors[ j ].iov_len = bufferSize;
+					headers[ j ].msg_hdr.msg_iov = vectors + j;
+					headers[ j ].msg_hdr.msg_iovlen = 1;
+					headers[ j ].msg_hdr.msg_control = ( uint8_t* )controls.get() + controlSize * j;
+					headers[ j ].msg_hdr.msg_controllen = controlSize;
+					headers[ j ].msg_hdr.msg_name = senders + j;
+					headers[ j ].msg_hdr.msg_namelen = sizeof( sockaddr_storage );
+				}
+				
+				const int count = recvmmsg( fd, headers, batchSize, MSG_DONTWAIT, nullptr );
+				if( count < 1 ){
+					break;
+				}
+				
+				// messages of all received packets are collected and applied together.
+				// this applies all messages of a bundle as one frame. messages refer to
+				// the receive buffers so they have to be processed before receiving again
+				// kernel timestamps are CLOCK_REALTIME. convert them to CLOCK_MONOTONIC
+				const int64_t realtimeOffset = olotClock::RealtimeOffset();
+				const int64_t now = olotClock::Now();
+				
+				bundle.Clear();
+				for( j=0; j<count; j++ ){
+					const int64_t arrival = receiveTime( headers[ j ].msg_hdr, realtimeOffset, now );
+					recordArrival( arrivalJitter, arrival, lastArrival, lastInterval );
+					
+					bundle.Parse( ( const uint8_t* )vectors[ j ].iov_base, headers[ j ].msg_len,
+						arrival, sourceKey( headers[ j ].msg_hdr ) );
+				}
+				
+				// parse time is measured per batch and recorded as average per datagram
+				parseTimes.Record( ( olotClock::Now() - now ) / count, count );
+				
+				ocsclient->ProcessData( bundle );
+				
+				const int dropped = bundle.TakeDroppedCount();
+				if( dropped > 0 ){
+					OLOTLOG_DEBUG( ocsclient->log(), "Read thread: dropped " << dropped << " outdated bundles" );
+				}
+				
+				if( count < batchSize ){
+					break;
+				}
+			}
+		}
+	}
+	
+	ocsclient->CloseSockets();
+	if( timerStatistics != -1 ){
+		close( timerStatistics );
+	}
+	close( epoll );
+	
+	OLOTLOG_DEBUG( ocsclient->log(), "Exit read thread" );
 }
 
 
@@ -77,17 +430,25 @@ static void fThreadRead( olotOcsClient *ocsclient, bool *exitThread ){
 
 olotOcsClient::olotOcsClient() :
 pUsageCount( 1 ),
-pExitThread( false ),
-pSocket( -1 )
+pEventExit( -1 ),
+pStopRequested( false ),
+pStopWakeAddress( nullptr ),
+pReceivedCount( 0 ),
+pFilter( ChannelCount ),
+pPublishVersion( 0 ),
+pPublishedVersion( 0 ),
+pPublishTime( 0 ),
+pPublishedTime( 0 ),
+pHistory( ChannelCount ),
+pParseTimes( "Parse time" ),
+pArrivalJitter( "Arrival jitter" ),
+pLatencyFacial( "Latency facial" ),
+pLatencyEyeGaze( "Latency eye gaze" )
 {
-	{
-	const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-	log() << "Create OCS Client" << std::endl;
-	}
+	OLOTLOG_DEBUG( log(), "Create OCS Client" );
 	
 	try{
-		pInitExpressions();
-		pInitEyeStates();
+		pInitValues();
 		pStartThread();
 	}catch( const olotException & ){
 		pCleanUp();
@@ -96,10 +457,7 @@ pSocket( -1 )
 }
 
 olotOcsClient::~olotOcsClient(){
-	{
-	const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-	log() << "Destroy OCS Client" << std::endl;
-	}
+	OLOTLOG_DEBUG( log(), "Destroy OCS Client" );
 	pCleanUp();
 }
 
@@ -110,18 +468,14 @@ olotOcsClient::~olotOcsClient(){
 
 void olotOcsClient::AddUsage(){
 	pUsageCount++;
-	const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-	log() << "AddUsage (" << pUsageCount << ")" << std::endl;
+	OLOTLOG_DEBUG( log(), "AddUsage (" << pUsageCount << ")" );
 }
 
 void olotOcsClient::RemoveUsage(){
 	OLOTASSERT_TRUE( pUsageCount > 0, XR_ERROR_RUNTIME_FAILURE )
 	
 	pUsageCount--;
-	{
-	const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-	log() << "RemoveUsage (" << pUsageCount << ")" << std::endl;
-	}
+	OLOTLOG_DEBUG( log(), "RemoveUsage (" << pUsageCount << ")" );
 	
 	if( pUsageCount == 0 ){
 		olotApiLayer::Get().DropOcsClient();
@@ -129,96 +483,108 @@ void olotOcsClient::RemoveUsage(){
 }
 
 
-static inline float clamp( float value ){
-	return std::max( std::min( value, 1.0f ), 0.0f );
-}
-
-inline const std::string strToLower( const char * const string ){
-	std::string s( string );
-	std::transform( s.begin(), s.end(), s.begin(), ::tolower );
-	return s;
+void olotOcsClient::ProcessData( const olotOcsMessage &message ){
+	pProcessMessage( message );
+	pUpdateValues();
 }
 
-void olotOcsClient::ProcessData( const olotOcsMessage &message ){
-	if( message.GetParameterCount() == 0 ){
+void olotOcsClient::ProcessData( const olotOcsBundle &bundle ){
+	const int count = bundle.GetMessageCount();
+	if( count == 0 ){
 		return;
 	}
 	
-	const olotOcsMessage::sParameter &parameter = message.GetParameterAt( 0 );
-	if( parameter.type != olotOcsMessage::etFloat ){
-		return;
+	int i;
+	for( i=0; i<count; i++ ){
+		pProcessMessage( bundle.GetMessageAt( i ) );
 	}
+	pUpdateValues();
+}
+
+void olotOcsClient::ProcessData( const olot_shm_frame *frames, const int64_t *times, int count ){
+	static_assert( OLOT_SHM_EXPRESSION_COUNT == ExpressionCount, "shared memory expression count mismatch" );
+	static_assert( OLOT_SHM_EYE_STATE_COUNT == EyeStateCount, "shared memory eye state count mismatch" );
 	
-	const std::string target( strToLower( message.GetTarget() ) );
-	int i;
+	int i, j;
 	
-	// eye state
-	for( i=0; i<EyeStateCount; i++  ){
-		if( pEyeStates[ i ].ocsTarget == target ){
-			const std::lock_guard<std::mutex> guard( pMutexData );
-			pEyeStateValues[ i ] = clamp( parameter.valueFloat );
-			return;
+	// later frames replace values of earlier frames
+	for( i=0; i<count; i++ ){
+		const olot_shm_frame &frame = frames[ i ];
+		
+		for( j=0; j<ExpressionCount; j++ ){
+			if( frame.expression_mask & ( ( uint64_t )1 << j ) ){
+				pReceiveValue( ExpressionChannel( ( eExpression )j ), frame.expressions[ j ], times[ i ] );
+			}
 		}
-	}
-	
-	// face expression
-	for( i=0; i<ExpressionCount; i++  ){
-		if( pExpressions[ i ].ocsTarget == target ){
-			const std::lock_guard<std::mutex> guard( pMutexData );
-			pExpressionValues[ i ] = clamp( parameter.valueFloat );
-			return;
+		
+		for( j=0; j<EyeStateCount; j++ ){
+			if( frame.eye_state_mask & ( ( uint32_t )1 << j ) ){
+				pReceiveValue( EyeStateChannel( ( eEyeState )j ), frame.eye_states[ j ], times[ i ] );
+			}
 		}
 	}
+	
+	pUpdateValues();
+}
+
+void olotOcsClient::SetStopWakeAddress( uint32_t *address ){
+	const std::lock_guard<std::mutex> guard( pMutexStopWake );
+	pStopWakeAddress = address;
 }
 
-int olotOcsClient::OpenSocket(){
-	CloseSocket();
+const std::vector<int> &olotOcsClient::OpenSockets(){
+	CloseSockets();
 	
-	const std::lock_guard<std::mutex> guard( pMutexData );
+	const olotConfig &config = olotApiLayer::Get().GetConfig();
+	const std::string &bindAddress = config.GetBindAddress();
 	
-	pSocket = socket( AF_INET, SOCK_DGRAM, 0 );
-	if( pSocket == -1 ){
-		const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-		log() << "Read thread: failed creating socket" << std::endl;
-		return -1;
-	}
+	// without bind address listen on any IPv4 address or on any IPv6 and IPv4 address
+	// using dual-stack sockets if IPv6 is enabled
+	sockaddr_in address4 = {};
+	address4.sin_family = AF_INET;
+	address4.sin_addr.s_addr = INADDR_ANY;
 	
-	int opt = 1;
-	if( setsockopt( pSocket, SOL_SOCKET, SO_REUSEADDR | SO_REUSEPORT, &opt, sizeof( opt ) ) ){
-		close( pSocket );
-		pSocket = -1;
-		
-		const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-		log() << "Read thread: failed setting socket option" << std::endl;
-		return -1;
-	}
+	sockaddr_in6 address6 = {};
+	address6.sin6_family = AF_INET6;
+	address6.sin6_addr = in6addr_any;
 	
-	sockaddr_in address = {};
-	address.sin_family = AF_INET;
-	address.sin_addr.s_addr = INADDR_ANY;
-	address.sin_port = htons( 8888 );
+	bool useIPv6 = config.GetIPv6();
 	
-	if( bind( pSocket, ( struct sockaddr* )&address, sizeof( address ) ) == -1 ){
-		close( pSocket );
-		pSocket = -1;
-		
-		const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-		log() << "Read thread: failed binding socket" << std::endl;
-		return -1;
+	if( ! bindAddress.empty() ){
+		if( inet_pton( AF_INET, bindAddress.c_str(), &address4.sin_addr ) == 1 ){
+			useIPv6 = false;
+			
+		}else if( inet_pton( AF_INET6, bindAddress.c_str(), &address6.sin6_addr ) == 1 ){
+			useIPv6 = true;
+			
+		}else{
+			OLOTLOG_ERROR( log(), "Read thread: invalid bind address '" << bindAddress << "'" );
+			return pSockets;
+		}
+	}
+	
+	const olotConfig::ListPorts &ports = config.GetPorts();
+	olotConfig::ListPorts::const_iterator iter;
+	for( iter = ports.cbegin(); iter != ports.cend(); iter++ ){
+		if( useIPv6 ){
+			address6.sin6_port = htons( ( uint16_t )*iter );
+			pOpenSocket( ( const sockaddr* )&address6, sizeof( address6 ) );
+			
+		}else{
+			address4.sin_port = htons( ( uint16_t )*iter );
+			pOpenSocket( ( const sockaddr* )&address4, sizeof( address4 ) );
+		}
 	}
 	
-	return pSocket;
+	return pSockets;
 }
 
-void olotOcsClient::CloseSocket(){
-	const std::lock_guard<std::mutex> guard( pMutexData );
-	if( pSocket == -1 ){
-		return;
+void olotOcsClient::CloseSockets(){
+	std::vector<int>::const_iterator iter;
+	for( iter = pSockets.cbegin(); iter != pSockets.cend(); iter++ ){
+		close( *iter );
 	}
-	
-	shutdown( pSocket, SHUT_RDWR );
-	close( pSocket );
-	pSocket = -1;
+	pSockets.clear();
 }
 
 void olotOcsClient::GetExpressionValues( float *values, int count ){
@@ -226,8 +592,7 @@ void olotOcsClient::GetExpressionValues( float *values, int count ){
 	OLOTASSERT_TRUE( count >= 0, XR_ERROR_RUNTIME_FAILURE )
 	OLOTASSERT_TRUE( count <= ExpressionCount, XR_ERROR_RUNTIME_FAILURE )
 	
-	const std::lock_guard<std::mutex> guard( pMutexData );
-	memcpy( values, pExpressionValues, sizeof( float ) * count );
+	pReadPublished( pPublishedExpressionValues, values, count );
 }
 
 void olotOcsClient::GetEyeStateValues( float *values, int count ){
@@ -235,8 +600,70 @@ void olotOcsClient::GetEyeStateValues( float *values, int count ){
 	OLOTASSERT_TRUE( count >= 0, XR_ERROR_RUNTIME_FAILURE )
 	OLOTASSERT_TRUE( count <= EyeStateCount, XR_ERROR_RUNTIME_FAILURE )
 	
-	const std::lock_guard<std::mutex> guard( pMutexData );
-	memcpy( values, pEyeStates, sizeof( float ) * count );
+	pReadPublished( pPublishedEyeStateValues, values, count );
+}
+
+void olotOcsClient::GetSnapshot( sSnapshot &snapshot ) const{
+	const uint32_t knownVersion = snapshot.version;
+	uint32_t sequence;
+	int i;
+	
+	do{
+		sequence = pPublishLock.BeginRead();
+		
+		const uint32_t version = pPublishedVersion.load( std::memory_order_relaxed );
+		if( version == knownVersion ){
+			return;
+		}
+		
+		snapshot.version = version;
+		snapshot.time = pPublishedTime.load( std::memory_order_relaxed );
+		for( i=0; i<ExpressionCount; i++ ){
+			snapshot.expressions[ i ] = pPublishedExpressionValues[ i ].load( std::memory_order_relaxed );
+		}
+		for( i=0; i<EyeStateCount; i++ ){
+			snapshot.eyeStates[ i ] = pPublishedEyeStateValues[ i ].load( std::memory_order_relaxed );
+		}
+	}while( pPublishLock.RetryRead( sequence ) );
+}
+
+void olotOcsClient::DumpStatistics( std::ostream &stream, bool reset ){
+	olotHistogram * const histograms[] = { &pParseTimes, &pArrivalJitter, &pLatencyFacial, &pLatencyEyeGaze };
+	for( olotHistogram * const histogram : histograms ){
+		histogram->Dump( stream, reset );
+		stream << std::endl;
+	}
+}
+
+void olotOcsClient::LogStatistics( bool reset ){
+	olotHistogram * const histograms[] = { &pParseTimes, &pArrivalJitter, &pLatencyFacial, &pLatencyEyeGaze };
+	for( olotHistogram * const histogram : histograms ){
+		if( olotLog::IsEnabled( olotLog::elInfo ) ){
+			std::ostream &stream = log() << "Statistics: ";
+			histogram->Dump( stream, reset );
+			stream << std::endl;
+			
+		}else if( reset ){
+			histogram->Reset();
+		}
+	}
+}
+
+void olotOcsClient::ReportStatistics( bool reset ){
+	// written to a temporary file first. readers never see a partially written file
+	const std::string &path = olotApiLayer::Get().GetConfig().GetStatisticsFile();
+	if( ! path.empty() ){
+		const std::string pathTemp( path + ".tmp" );
+		std::ofstream stream( pathTemp, std::ios::out | std::ios::trunc );
+		DumpStatistics( stream, false );
+		stream.close();
+		
+		if( ! stream || rename( pathTemp.c_str(), path.c_str() ) ){
+			OLOTLOG_WARNING( log(), "Failed writing statistics file " << path );
+		}
+	}
+	
+	LogStatistics( reset );
 }
 
 std::ostream &olotOcsClient::log(){
@@ -258,18 +685,14 @@ void olotOcsClient::pStartThread(){
 		return;
 	}
 	
-	{
-	const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-	log() << "Start read thread" << std::endl;
-	}
+	OLOTLOG_DEBUG( log(), "Start read thread" );
 	
-	pExitThread = false;
-	pThreadRead = std::make_shared<std::thread>( std::thread( fThreadRead, this, &pExitThread ) );
+	pEventExit = eventfd( 0, EFD_CLOEXEC | EFD_NONBLOCK );
+	OLOTASSERT_FALSE( pEventExit == -1, XR_ERROR_RUNTIME_FAILURE )
 	
-	{
-	const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-	log() << "Read thread started" << std::endl;
-	}
+	pThreadRead = std::make_shared<std::thread>( std::thread( fThreadRead, this, pEventExit ) );
+	
+	OLOTLOG_DEBUG( log(), "Read thread started" );
 }
 
 void olotOcsClient::pStopThread(){
@@ -277,85 +700,237 @@ void olotOcsClient::pStopThread(){
 		return;
 	}
 	
-	{
-	const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-	log() << "Stop read thread" << std::endl;
+	OLOTLOG_DEBUG( log(), "Stop read thread" );
+	
+	pStopRequested.store( true, std::memory_order_seq_cst );
+	
+	const uint64_t signal = 1;
+	if( write( pEventExit, &signal, sizeof( signal ) ) != sizeof( signal ) ){
+		OLOTLOG_ERROR( log(), "Failed signaling read thread to exit" );
 	}
 	
-	pExitThread = true;
-	CloseSocket();
+	pWakeStopAddress();
+	
 	pThreadRead->join();
 	pThreadRead.reset();
-	pExitThread = false;
-	
-	{
-	const std::lock_guard<std::mutex> guard( olotApiLayer::Get().mutexLog );
-	log() << "Read thread stopped" << std::endl;
-	}
-}
-
-void olotOcsClient::pInitExpressions(){
-	pExpressions[ 0 ] = { strToLower( "/cheekPuffLeft" ), eeCheekPuffLeft };
-	pExpressions[ 1 ] = { strToLower( "/cheekPuffRight" ), eeCheekPuffRight };
-	pExpressions[ 2 ] = { strToLower( "/cheekSuckLeft" ), eeCheekSuckLeft };
-	pExpressions[ 3 ] = { strToLower( "/cheekSuckRight" ), eeCheekSuckRight };
-	pExpressions[ 4 ] = { strToLower( "/jawOpen" ), eeJawOpen };
-	pExpressions[ 5 ] = { strToLower( "/jawForward" ), eeJawForward };
-	pExpressions[ 6 ] = { strToLower( "/jawLeft" ), eeJawLeft };
-	pExpressions[ 7 ] = { strToLower( "/jawRight" ), eeJawRight };
-	pExpressions[ 8 ] = { strToLower( "/noseSneerLeft" ), eeNoseSneerLeft };
-	pExpressions[ 9 ] = { strToLower( "/noseSneerRight" ), eeNoseSneerRight };
-	pExpressions[ 10 ] = { strToLower( "/mouthFunnel" ), eeMouthFunnel };
-	pExpressions[ 11 ] = { strToLower( "/mouthPucker" ), eeMouthPucker };
-	pExpressions[ 12 ] = { strToLower( "/mouthLeft" ), eeMouthLeft };
-	pExpressions[ 13 ] = { strToLower( "/mouthRight" ), eeMouthRight };
-	pExpressions[ 14 ] = { strToLower( "/mouthRollUpper" ), eeMouthRollUpper };
-	pExpressions[ 15 ] = { strToLower( "/mouthRollLower" ), eeMouthRollLower };
-	pExpressions[ 16 ] = { strToLower( "/mouthShrugUpper" ), eeMouthShrugUpper };
-	pExpressions[ 17 ] = { strToLower( "/mouthShrugLower" ), eeMouthShrugLower };
-	pExpressions[ 18 ] = { strToLower( "/mouthClose" ), eeMouthClose };
-	pExpressions[ 19 ] = { strToLower( "/mouthSmileLeft" ), eeMouthSmileLeft };
-	pExpressions[ 20 ] = { strToLower( "/mouthSmileRight" ), eeMouthSmileRight };
-	pExpressions[ 21 ] = { strToLower( "/mouthFrownLeft" ), eeMouthFrownLeft };
-	pExpressions[ 22 ] = { strToLower( "/mouthFrownRight" ), eeMouthFrownRight };
-	pExpressions[ 23 ] = { strToLower( "/mouthDimpleLeft" ), eeMouthDimpleLeft };
-	pExpressions[ 24 ] = { strToLower( "/mouthDimpleRight" ), eeMouthDimpleRight };
-	pExpressions[ 25 ] = { strToLower( "/mouthUpperUpLeft" ), eeMouthUpperUpLeft };
-	pExpressions[ 26 ] = { strToLower( "/mouthUpperUpRight" ), eeMouthUpperUpRight };
-	pExpressions[ 27 ] = { strToLower( "/mouthLowerDownLeft" ), eeMouthLowerDownLeft };
-	pExpressions[ 28 ] = { strToLower( "/mouthLowerDownRight" ), eeMouthLowerDownRight };
-	pExpressions[ 29 ] = { strToLower( "/mouthPressLeft" ), eeMouthPressLeft };
-	pExpressions[ 30 ] = { strToLower( "/mouthPressRight" ), eeMouthPressRight };
-	pExpressions[ 31 ] = { strToLower( "/mouthStretchLeft" ), eeMouthStretchLeft };
-	pExpressions[ 32 ] = { strToLower( "/mouthStretchRight" ), eeMouthStretchRight };
-	pExpressions[ 33 ] = { strToLower( "/tongueOut" ), eeTongueOut };
-	pExpressions[ 34 ] = { strToLower( "/tongueUp" ), eeTongueUp };
-	pExpressions[ 35 ] = { strToLower( "/tongueDown" ), eeTongueDown };
-	pExpressions[ 36 ] = { strToLower( "/tongueLeft" ), eeTongueLeft };
-	pExpressions[ 37 ] = { strToLower( "/tongueRight" ), eeTongueRight };
-	pExpressions[ 38 ] = { strToLower( "/tongueRoll" ), eeTongueRoll };
-	pExpressions[ 39 ] = { strToLower( "/tongueBendDown" ), eeTongueBendDown };
-	pExpressions[ 40 ] = { strToLower( "/tongueCurlUp" ), eeTongueCurlUp };
-	pExpressions[ 41 ] = { strToLower( "/tongueSquish" ), eeTongueSquish };
-	pExpressions[ 42 ] = { strToLower( "/tongueFlat" ), eeTongueFlat };
-	pExpressions[ 43 ] = { strToLower( "/tongueTwistLeft" ), eeTongueTwistLeft };
-	pExpressions[ 44 ] = { strToLower( "/tongueTwistRight" ), eeTongueTwistRight };
-	pExpressions[ 45 ] = { strToLower( "/leftEyeLidExpandedSqueeze" ), eeLeftEyeLidExpandedSqueeze };
-	pExpressions[ 46 ] = { strToLower( "/rightEyeLidExpandedSqueeze" ), eeRightEyeLidExpandedSqueeze };
+	pStopRequested.store( false, std::memory_order_seq_cst );
+	
+	close( pEventExit );
+	pEventExit = -1;
+	
+	ReportStatistics( false );
 	
+	OLOTLOG_DEBUG( log(), "Read thread stopped" );
+}
+
+void olotOcsClient::pWakeStopAddress(){
+	// the read thread blocks on the shared memory futex instead of the exit event while
+	// the ring is mapped
+	const std::lock_guard<std::mutex> guard( pMutexStopWake );
+	if( pStopWakeAddress ){
+		__atomic_add_fetch( pStopWakeAddress, 1, __ATOMIC_SEQ_CST );
+		syscall( SYS_futex, pStopWakeAddress, FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0 );
+	}
+}
+
+void olotOcsClient::pProcessMessage( const olotOcsMessage &message ){
+	const std::string_view &target = message.GetTarget();
+	const olotOcsAddressMap::sChannel * const channel =
+		olotOcsAddressMap::Find( target.data(), target.size() );
+	if( ! channel ){
+		return;
+	}
+	
+	// use the first numeric parameter skipping unsupported ones
+	const int count = message.GetParameterCount();
+	float value = 0.0f;
 	int i;
-	for( i=0; i<ExpressionCount; i++ ){
-		pExpressionValues[ i ] = 0.0f;
+	
+	for( i=0; i<count; i++ ){
+		if( message.GetParameterAsFloatAt( i, value ) ){
+			break;
+		}
+	}
+	if( i == count ){
+		return;
+	}
+	
+	int index = 0;
+	switch( channel->type ){
+	case olotOcsAddressMap::ectExpression:
+		index = ExpressionChannel( ( eExpression )channel->index );
+		break;
+		
+	case olotOcsAddressMap::ectEyeState:
+		index = EyeStateChannel( ( eEyeState )channel->index );
+		break;
 	}
+	
+	// later messages for the same channel replace earlier ones
+	pReceiveValue( index, value, message.GetReceiveTime() );
 }
 
-void olotOcsClient::pInitEyeStates(){
-	pEyeStates[ 0 ] = { strToLower( "/leftEyeX" ), eesLeftEyeX };
-	pEyeStates[ 1 ] = { strToLower( "/rightEyeX" ), eesRightEyeX };
-	pEyeStates[ 2 ] = { strToLower( "/eyesY" ), eesEyesY };
+void olotOcsClient::pReceiveValue( int channel, float value, int64_t time ){
+	// NaN passes the clamping and infinity would be clamped to a bogus limit. a single
+	// non-finite value reaching the filter poisons the channel state for good
+	if( ! std::isfinite( value ) ){
+		return;
+	}
+	
+	// expressions range from 0 to 1 while eye states range from -1 to 1
+	const float minimum = channel < ExpressionCount ? 0.0f : -1.0f;
+	pReceivedValues[ channel ] = std::max( std::min( value, 1.0f ), minimum );
+	pReceivedTimes[ channel ] = time;
+	if( ! pReceived[ channel ] ){
+		pReceived[ channel ] = 1;
+		pReceivedCount++;
+	}
+}
+
+void olotOcsClient::pUpdateValues(){
+	// nothing to do if no known channel has been received
+	if( pReceivedCount == 0 ){
+		return;
+	}
+	
+	pFilter.Process( pReceivedValues, pReceivedTimes, pReceived, pValues );
 	
 	int i;
+	pHistory.BeginWrite();
+	for( i=0; i<ChannelCount; i++ ){
+		if( pReceived[ i ] ){
+			pHistory.AddSample( i, pReceivedTimes[ i ], pValues[ i ] );
+			pPublishTime = std::max( pPublishTime, pReceivedTimes[ i ] );
+			pReceived[ i ] = 0;
+		}
+	}
+	pHistory.EndWrite();
+	pReceivedCount = 0;
+	
+	pPublishValues();
+}
+
+int olotOcsClient::pOpenSocket( const sockaddr *address, socklen_t addressLength ){
+	const olotConfig &config = olotApiLayer::Get().GetConfig();
+	
+	const int sock = socket( address->sa_family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0 );
+	if( sock == -1 ){
+		OLOTLOG_ERROR( log(), "Read thread: failed creating socket" );
+		return -1;
+	}
+	
+	int opt = 1;
+	if( setsockopt( sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof( opt ) )
+	|| setsockopt( sock, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof( opt ) ) ){
+		close( sock );
+		
+		OLOTLOG_ERROR( log(), "Read thread: failed setting socket option" );
+		return -1;
+	}
+	
+	opt = 1;
+	if( setsockopt( sock, SOL_SOCKET, SO_TIMESTAMPNS, &opt, sizeof( opt ) ) ){
+		OLOTLOG_ERROR( log(), "Read thread: failed enabling receive timestamps" );
+	}
+	
+	if( address->sa_family == AF_INET6 ){
+		opt = 0;
+		if( setsockopt( sock, IPPROTO_IPV6, IPV6_V6ONLY, &opt, sizeof( opt ) ) ){
+			OLOTLOG_ERROR( log(), "Read thread: failed enabling dual-stack socket" );
+		}
+	}
+	
+	// a too small receive buffer drops packets if the read thread is not scheduled for
+	// a while. failing to change the size is not fatal
+	if( config.GetReceiveBufferSize() > 0 ){
+		opt = config.GetReceiveBufferSize();
+		if( setsockopt( sock, SOL_SOCKET, SO_RCVBUF, &opt, sizeof( opt ) ) ){
+			OLOTLOG_ERROR( log(), "Read thread: failed setting receive buffer size" );
+		}
+	}
+	
+	if( bind( sock, address, addressLength ) == -1 ){
+		close( sock );
+		
+		OLOTLOG_ERROR( log(), "Read thread: failed binding socket" );
+		return -1;
+	}
+	
+	if( ! config.GetMulticastGroup().empty() ){
+		pJoinMulticastGroup( sock, address->sa_family, config.GetMulticastGroup() );
+	}
+	
+	pSockets.push_back( sock );
+	return sock;
+}
+
+void olotOcsClient::pJoinMulticastGroup( int sock, int family, const std::string &group ){
+	ip_mreq request4 = {};
+	ipv6_mreq request6 = {};
+	int result = -1;
+	
+	// IPv4 groups can be joined by IPv4 and dual-stack IPv6 sockets
+	if( inet_pton( AF_INET, group.c_str(), &request4.imr_multiaddr ) == 1 ){
+		request4.imr_interface.s_addr = INADDR_ANY;
+		result = setsockopt( sock, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request4, sizeof( request4 ) );
+		
+	}else if( family == AF_INET6 && inet_pton( AF_INET6, group.c_str(), &request6.ipv6mr_multiaddr ) == 1 ){
+		request6.ipv6mr_interface = 0;
+		result = setsockopt( sock, IPPROTO_IPV6, IPV6_JOIN_GROUP, &request6, sizeof( request6 ) );
+	}
+	
+	if( result == 0 ){
+		OLOTLOG_INFO( log(), "Read thread: joined multicast group " << group );
+		
+	}else{
+		OLOTLOG_ERROR( log(), "Read thread: failed joining multicast group " << group );
+	}
+}
+
+void olotOcsClient::pPublishValues(){
+	int i;
+	
+	pPublishLock.BeginWrite();
+	
+	for( i=0; i<ExpressionCount; i++ ){
+		pPublishedExpressionValues[ i ].store( pValues[ ExpressionChannel( ( eExpression )i ) ],
+			std::memory_order_relaxed );
+	}
 	for( i=0; i<EyeStateCount; i++ ){
-		pEyeStateValues[ i ] = 0.0f;
+		pPublishedEyeStateValues[ i ].store( pValues[ EyeStateChannel( ( eEyeState )i ) ],
+			std::memory_order_relaxed );
+	}
+	pPublishedTime.store( pPublishTime, std::memory_order_relaxed );
+	pPublishedVersion.store( ++pPublishVersion, std::memory_order_relaxed );
+	
+	pPublishLock.EndWrite();
+}
+
+void olotOcsClient::pReadPublished( const std::atomic<float> *published, float *values, int count ) const{
+	uint32_t sequence;
+	int i;
+	
+	do{
+		sequence = pPublishLock.BeginRead();
+		for( i=0; i<count; i++ ){
+			values[ i ] = published[ i ].load( std::memory_order_relaxed );
+		}
+	}while( pPublishLock.RetryRead( sequence ) );
+}
+
+void olotOcsClient::pInitValues(){
+	const olotConfig &config = olotApiLayer::Get().GetConfig();
+	pFilter.SetParameters( config.GetFilter(), config.GetFilterMinCutoff(),
+		config.GetFilterBeta(), config.GetFilterDerivativeCutoff() );
+	
+	int i;
+	for( i=0; i<ChannelCount; i++ ){
+		pReceivedValues[ i ] = 0.0f;
+		pReceivedTimes[ i ] = 0;
+		pReceived[ i ] = 0;
+		pValues[ i ] = 0.0f;
 	}
+	pReceivedCount = 0;
+	
+	pPublishValues();
 }
@@ -27,11 +27,20 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 #include <thread>
+#include <atomic>
 #include <mutex>
 #include <sys/socket.h>
 
+#include "olotOcsSampleHistory.h"
+#include "olotOcsFilter.h"
+#include "utils/olotSeqLock.h"
+#include "utils/olotHistogram.h"
+
 class olotOcsMessage;
+class olotOcsBundle;
+struct olot_shm_frame;
 
 
 /**
@@ -99,27 +108,66 @@ public:
 	
 	const static int EyeStateCount = eesEyesY + 1;
 	
-private:
-	struct sExpression {
-		std::string ocsTarget;
-		eExpression expression;
-	};
-	struct sEyeState {
-		std::string ocsTarget;
-		eEyeState state;
+	/** Number of sample history channels. Expressions are followed by eye states. */
+	const static int ChannelCount = ExpressionCount + EyeStateCount;
+	
+	/** Snapshot of all values. */
+	struct sSnapshot{
+		/** Version incremented each time values are published. Version 0 is never used. */
+		uint32_t version;
+		
+		/** Receive time of the newest value in CLOCK_MONOTONIC nanoseconds or 0 if none. */
+		int64_t time;
+		
+		float expressions[ ExpressionCount ];
+		float eyeStates[ EyeStateCount ];
 	};
 	
+	/** Maximum number of datagrams received with a single system call. */
+	const static int ReceiveBatchSize = 32;
+	
+	/** Size in bytes of each datagram receive buffer. */
+	const static int ReceiveBufferSize = 4096;
+	
+	/** Maximum number of events handled per epoll wait. */
+	const static int MaxEpollEvents = 8;
+	
+	/** Interval in milliseconds to retry opening the shared memory object. */
+	const static int ShmOpenRetryInterval = 1000;
+	
+	/** Maximum time in milliseconds to wait for shared memory frames before polling events. */
+	const static int ShmWaitTimeout = 50;
+	
+private:
 	int pUsageCount;
 	std::shared_ptr<std::thread> pThreadRead;
-	std::mutex pMutexData;
-	bool pExitThread;
-	int pSocket;
+	int pEventExit;
+	std::atomic<bool> pStopRequested;
+	std::mutex pMutexStopWake;
+	uint32_t *pStopWakeAddress;
+	std::vector<int> pSockets;
+	
+	float pReceivedValues[ ChannelCount ];
+	int64_t pReceivedTimes[ ChannelCount ];
+	uint8_t pReceived[ ChannelCount ];
+	int pReceivedCount;
+	float pValues[ ChannelCount ];
+	olotOcsFilter pFilter;
 	
-	sExpression pExpressions[ ExpressionCount ];
-	float pExpressionValues[ ExpressionCount ];
+	olotSeqLock pPublishLock;
+	uint32_t pPublishVersion;
+	std::atomic<uint32_t> pPublishedVersion;
+	int64_t pPublishTime;
+	std::atomic<int64_t> pPublishedTime;
+	std::atomic<float> pPublishedExpressionValues[ ExpressionCount ];
+	std::atomic<float> pPublishedEyeStateValues[ EyeStateCount ];
 	
-	sEyeState pEyeStates[ EyeStateCount ];
-	float pEyeStateValues[ EyeStateCount ];
+	olotOcsSampleHistory pHistory;
+	
+	olotHistogram pParseTimes;
+	olotHistogram pArrivalJitter;
+	olotHistogram pLatencyFacial;
+	olotHistogram pLatencyEyeGaze;
 	
 	
 	
@@ -143,21 +191,94 @@ public:
 	/** Remove usage. */
 	void RemoveUsage();
 	
-	/** Process query data. For internal use only. */
+	/**
+	 * Process query data. For internal use only.
+	 * 
+	 * Has to be called only by the read thread. Values are filtered and published to
+	 * readers after the message has been processed.
+	 */
 	void ProcessData( const olotOcsMessage &message );
 	
-	/** Open socket. For internal use only. */
-	int OpenSocket();
+	/**
+	 * Process all messages of bundle at once. For internal use only.
+	 * 
+	 * Has to be called only by the read thread. Values are filtered and published to
+	 * readers after all messages have been processed.
+	 */
+	void ProcessData( const olotOcsBundle &bundle );
+	
+	/**
+	 * Process shared memory frames at once. For internal use only.
+	 * 
+	 * Has to be called only by the read thread. Times contains the receive time of each
+	 * frame. Values are filtered and published to readers after all frames have been processed.
+	 */
+	void ProcessData( const olot_shm_frame *frames, const int64_t *times, int count );
+	
+	/**
+	 * Set futex word the read thread blocks on or nullptr if none. For internal use only.
+	 * 
+	 * Stopping the read thread increments the word and wakes it up. The read thread has
+	 * to clear the word before unmapping it.
+	 */
+	void SetStopWakeAddress( uint32_t *address );
 	
-	/** Close socket. For internal use only. */
-	void CloseSocket();
+	/** Stopping the read thread has been requested. For internal use only. */
+	inline bool GetStopRequested() const{ return pStopRequested.load( std::memory_order_seq_cst ); }
 	
-	/** Copy expression values. */
+	/** Open sockets returning the successfully opened ones. For internal use only. */
+	const std::vector<int> &OpenSockets();
+	
+	/** Close sockets. For internal use only. */
+	void CloseSockets();
+	
+	/** Copy expression values. Lock-free and never blocks the read thread. */
 	void GetExpressionValues( float *values, int count );
 	
-	/** Copy eye state values. */
+	/** Copy eye state values. Lock-free and never blocks the read thread. */
 	void GetEyeStateValues( float *values, int count );
 	
+	/**
+	 * Copy all values at once. Lock-free and never blocks the read thread.
+	 * 
+	 * If the version of snapshot matches the current version the values are not copied.
+	 */
+	void GetSnapshot( sSnapshot &snapshot ) const;
+	
+	/** Sample history of all channels. */
+	inline const olotOcsSampleHistory &GetHistory() const{ return pHistory; }
+	
+	/** Parse time per received datagram. Recorded by the read thread. */
+	inline olotHistogram &GetParseTimes(){ return pParseTimes; }
+	
+	/** Difference between consecutive datagram inter-arrival times. Recorded by the read thread. */
+	inline olotHistogram &GetArrivalJitter(){ return pArrivalJitter; }
+	
+	/** Time from packet arrival until facial trackers consume the values. */
+	inline olotHistogram &GetLatencyFacial(){ return pLatencyFacial; }
+	
+	/** Time from packet arrival until eye gaze trackers consume the values. */
+	inline olotHistogram &GetLatencyEyeGaze(){ return pLatencyEyeGaze; }
+	
+	/** Write all statistics to stream. If reset is true statistics are cleared. */
+	void DumpStatistics( std::ostream &stream, bool reset );
+	
+	/** Log all statistics. If reset is true statistics are cleared. */
+	void LogStatistics( bool reset );
+	
+	/**
+	 * Write all statistics to the statistics file if configured then log them.
+	 * 
+	 * If reset is true statistics are cleared after logging them.
+	 */
+	void ReportStatistics( bool reset );
+	
+	/** Sample history channel of expression. */
+	static inline int ExpressionChannel( eExpression expression ){ return expression; }
+	
+	/** Sample history channel of eye state. */
+	static inline int EyeStateChannel( eEyeState eyeState ){ return ExpressionCount + eyeState; }
+	
 	/** Log stream. */
 	std::ostream &log();
 	/*@}*/
@@ -168,8 +289,15 @@ private:
 	void pCleanUp();
 	void pStartThread();
 	void pStopThread();
-	void pInitExpressions();
-	void pInitEyeStates();
+	void pWakeStopAddress();
+	int pOpenSocket( const sockaddr *address, socklen_t addressLength );
+	void pJoinMulticastGroup( int sock, int family, const std::string &group );
+	void pProcessMessage( const olotOcsMessage &message );
+	void pReceiveValue( int channel, float value, int64_t time );
+	void pUpdateValues();
+	void pPublishValues();
+	void pReadPublished( const std::atomic<float> *published, float *values, int count ) const;
+	void pInitValues();
 };
 
 #endif
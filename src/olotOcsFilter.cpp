@@ -0,0 +1,165 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <math.h>
+#include <algorithm>
+
+#include "olotOcsFilter.h"
+#include "exceptions/exceptions.h"
+
+
+// smallest time step in seconds used for filtering. guards against samples with identical
+// receive time dividing by zero
+static const float MinTimeStep = 1e-4f;
+
+static const float TwoPi = 6.283185307f;
+
+
+// one euro filter step for all channels. the smoothing factor of a low-pass filter with
+// cutoff frequency fc for time step dt is 1 / (1 + 1 / (2 pi fc dt)). channels with weight
+// 0 keep their state. the arrays never overlap. telling the compiler avoids runtime overlap
+// checks which prevent vectorization
+static void filterChannels( const float * __restrict values, const float * __restrict timeSteps,
+const float * __restrict weights, float * __restrict states, float * __restrict derivatives,
+float * __restrict filtered, int count, float derivativeScale, float minCutoffScale,
+float betaScale ){
+	int i;
+	for( i=0; i<count; i++ ){
+		const float timeStep = timeSteps[ i ];
+		const float weight = weights[ i ];
+		const float difference = values[ i ] - states[ i ];
+		
+		const float scaleDerivative = derivativeScale * timeStep;
+		const float alphaDerivative = scaleDerivative / ( scaleDerivative + 1.0f );
+		const float derivative = derivatives[ i ]
+			+ weight * alphaDerivative * ( difference / timeStep - derivatives[ i ] );
+		
+		const float scale = ( minCutoffScale + betaScale * fabsf( derivative ) ) * timeStep;
+		const float alpha = scale / ( scale + 1.0f );
+		const float value = states[ i ] + weight * alpha * difference;
+		
+		derivatives[ i ] = derivative;
+		states[ i ] = value;
+		filtered[ i ] = value;
+	}
+}
+
+
+// class olotOcsFilter
+////////////////////////
+
+olotOcsFilter::olotOcsFilter( int channelCount ) :
+pChannelCount( channelCount ),
+pEnabled( false ),
+pMinCutoff( 1.0f ),
+pBeta( 0.0f ),
+pDerivativeCutoff( 1.0f ),
+pValues( nullptr ),
+pDerivatives( nullptr ),
+pTimeSteps( nullptr ),
+pWeights( nullptr ),
+pLastTimes( nullptr )
+{
+	OLOTASSERT_TRUE( channelCount > 0, XR_ERROR_RUNTIME_FAILURE )
+	
+	pValues = new float[ channelCount ];
+	pDerivatives = new float[ channelCount ];
+	pTimeSteps = new float[ channelCount ];
+	pWeights = new float[ channelCount ];
+	pLastTimes = new int64_t[ channelCount ];
+	
+	int i;
+	for( i=0; i<channelCount; i++ ){
+		pValues[ i ] = 0.0f;
+		pDerivatives[ i ] = 0.0f;
+		pTimeSteps[ i ] = 1.0f;
+		pWeights[ i ] = 0.0f;
+		pLastTimes[ i ] = 0;
+	}
+}
+
+olotOcsFilter::~olotOcsFilter(){
+	delete [] pLastTimes;
+	delete [] pWeights;
+	delete [] pTimeSteps;
+	delete [] pDerivatives;
+	delete [] pValues;
+}
+
+
+
+// Management
+///////////////
+
+void olotOcsFilter::SetParameters( bool enabled, float minCutoff, float beta, float derivativeCutoff ){
+	OLOTASSERT_TRUE( minCutoff > 0.0f, XR_ERROR_RUNTIME_FAILURE )
+	OLOTASSERT_TRUE( beta >= 0.0f, XR_ERROR_RUNTIME_FAILURE )
+	OLOTASSERT_TRUE( derivativeCutoff > 0.0f, XR_ERROR_RUNTIME_FAILURE )
+	
+	pEnabled = enabled;
+	pMinCutoff = minCutoff;
+	pBeta = beta;
+	pDerivativeCutoff = derivativeCutoff;
+}
+
+void olotOcsFilter::Process( const float *values, const int64_t *times,
+const uint8_t *updated, float *filtered ){
+	int i;
+	
+	if( ! pEnabled ){
+		for( i=0; i<pChannelCount; i++ ){
+			if( updated[ i ] ){
+				filtered[ i ] = values[ i ];
+			}
+		}
+		return;
+	}
+	
+	// time steps and weights. updated channels use weight 1 and the rest weight 0 keeping
+	// their state unchanged. the first sample of a channel initializes the state
+	for( i=0; i<pChannelCount; i++ ){
+		pWeights[ i ] = 0.0f;
+		pTimeSteps[ i ] = 1.0f;
+		
+		if( ! updated[ i ] ){
+			continue;
+		}
+		
+		if( pLastTimes[ i ] == 0 ){
+			pValues[ i ] = values[ i ];
+			pDerivatives[ i ] = 0.0f;
+			
+		}else{
+			pTimeSteps[ i ] = std::max( ( float )( times[ i ] - pLastTimes[ i ] ) * 1e-9f, MinTimeStep );
+			pWeights[ i ] = 1.0f;
+		}
+		
+		pLastTimes[ i ] = times[ i ];
+	}
+	
+	// filter all channels at once
+	filterChannels( values, pTimeSteps, pWeights, pValues, pDerivatives, filtered, pChannelCount,
+		TwoPi * pDerivativeCutoff, TwoPi * pMinCutoff, TwoPi * pBeta );
+}
@@ -0,0 +1,96 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _OLOTOCSFILTER_H_
+#define _OLOTOCSFILTER_H_
+
+#include <stdint.h>
+
+
+/**
+ * Adaptive low-pass filter (One Euro filter) for all channels.
+ * 
+ * Each channel is smoothed with a cutoff frequency rising with the speed of the value
+ * change. Slow changes are smoothed strongly removing jitter while fast changes pass with
+ * little lag. Channel state is stored as arrays per property so all channels are filtered
+ * in a single branch-free loop. Used by the read thread only.
+ */
+class olotOcsFilter{
+private:
+	const int pChannelCount;
+	bool pEnabled;
+	float pMinCutoff;
+	float pBeta;
+	float pDerivativeCutoff;
+	
+	float *pValues;
+	float *pDerivatives;
+	float *pTimeSteps;
+	float *pWeights;
+	int64_t *pLastTimes;
+	
+	
+	
+public:
+	/** \name Constructors and Destructors */
+	/*@{*/
+	/** Create filter. */
+	olotOcsFilter( int channelCount );
+	
+	/** Clean up filter. */
+	~olotOcsFilter();
+	/*@}*/
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/** Channel count. */
+	inline int GetChannelCount() const{ return pChannelCount; }
+	
+	/** Filter is enabled. */
+	inline bool GetEnabled() const{ return pEnabled; }
+	
+	/**
+	 * Set parameters.
+	 * 
+	 * Cutoff frequencies are in Hz. Beta is the increase of the cutoff frequency per unit
+	 * of value change per second.
+	 */
+	void SetParameters( bool enabled, float minCutoff, float beta, float derivativeCutoff );
+	
+	/**
+	 * Filter channels.
+	 * 
+	 * Filters channels with updated not 0 using values and times. Times are CLOCK_MONOTONIC
+	 * nanoseconds. Filtered values are written to filtered. Other channels keep their value.
+	 * The first sample of a channel is passed through unfiltered. If the filter is disabled
+	 * values are copied.
+	 */
+	void Process( const float *values, const int64_t *times, const uint8_t *updated, float *filtered );
+	/*@}*/
+};
+
+#endif
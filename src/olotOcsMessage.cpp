@@ -22,22 +22,107 @@
  * SOFTWARE.
  */
 
-#include <string>
-#include <stdlib.h>
 #include <string.h>
 
 #include "olotOcsMessage.h"
 #include "exceptions/exceptions.h"
 
 
+// Definitions
+////////////////
+
+static inline size_t alignedLength( size_t length ){
+	return ( length + 3 ) & ~( size_t )3;
+}
+
+static inline uint32_t readUInt32( const uint8_t *data ){
+	return ( uint32_t )data[ 0 ] << 24
+		| ( ( uint32_t )data[ 1 ] << 16 )
+		| ( ( uint32_t )data[ 2 ] << 8 )
+		| ( ( uint32_t )data[ 3 ] );
+}
+
+static inline uint64_t readUInt64( const uint8_t *data ){
+	return ( ( uint64_t )readUInt32( data ) << 32 ) | ( uint64_t )readUInt32( data + 4 );
+}
+
+static bool typeFromTag( char tag, olotOcsMessage::eType &type ){
+	switch( tag ){
+	case 'f': type = olotOcsMessage::etFloat; return true;
+	case 'i': type = olotOcsMessage::etInteger; return true;
+	case 'h': type = olotOcsMessage::etInteger64; return true;
+	case 'd': type = olotOcsMessage::etDouble; return true;
+	case 's':
+	case 'S': type = olotOcsMessage::etString; return true;
+	case 'b': type = olotOcsMessage::etBlob; return true;
+	case 't': type = olotOcsMessage::etTimetag; return true;
+	case 'c': type = olotOcsMessage::etChar; return true;
+	case 'r': type = olotOcsMessage::etColor; return true;
+	case 'm': type = olotOcsMessage::etMidi; return true;
+	case 'T': type = olotOcsMessage::etTrue; return true;
+	case 'F': type = olotOcsMessage::etFalse; return true;
+	case 'N': type = olotOcsMessage::etNil; return true;
+	case 'I': type = olotOcsMessage::etImpulse; return true;
+	case '[': type = olotOcsMessage::etArrayBegin; return true;
+	case ']': type = olotOcsMessage::etArrayEnd; return true;
+	default: return false;
+	}
+}
+
+// size of argument data. returns false if the argument does not fit into the available data
+static bool argumentSize( olotOcsMessage::eType type, const uint8_t *data, size_t available, size_t &size ){
+	switch( type ){
+	case olotOcsMessage::etFloat:
+	case olotOcsMessage::etInteger:
+	case olotOcsMessage::etChar:
+	case olotOcsMessage::etColor:
+	case olotOcsMessage::etMidi:
+		size = 4;
+		break;
+		
+	case olotOcsMessage::etInteger64:
+	case olotOcsMessage::etDouble:
+	case olotOcsMessage::etTimetag:
+		size = 8;
+		break;
+		
+	case olotOcsMessage::etString:{
+		const uint8_t * const end = ( const uint8_t* )memchr( data, 0, available );
+		if( ! end ){
+			return false;
+		}
+		size = alignedLength( ( size_t )( end - data ) + 1 );
+		}break;
+		
+	case olotOcsMessage::etBlob:
+		if( available < 4 ){
+			return false;
+		}
+		size = 4 + alignedLength( readUInt32( data ) );
+		break;
+		
+	case olotOcsMessage::etTrue:
+	case olotOcsMessage::etFalse:
+	case olotOcsMessage::etNil:
+	case olotOcsMessage::etImpulse:
+	case olotOcsMessage::etArrayBegin:
+	case olotOcsMessage::etArrayEnd:
+		size = 0;
+		break;
+	}
+	
+	return size <= available;
+}
+
+
+
 // class olotOcsMessage
 /////////////////////////
 
 olotOcsMessage::olotOcsMessage() :
-pParameterCount( 0 )
-{
-	memset( pTarget, 0, sizeof( pTarget ) );
-	memset( pParameters, 0, sizeof( pParameters ) );
+pArguments( nullptr ),
+pArgumentsLength( 0 ),
+pReceiveTime( 0 ){
 }
 
 olotOcsMessage::~olotOcsMessage(){
@@ -49,84 +134,143 @@ olotOcsMessage::~olotOcsMessage(){
 ///////////////
 
 bool olotOcsMessage::Parse( const uint8_t *data, size_t length ){
-	size_t i = 0;
-	pParameterCount = 0;
+	pTarget = std::string_view();
+	pTypes = std::string_view();
+	pArguments = nullptr;
+	pArgumentsLength = 0;
 	
 	// target
-	int next = 0;
-	while( i < length ){
-		const uint8_t c = data[ i++ ];
-		if( ! c ){
-			i += ( 4 - i % 4) % 4;
-			break;
-		}
-		if( next == 255 ){
-			return false;
-		}
-		pTarget[ next++ ] = ( char )c;
+	const uint8_t * const endTarget = ( const uint8_t* )memchr( data, 0, length );
+	if( ! endTarget ){
+		return false;
+	}
+	
+	const size_t lengthTarget = ( size_t )( endTarget - data );
+	size_t i = alignedLength( lengthTarget + 1 );
+	if( i >= length || data[ i ] != ',' ){
+		return false;
 	}
-	pTarget[ next ] = 0;
 	
 	// types
-	if( i == length || data[ i ] != ',' ){
+	const char * const types = ( const char* )data + i + 1;
+	const uint8_t * const endTypes = ( const uint8_t* )memchr( types, 0, length - i - 1 );
+	if( ! endTypes ){
 		return false;
 	}
-	i++;
 	
-	int parameter = 0;
-	while( i < length ){
-		const uint8_t c = data[ i++ ];
-		if( ! c ){
-			i += ( 4 - i % 4) % 4;
+	const size_t lengthTypes = ( size_t )( ( const char* )endTypes - types );
+	i += alignedLength( lengthTypes + 2 );
+	if( i > length ){
+		return false;
+	}
+	
+	// parameters. the size of arguments following an unknown type tag can not be determined.
+	// in this case the message is truncated to the known parameters. arguments exceeding
+	// the message length are malformed and reject the message
+	const uint8_t * const arguments = data + i;
+	const size_t lengthArguments = length - i;
+	size_t offset = 0, typeCount;
+	
+	for( typeCount=0; typeCount<lengthTypes; typeCount++ ){
+		eType type;
+		if( ! typeFromTag( types[ typeCount ], type ) ){
 			break;
 		}
-		if( parameter == 16 ){
-			return false;
-		}
 		
-		switch( c ){
-		case 'f':
-			pParameters[ parameter++ ].type = etFloat;
-			break;
-			
-		case 'i':
-			pParameters[ parameter++ ].type = etInteger;
-			break;
-			
-		default:
+		size_t size;
+		if( ! argumentSize( type, arguments + offset, lengthArguments - offset, size ) ){
 			return false;
 		}
+		offset += size;
 	}
 	
-	// parameters
-	for( pParameterCount=0; pParameterCount<parameter; pParameterCount++ ){
-		sParameter &p = pParameters[ pParameterCount ];
-		
-		switch( p.type ){
-		case etFloat:
-			p.valueInt = ( uint32_t )data[ i ] << 24
-				| ( ( uint32_t )data[ i + 1 ] << 16 )
-				| ( ( uint32_t )data[ i + 2 ] << 8 )
-				| ( ( uint32_t )data[ i + 3 ] );
-			i += 4;
-			memcpy( &p.valueFloat, &p.valueInt, 4 );
-			break;
-			
-		case etInteger:
-			p.valueInt = ( uint32_t )data[ i ] << 24
-				| ( ( uint32_t )data[ i + 1 ] << 16 )
-				| ( ( uint32_t )data[ i + 2 ] << 8 )
-				| ( ( uint32_t )data[ i + 3 ] );
-			i += 4;
-			break;
-		}
-	}
-	
+	pTarget = std::string_view( ( const char* )data, lengthTarget );
+	pTypes = std::string_view( types, typeCount );
+	pArguments = arguments;
+	pArgumentsLength = offset;
 	return true;
 }
 
-const olotOcsMessage::sParameter &olotOcsMessage::GetParameterAt( int index ) const{
+olotOcsMessage::eType olotOcsMessage::GetParameterTypeAt( int index ) const{
 	OLOTASSERT_TRUE( index >= 0, XR_ERROR_RUNTIME_FAILURE )
-	OLOTASSERT_TRUE( index < pParameterCount, XR_ERROR_RUNTIME_FAILURE )
-	return pParameters[ index ];
+	OLOTASSERT_TRUE( index < GetParameterCount(), XR_ERROR_RUNTIME_FAILURE )
+	
+	eType type = etNil;
+	typeFromTag( pTypes[ index ], type );
+	return type;
+}
+
+float olotOcsMessage::GetParameterFloatAt( int index ) const{
+	OLOTASSERT_TRUE( GetParameterTypeAt( index ) == etFloat, XR_ERROR_RUNTIME_FAILURE )
+	const uint32_t value = readUInt32( pArgumentAt( index ) );
+	float valueFloat;
+	memcpy( &valueFloat, &value, 4 );
+	return valueFloat;
+}
+
+int32_t olotOcsMessage::GetParameterIntAt( int index ) const{
+	OLOTASSERT_TRUE( GetParameterTypeAt( index ) == etInteger, XR_ERROR_RUNTIME_FAILURE )
+	return ( int32_t )readUInt32( pArgumentAt( index ) );
+}
+
+std::string_view olotOcsMessage::GetParameterStringAt( int index ) const{
+	OLOTASSERT_TRUE( GetParameterTypeAt( index ) == etString, XR_ERROR_RUNTIME_FAILURE )
+	return std::string_view( ( const char* )pArgumentAt( index ) );
+}
+
+bool olotOcsMessage::GetParameterAsFloatAt( int index, float &value ) const{
+	switch( GetParameterTypeAt( index ) ){
+	case etFloat:
+		value = GetParameterFloatAt( index );
+		return true;
+		
+	case etInteger:
+		value = ( float )GetParameterIntAt( index );
+		return true;
+		
+	case etInteger64:
+		value = ( float )( int64_t )readUInt64( pArgumentAt( index ) );
+		return true;
+		
+	case etDouble:{
+		const uint64_t bits = readUInt64( pArgumentAt( index ) );
+		double valueDouble;
+		memcpy( &valueDouble, &bits, 8 );
+		value = ( float )valueDouble;
+		}return true;
+		
+	case etTrue:
+		value = 1.0f;
+		return true;
+		
+	case etFalse:
+		value = 0.0f;
+		return true;
+		
+	default:
+		return false;
+	}
+}
+
+
+
+// Private Functions
+//////////////////////
+
+const uint8_t *olotOcsMessage::pArgumentAt( int index ) const{
+	const uint8_t *data = pArguments;
+	size_t available = pArgumentsLength;
+	int i;
+	
+	for( i=0; i<index; i++ ){
+		eType type = etNil;
+		typeFromTag( pTypes[ i ], type );
+		
+		size_t size = 0;
+		argumentSize( type, data, available, size );
+		data += size;
+		available -= size;
+	}
+	
+	return data;
 }
@@ -25,37 +25,89 @@
 #ifndef _OLOTOCSMESSAGE_H_
 #define _OLOTOCSMESSAGE_H_
 
-#include <string>
-#include <memory>
+#include <stdint.h>
+#include <stddef.h>
+#include <string_view>
 
 
 /**
  * OCS Message.
+ * 
+ * Non-owning view of a message inside a receive buffer. The buffer has to stay valid as
+ * long as the message is used. Parsing only validates the message layout. Parameters
+ * are decoded from the buffer when requested.
+ * 
+ * Supports all OSC 1.0 and 1.1 type tags. If an unknown type tag is encountered the size
+ * of the following arguments can not be determined. The message is then truncated to
+ * the parameters before the unknown type tag instead of being rejected.
  */
 class olotOcsMessage{
 public:
 	enum eType{
+		/** 'f': 32-bit float. */
 		etFloat,
-		etInteger
+		
+		/** 'i': 32-bit integer. */
+		etInteger,
+		
+		/** 'h': 64-bit integer. */
+		etInteger64,
+		
+		/** 'd': 64-bit float. */
+		etDouble,
+		
+		/** 's' or 'S': string or symbol. */
+		etString,
+		
+		/** 'b': blob. */
+		etBlob,
+		
+		/** 't': 64-bit NTP timetag. */
+		etTimetag,
+		
+		/** 'c': 32-bit character. */
+		etChar,
+		
+		/** 'r': 32-bit RGBA color. */
+		etColor,
+		
+		/** 'm': 4 byte MIDI message. */
+		etMidi,
+		
+		/** 'T': true without data. */
+		etTrue,
+		
+		/** 'F': false without data. */
+		etFalse,
+		
+		/** 'N': nil without data. */
+		etNil,
+		
+		/** 'I': impulse without data. */
+		etImpulse,
+		
+		/** '[': begin of array without data. */
+		etArrayBegin,
+		
+		/** ']': end of array without data. */
+		etArrayEnd
 	};
 	
-	struct sParameter{
-		eType type;
-		float valueFloat;
-		uint32_t valueInt;
-	};
+	
 	
 private:
-	char pTarget[ 256 ];
-	sParameter pParameters[ 16 ];
-	int pParameterCount;
+	std::string_view pTarget;
+	std::string_view pTypes;
+	const uint8_t *pArguments;
+	size_t pArgumentsLength;
+	int64_t pReceiveTime;
 	
 	
 	
 public:
 	/** \name Constructors and Destructors */
 	/*@{*/
-	/** Create OCS Message. */
+	/** Create empty OCS Message. */
 	olotOcsMessage();
 	
 	/** Clean up OCS Message. */
@@ -66,22 +118,46 @@ public:
 	
 	/** \name Management */
 	/*@{*/
-	/** Parse message. */
+	/** Parse message. Message refers to data afterwards. */
 	bool Parse( const uint8_t *data, size_t length );
 	
-	/** Target. */
-	inline const char *GetTarget() const{ return ( const char* )pTarget; }
+	/** Arrival time of packet containing message in CLOCK_MONOTONIC nanoseconds. */
+	inline int64_t GetReceiveTime() const{ return pReceiveTime; }
+	
+	/** Set arrival time of packet containing message in CLOCK_MONOTONIC nanoseconds. */
+	inline void SetReceiveTime( int64_t time ){ pReceiveTime = time; }
+	
+	/** Target. Not null terminated. */
+	inline const std::string_view &GetTarget() const{ return pTarget; }
 	
 	/** Parameter count. */
-	inline int GetParameterCount() const{ return pParameterCount; }
+	inline int GetParameterCount() const{ return ( int )pTypes.size(); }
+	
+	/** Type of parameter at index. */
+	eType GetParameterTypeAt( int index ) const;
+	
+	/** Float value of parameter at index. Parameter has to be of type etFloat. */
+	float GetParameterFloatAt( int index ) const;
+	
+	/** Integer value of parameter at index. Parameter has to be of type etInteger. */
+	int32_t GetParameterIntAt( int index ) const;
+	
+	/** String value of parameter at index. Parameter has to be of type etString. */
+	std::string_view GetParameterStringAt( int index ) const;
 	
-	/** Parameter at index. */
-	const sParameter &GetParameterAt( int index ) const;
+	/**
+	 * Numeric value of parameter at index converted to float.
+	 * 
+	 * Supports etFloat, etInteger, etInteger64, etDouble, etTrue and etFalse. Returns
+	 * false if the parameter is not numeric.
+	 */
+	bool GetParameterAsFloatAt( int index, float &value ) const;
 	/*@}*/
 	
 	
 	
 private:
+	const uint8_t *pArgumentAt( int index ) const;
 };
 
 #endif
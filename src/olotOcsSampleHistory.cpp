@@ -0,0 +1,159 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include <stdlib.h>
+#include <algorithm>
+
+#include "olotOcsSampleHistory.h"
+#include "exceptions/exceptions.h"
+
+
+// class olotOcsSampleHistory
+///////////////////////////////
+
+olotOcsSampleHistory::olotOcsSampleHistory( int channelCount ) :
+pChannelCount( channelCount ),
+pTimes( nullptr ),
+pValues( nullptr ),
+pWriteCounts( nullptr )
+{
+	OLOTASSERT_TRUE( channelCount > 0, XR_ERROR_RUNTIME_FAILURE )
+	
+	pTimes = new std::atomic<int64_t>[ channelCount * SampleCount ];
+	pValues = new std::atomic<float>[ channelCount * SampleCount ];
+	pWriteCounts = new std::atomic<uint32_t>[ channelCount ];
+	
+	int i;
+	for( i=0; i<channelCount * SampleCount; i++ ){
+		pTimes[ i ].store( 0, std::memory_order_relaxed );
+		pValues[ i ].store( 0.0f, std::memory_order_relaxed );
+	}
+	for( i=0; i<channelCount; i++ ){
+		pWriteCounts[ i ].store( 0, std::memory_order_relaxed );
+	}
+}
+
+olotOcsSampleHistory::~olotOcsSampleHistory(){
+	delete [] pWriteCounts;
+	delete [] pValues;
+	delete [] pTimes;
+}
+
+
+
+// Management
+///////////////
+
+void olotOcsSampleHistory::AddSample( int channel, int64_t time, float value ){
+	const uint32_t count = pWriteCounts[ channel ].load( std::memory_order_relaxed );
+	const int index = channel * SampleCount + ( int )( count & ( SampleCount - 1 ) );
+	
+	pTimes[ index ].store( time, std::memory_order_relaxed );
+	pValues[ index ].store( value, std::memory_order_relaxed );
+	pWriteCounts[ channel ].store( count + 1, std::memory_order_relaxed );
+}
+
+int olotOcsSampleHistory::GetSamples( int channel, sSample *samples, int maxCount ) const{
+	OLOTASSERT_TRUE( channel >= 0, XR_ERROR_RUNTIME_FAILURE )
+	OLOTASSERT_TRUE( channel < pChannelCount, XR_ERROR_RUNTIME_FAILURE )
+	
+	const int base = channel * SampleCount;
+	uint32_t sequence;
+	int i, count;
+	
+	do{
+		sequence = pLock.BeginRead();
+		
+		const uint32_t writeCount = pWriteCounts[ channel ].load( std::memory_order_relaxed );
+		count = ( int )std::min( writeCount, ( uint32_t )SampleCount );
+		count = std::min( count, maxCount );
+		
+		for( i=0; i<count; i++ ){
+			const int index = base + ( int )( ( writeCount - 1 - i ) & ( SampleCount - 1 ) );
+			samples[ i ].time = pTimes[ index ].load( std::memory_order_relaxed );
+			samples[ i ].value = pValues[ index ].load( std::memory_order_relaxed );
+		}
+	}while( pLock.RetryRead( sequence ) );
+	
+	return count;
+}
+
+int64_t olotOcsSampleHistory::GetLastSampleTime( int channel ) const{
+	sSample sample;
+	return GetSamples( channel, &sample, 1 ) == 1 ? sample.time : 0;
+}
+
+bool olotOcsSampleHistory::GetValueAt( int channel, int64_t time, float &value ) const{
+	sSample samples[ SampleCount ];
+	const int count = GetSamples( channel, samples, SampleCount );
+	if( count == 0 ){
+		return false;
+	}
+	
+	if( time >= samples[ 0 ].time ){
+		value = samples[ 0 ].value;
+		return true;
+	}
+	
+	int i;
+	for( i=1; i<count; i++ ){
+		const sSample &older = samples[ i ];
+		if( time < older.time ){
+			continue;
+		}
+		
+		const sSample &newer = samples[ i - 1 ];
+		const int64_t interval = newer.time - older.time;
+		if( interval <= 0 ){
+			value = newer.value;
+			
+		}else{
+			const float blend = ( float )( time - older.time ) / ( float )interval;
+			value = older.value + ( newer.value - older.value ) * blend;
+		}
+		return true;
+	}
+	
+	value = samples[ count - 1 ].value;
+	return true;
+}
+
+int64_t olotOcsSampleHistory::GetJitter( int channel ) const{
+	sSample samples[ SampleCount ];
+	const int count = GetSamples( channel, samples, SampleCount );
+	if( count < 3 ){
+		return 0;
+	}
+	
+	const int intervalCount = count - 1;
+	const int64_t mean = ( samples[ 0 ].time - samples[ count - 1 ].time ) / intervalCount;
+	int64_t deviation = 0;
+	int i;
+	
+	for( i=0; i<intervalCount; i++ ){
+		deviation += llabs( ( samples[ i ].time - samples[ i + 1 ].time ) - mean );
+	}
+	
+	return deviation / intervalCount;
+}
@@ -0,0 +1,117 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _OLOTOCSSAMPLEHISTORY_H_
+#define _OLOTOCSSAMPLEHISTORY_H_
+
+#include <atomic>
+#include <stdint.h>
+
+#include "utils/olotSeqLock.h"
+
+
+/**
+ * History of timestamped samples per channel.
+ * 
+ * Each channel keeps the latest samples in a ring buffer. Timestamps are CLOCK_MONOTONIC
+ * nanoseconds of the packet arrival. Samples are written by the read thread between
+ * BeginWrite and EndWrite. Reading is lock-free and never blocks the read thread.
+ */
+class olotOcsSampleHistory{
+public:
+	/** Sample. */
+	struct sSample{
+		int64_t time;
+		float value;
+	};
+	
+	/** Number of samples kept per channel. Has to be a power of two. */
+	const static int SampleCount = 16;
+	
+	
+	
+private:
+	const int pChannelCount;
+	olotSeqLock pLock;
+	std::atomic<int64_t> *pTimes;
+	std::atomic<float> *pValues;
+	std::atomic<uint32_t> *pWriteCounts;
+	
+	
+	
+public:
+	/** \name Constructors and Destructors */
+	/*@{*/
+	/** Create sample history. */
+	olotOcsSampleHistory( int channelCount );
+	
+	/** Clean up sample history. */
+	~olotOcsSampleHistory();
+	/*@}*/
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/** Channel count. */
+	inline int GetChannelCount() const{ return pChannelCount; }
+	
+	/** Begin adding samples. For use by the read thread only. */
+	inline void BeginWrite(){ pLock.BeginWrite(); }
+	
+	/** Add sample. For use by the read thread only between BeginWrite and EndWrite. */
+	void AddSample( int channel, int64_t time, float value );
+	
+	/** End adding samples. */
+	inline void EndWrite(){ pLock.EndWrite(); }
+	
+	/**
+	 * Copy samples of channel ordered from newest to oldest.
+	 * 
+	 * Returns the number of copied samples which is at most maxCount and SampleCount.
+	 */
+	int GetSamples( int channel, sSample *samples, int maxCount ) const;
+	
+	/** Arrival time of the newest sample of channel or 0 if no sample has been received. */
+	int64_t GetLastSampleTime( int channel ) const;
+	
+	/**
+	 * Value of channel at time.
+	 * 
+	 * Interpolates linearly between the samples enclosing time. Times before the oldest
+	 * sample use the oldest sample and times after the newest sample use the newest
+	 * sample. Returns false if the channel has no samples.
+	 */
+	bool GetValueAt( int channel, int64_t time, float &value ) const;
+	
+	/**
+	 * Mean absolute deviation of the sample inter-arrival times in nanoseconds.
+	 * 
+	 * Returns 0 if the channel has less than three samples.
+	 */
+	int64_t GetJitter( int channel ) const;
+	/*@}*/
+};
+
+#endif
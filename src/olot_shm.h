@@ -0,0 +1,223 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _OLOT_SHM_H_
+#define _OLOT_SHM_H_
+
+/*
+ * Shared memory transport.
+ * 
+ * Producers on the same machine write fixed layout frames into a ring stored in a POSIX
+ * shared memory object. The layer reads the ring instead of listening for OSC packets if
+ * OCSEYEFACETRACKING_SHM_NAME is set to the name of the object.
+ * 
+ * Producer usage:
+ * - shm_open( name, O_CREAT | O_RDWR, 0600 ), ftruncate to sizeof( olot_shm_ring ) and mmap
+ *   the object using PROT_READ | PROT_WRITE and MAP_SHARED.
+ * - Call olot_shm_init if the magic does not match OLOT_SHM_MAGIC.
+ * - Fill an olot_shm_frame and call olot_shm_write for each captured sample.
+ * - Do not unlink the object while the layer is running. The layer keeps the mapping.
+ * 
+ * C producers compiled with a strict language standard have to define _GNU_SOURCE.
+ * 
+ * There is exactly one producer. The producer never waits for the layer. Frames the layer
+ * did not read in time are overwritten and counted as lost.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OLOT_SHM_MAGIC 0x544f4c4fu
+#define OLOT_SHM_VERSION 1
+#define OLOT_SHM_FRAME_COUNT 64
+#define OLOT_SHM_DEFAULT_NAME "/ocseyefacetracking"
+
+/* Expression indices. Same order and meaning as the OCS expression addresses. */
+enum olot_shm_expression{
+	OLOT_SHM_CHEEK_PUFF_LEFT,
+	OLOT_SHM_CHEEK_PUFF_RIGHT,
+	OLOT_SHM_CHEEK_SUCK_LEFT,
+	OLOT_SHM_CHEEK_SUCK_RIGHT,
+	OLOT_SHM_JAW_OPEN,
+	OLOT_SHM_JAW_FORWARD,
+	OLOT_SHM_JAW_LEFT,
+	OLOT_SHM_JAW_RIGHT,
+	OLOT_SHM_NOSE_SNEER_LEFT,
+	OLOT_SHM_NOSE_SNEER_RIGHT,
+	OLOT_SHM_MOUTH_FUNNEL,
+	OLOT_SHM_MOUTH_PUCKER,
+	OLOT_SHM_MOUTH_LEFT,
+	OLOT_SHM_MOUTH_RIGHT,
+	OLOT_SHM_MOUTH_ROLL_UPPER,
+	OLOT_SHM_MOUTH_ROLL_LOWER,
+	OLOT_SHM_MOUTH_SHRUG_UPPER,
+	OLOT_SHM_MOUTH_SHRUG_LOWER,
+	OLOT_SHM_MOUTH_CLOSE,
+	OLOT_SHM_MOUTH_SMILE_LEFT,
+	OLOT_SHM_MOUTH_SMILE_RIGHT,
+	OLOT_SHM_MOUTH_FROWN_LEFT,
+	OLOT_SHM_MOUTH_FROWN_RIGHT,
+	OLOT_SHM_MOUTH_DIMPLE_LEFT,
+	OLOT_SHM_MOUTH_DIMPLE_RIGHT,
+	OLOT_SHM_MOUTH_UPPER_UP_LEFT,
+	OLOT_SHM_MOUTH_UPPER_UP_RIGHT,
+	OLOT_SHM_MOUTH_LOWER_DOWN_LEFT,
+	OLOT_SHM_MOUTH_LOWER_DOWN_RIGHT,
+	OLOT_SHM_MOUTH_PRESS_LEFT,
+	OLOT_SHM_MOUTH_PRESS_RIGHT,
+	OLOT_SHM_MOUTH_STRETCH_LEFT,
+	OLOT_SHM_MOUTH_STRETCH_RIGHT,
+	OLOT_SHM_TONGUE_OUT,
+	OLOT_SHM_TONGUE_UP,
+	OLOT_SHM_TONGUE_DOWN,
+	OLOT_SHM_TONGUE_LEFT,
+	OLOT_SHM_TONGUE_RIGHT,
+	OLOT_SHM_TONGUE_ROLL,
+	OLOT_SHM_TONGUE_BEND_DOWN,
+	OLOT_SHM_TONGUE_CURL_UP,
+	OLOT_SHM_TONGUE_SQUISH,
+	OLOT_SHM_TONGUE_FLAT,
+	OLOT_SHM_TONGUE_TWIST_LEFT,
+	OLOT_SHM_TONGUE_TWIST_RIGHT,
+	OLOT_SHM_LEFT_EYE_LID_EXPANDED_SQUEEZE,
+	OLOT_SHM_RIGHT_EYE_LID_EXPANDED_SQUEEZE,
+	OLOT_SHM_EXPRESSION_COUNT
+};
+
+/* Eye state indices. Values range from -1 to 1. */
+enum olot_shm_eye_state{
+	OLOT_SHM_LEFT_EYE_X,
+	OLOT_SHM_RIGHT_EYE_X,
+	OLOT_SHM_EYES_Y,
+	OLOT_SHM_EYE_STATE_COUNT
+};
+
+/* Frame of values. */
+typedef struct olot_shm_frame{
+	/* Sequence number. Set by olot_shm_write. Frame n has sequence n + 1. */
+	uint64_t sequence;
+	
+	/* CLOCK_MONOTONIC nanoseconds the values have been captured or 0 to use the read time. */
+	int64_t time;
+	
+	/* Bit i is set if expressions[i] is valid. */
+	uint64_t expression_mask;
+	
+	/* Bit i is set if eye_states[i] is valid. */
+	uint32_t eye_state_mask;
+	
+	uint32_t reserved;
+	
+	float expressions[ OLOT_SHM_EXPRESSION_COUNT ];
+	float eye_states[ OLOT_SHM_EYE_STATE_COUNT ];
+} olot_shm_frame;
+
+/* Ring stored in the shared memory object. */
+typedef struct olot_shm_ring{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t frame_count;
+	uint32_t frame_size;
+	
+	/* Number of frames written so far. */
+	uint64_t head __attribute__(( aligned( 64 ) ));
+	
+	/* Futex word incremented after each written frame. */
+	uint32_t signal;
+	
+	/* Nonzero while the layer waits on signal. */
+	uint32_t waiting;
+	
+	olot_shm_frame frames[ OLOT_SHM_FRAME_COUNT ] __attribute__(( aligned( 64 ) ));
+} olot_shm_ring;
+
+/* Initialize ring. Magic is written last. */
+static inline void olot_shm_init( olot_shm_ring *ring ){
+	memset( ring, 0, sizeof( olot_shm_ring ) );
+	ring->version = OLOT_SHM_VERSION;
+	ring->frame_count = OLOT_SHM_FRAME_COUNT;
+	ring->frame_size = sizeof( olot_shm_frame );
+	__atomic_store_n( &ring->magic, OLOT_SHM_MAGIC, __ATOMIC_RELEASE );
+}
+
+/* Ring is initialized and has a compatible layout. */
+static inline int olot_shm_valid( const olot_shm_ring *ring ){
+	return __atomic_load_n( &ring->magic, __ATOMIC_ACQUIRE ) == OLOT_SHM_MAGIC
+		&& ring->version == OLOT_SHM_VERSION
+		&& ring->frame_count == OLOT_SHM_FRAME_COUNT
+		&& ring->frame_size == sizeof( olot_shm_frame );
+}
+
+/* Write frame. The sequence of frame is ignored. Wakes the layer if it is waiting. */
+static inline void olot_shm_write( olot_shm_ring *ring, const olot_shm_frame *frame ){
+	const uint64_t head = __atomic_load_n( &ring->head, __ATOMIC_RELAXED );
+	olot_shm_frame * const slot = &ring->frames[ head % OLOT_SHM_FRAME_COUNT ];
+	
+	/* sequence 0 marks the slot as being written */
+	__atomic_store_n( &slot->sequence, 0, __ATOMIC_RELAXED );
+	__atomic_thread_fence( __ATOMIC_RELEASE );
+	
+	memcpy( ( char* )slot + sizeof( slot->sequence ), ( const char* )frame + sizeof( frame->sequence ),
+		sizeof( olot_shm_frame ) - sizeof( frame->sequence ) );
+	
+	__atomic_store_n( &slot->sequence, head + 1, __ATOMIC_RELEASE );
+	__atomic_store_n( &ring->head, head + 1, __ATOMIC_RELEASE );
+	
+	__atomic_add_fetch( &ring->signal, 1, __ATOMIC_SEQ_CST );
+	if( __atomic_load_n( &ring->waiting, __ATOMIC_SEQ_CST ) ){
+		syscall( SYS_futex, &ring->signal, FUTEX_WAKE, 1, NULL, NULL, 0 );
+	}
+}
+
+/*
+ * Read frame number index. Returns 1 on success or 0 if the frame has been overwritten
+ * or is being written.
+ */
+static inline int olot_shm_read( const olot_shm_ring *ring, uint64_t index, olot_shm_frame *frame ){
+	const olot_shm_frame * const slot = &ring->frames[ index % OLOT_SHM_FRAME_COUNT ];
+	
+	const uint64_t sequence = __atomic_load_n( &slot->sequence, __ATOMIC_ACQUIRE );
+	if( sequence != index + 1 ){
+		return 0;
+	}
+	
+	memcpy( frame, slot, sizeof( olot_shm_frame ) );
+	
+	__atomic_thread_fence( __ATOMIC_ACQUIRE );
+	return __atomic_load_n( &slot->sequence, __ATOMIC_RELAXED ) == sequence;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
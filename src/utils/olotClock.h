@@ -0,0 +1,68 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _OLOTCLOCK_H_
+#define _OLOTCLOCK_H_
+
+#include <stdint.h>
+#include <time.h>
+
+
+/**
+ * Clock functions. All times are CLOCK_MONOTONIC nanoseconds unless noted otherwise.
+ */
+class olotClock{
+public:
+	/** Nanoseconds of timespec. */
+	static inline int64_t FromTimespec( const timespec &time ){
+		return ( int64_t )time.tv_sec * 1000000000LL + ( int64_t )time.tv_nsec;
+	}
+	
+	/** Current time. */
+	static inline int64_t Now(){
+		timespec time;
+		clock_gettime( CLOCK_MONOTONIC, &time );
+		return FromTimespec( time );
+	}
+	
+	/**
+	 * Current CLOCK_REALTIME time in nanoseconds with a resolution of a few milliseconds.
+	 * Considerably faster than reading the precise clock.
+	 */
+	static inline int64_t RealtimeCoarse(){
+		timespec time;
+		clock_gettime( CLOCK_REALTIME_COARSE, &time );
+		return FromTimespec( time );
+	}
+	
+	/** Current offset of CLOCK_REALTIME relative to CLOCK_MONOTONIC. */
+	static inline int64_t RealtimeOffset(){
+		timespec realtime, monotonic;
+		clock_gettime( CLOCK_REALTIME, &realtime );
+		clock_gettime( CLOCK_MONOTONIC, &monotonic );
+		return FromTimespec( realtime ) - FromTimespec( monotonic );
+	}
+};
+
+#endif
@@ -0,0 +1,246 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _OLOTHANDLEREGISTRY_H_
+#define _OLOTHANDLEREGISTRY_H_
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+
+#include "olotRcu.h"
+
+
+/**
+ * Registry mapping OpenXR handles to values.
+ * 
+ * Values are stored in an immutable open addressing table. Lookups read the currently
+ * published table inside an RCU read section and are wait-free. Modifications are
+ * serialized, build a new table, publish it and delete the old table once no reader can
+ * use it anymore. Modifications are expected to be rare compared to lookups.
+ */
+template<class Handle, class Value> class olotHandleRegistry{
+private:
+	struct sEntry{
+		uint64_t key;
+		Value value;
+	};
+	
+	struct sTable{
+		uint64_t mask;
+		int count;
+		std::vector<sEntry> entries;
+	};
+	
+	/** Minimum number of table entries. Has to be a power of two. */
+	const static int MinTableSize = 16;
+	
+	
+	
+	std::atomic<sTable*> pTable;
+	std::mutex pMutexWrite;
+	
+	
+	
+public:
+	/** \name Constructors and Destructors */
+	/*@{*/
+	/** Create registry. */
+	olotHandleRegistry() : pTable( pCreateTable( 0 ) ){
+	}
+	
+	/** Clean up registry. */
+	~olotHandleRegistry(){
+		delete pTable.load( std::memory_order_relaxed );
+	}
+	
+	olotHandleRegistry( const olotHandleRegistry & ) = delete;
+	olotHandleRegistry &operator=( const olotHandleRegistry & ) = delete;
+	/*@}*/
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/** Copy value of handle. Returns false if absent. Wait-free. */
+	bool Get( Handle handle, Value &value ) const{
+		const uint64_t key = pKey( handle );
+		if( key == 0 ){
+			return false;
+		}
+		
+		const olotRcu::ReadGuard guard;
+		const sTable &table = *pTable.load( std::memory_order_acquire );
+		uint64_t index = pHash( key ) & table.mask;
+		
+		while( true ){
+			const sEntry &entry = table.entries[ index ];
+			if( entry.key == key ){
+				value = entry.value;
+				return true;
+			}
+			if( entry.key == 0 ){
+				return false;
+			}
+			index = ( index + 1 ) & table.mask;
+		}
+	}
+	
+	/** Handle is present. Wait-free. */
+	bool Has( Handle handle ) const{
+		Value value;
+		return Get( handle, value );
+	}
+	
+	/**
+	 * Call function with each value. Wait-free.
+	 * 
+	 * Function is called inside a read section and must not modify the registry.
+	 */
+	template<class Function> void ForEach( Function function ) const{
+		const olotRcu::ReadGuard guard;
+		const sTable &table = *pTable.load( std::memory_order_acquire );
+		for( const sEntry &entry : table.entries ){
+			if( entry.key != 0 ){
+				function( entry.value );
+			}
+		}
+	}
+	
+	/** Set value of handle replacing the existing value if present. */
+	void Set( Handle handle, const Value &value ){
+		const uint64_t key = pKey( handle );
+		if( key == 0 ){
+			return;
+		}
+		
+		const std::lock_guard<std::mutex> guard( pMutexWrite );
+		const sTable &table = *pTable.load( std::memory_order_relaxed );
+		sTable * const newTable = pCreateTable( table.count + 1 );
+		
+		for( const sEntry &entry : table.entries ){
+			if( entry.key != 0 && entry.key != key ){
+				pInsert( *newTable, entry.key, entry.value );
+			}
+		}
+		pInsert( *newTable, key, value );
+		
+		pPublish( newTable );
+	}
+	
+	/** Remove handle if present. */
+	void Remove( Handle handle ){
+		const uint64_t key = pKey( handle );
+		RemoveIf( [ key ]( uint64_t entryKey, const Value & ){
+			return entryKey == key;
+		} );
+	}
+	
+	/** Remove all handles whose value matches. */
+	void RemoveValue( const Value &value ){
+		RemoveIf( [ &value ]( uint64_t, const Value &entryValue ){
+			return entryValue == value;
+		} );
+	}
+	
+	/**
+	 * Remove all entries for which predicate returns true.
+	 * 
+	 * Predicate is called with the handle as uint64_t and the value.
+	 */
+	template<class Predicate> void RemoveIf( Predicate predicate ){
+		const std::lock_guard<std::mutex> guard( pMutexWrite );
+		const sTable &table = *pTable.load( std::memory_order_relaxed );
+		
+		int removeCount = 0;
+		for( const sEntry &entry : table.entries ){
+			if( entry.key != 0 && predicate( entry.key, entry.value ) ){
+				removeCount++;
+			}
+		}
+		if( removeCount == 0 ){
+			return;
+		}
+		
+		sTable * const newTable = pCreateTable( table.count - removeCount );
+		for( const sEntry &entry : table.entries ){
+			if( entry.key != 0 && ! predicate( entry.key, entry.value ) ){
+				pInsert( *newTable, entry.key, entry.value );
+			}
+		}
+		
+		pPublish( newTable );
+	}
+	/*@}*/
+	
+	
+	
+private:
+	static inline uint64_t pKey( Handle handle ){
+		static_assert( sizeof( Handle ) <= sizeof( uint64_t ), "handle larger than 64 bits" );
+		uint64_t key = 0;
+		memcpy( &key, &handle, sizeof( Handle ) );
+		return key;
+	}
+	
+	// fibonacci hashing. handles are often aligned pointers with low bits unused
+	static inline uint64_t pHash( uint64_t key ){
+		return ( key * 0x9e3779b97f4a7c15ULL ) >> 32;
+	}
+	
+	// table size is at least twice the count keeping probe sequences short
+	static sTable *pCreateTable( int count ){
+		uint64_t size = MinTableSize;
+		while( size < ( uint64_t )count * 2 ){
+			size <<= 1;
+		}
+		
+		sTable * const table = new sTable;
+		table->mask = size - 1;
+		table->count = 0;
+		table->entries.resize( size, sEntry{ 0, Value() } );
+		return table;
+	}
+	
+	static void pInsert( sTable &table, uint64_t key, const Value &value ){
+		uint64_t index = pHash( key ) & table.mask;
+		while( table.entries[ index ].key != 0 ){
+			index = ( index + 1 ) & table.mask;
+		}
+		table.entries[ index ].key = key;
+		table.entries[ index ].value = value;
+		table.count++;
+	}
+	
+	void pPublish( sTable *table ){
+		sTable * const oldTable = pTable.exchange( table, std::memory_order_seq_cst );
+		olotRcu::Synchronize();
+		delete oldTable;
+	}
+};
+
+#endif
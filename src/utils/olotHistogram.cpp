@@ -0,0 +1,134 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <iomanip>
+
+#include "olotHistogram.h"
+
+
+// Definitions
+////////////////
+
+static const double vPercentiles[] = { 50.0, 90.0, 99.0, 99.9 };
+static const int vPercentileCount = sizeof( vPercentiles ) / sizeof( vPercentiles[ 0 ] );
+
+static inline double toMicroSeconds( uint64_t value ){
+	return ( double )value / 1000.0;
+}
+
+
+
+// class olotHistogram
+////////////////////////
+
+olotHistogram::olotHistogram( const char *name ) :
+pName( name )
+{
+	Reset();
+}
+
+
+
+// Management
+///////////////
+
+void olotHistogram::Dump( std::ostream &stream, bool reset ){
+	uint64_t counts[ BucketCount ];
+	uint64_t total = 0;
+	double sum = 0.0;
+	int i;
+	
+	for( i=0; i<BucketCount; i++ ){
+		counts[ i ] = reset ? pCounts[ i ].exchange( 0, std::memory_order_relaxed )
+			: pCounts[ i ].load( std::memory_order_relaxed );
+		
+		if( counts[ i ] > 0 ){
+			total += counts[ i ];
+			sum += ( double )counts[ i ] * 0.5 * ( double )( BucketLowest( i ) + BucketHighest( i ) );
+		}
+	}
+	
+	stream << pName << ": count " << total;
+	if( total == 0 ){
+		return;
+	}
+	
+	const std::ios_base::fmtflags flags( stream.flags() );
+	const std::streamsize precision( stream.precision() );
+	stream << std::fixed << std::setprecision( 1 );
+	
+	stream << ", mean " << toMicroSeconds( ( uint64_t )( sum / ( double )total ) ) << "us";
+	
+	// percentiles report the highest value of the bucket containing the percentile
+	uint64_t accumulated = 0;
+	int percentile = 0;
+	int highest = 0;
+	
+	for( i=0; i<BucketCount; i++ ){
+		if( counts[ i ] == 0 ){
+			continue;
+		}
+		
+		accumulated += counts[ i ];
+		highest = i;
+		
+		while( percentile < vPercentileCount
+		&& ( double )accumulated >= ( double )total * vPercentiles[ percentile ] / 100.0 ){
+			stream << ", p" << std::setprecision( percentile < 3 ? 0 : 1 ) << vPercentiles[ percentile ]
+				<< " " << std::setprecision( 1 ) << toMicroSeconds( BucketHighest( i ) ) << "us";
+			percentile++;
+		}
+	}
+	
+	stream << ", max " << toMicroSeconds( BucketHighest( highest ) ) << "us";
+	
+	stream.flags( flags );
+	stream.precision( precision );
+}
+
+void olotHistogram::Reset(){
+	int i;
+	for( i=0; i<BucketCount; i++ ){
+		pCounts[ i ].store( 0, std::memory_order_relaxed );
+	}
+}
+
+uint64_t olotHistogram::BucketLowest( int index ){
+	if( index < SubBucketCount ){
+		return ( uint64_t )index;
+	}
+	
+	const int shift = index / SubBucketCount - 1;
+	return ( uint64_t )( SubBucketCount + index % SubBucketCount ) << shift;
+}
+
+uint64_t olotHistogram::BucketHighest( int index ){
+	if( index < SubBucketCount ){
+		return ( uint64_t )index;
+	}
+	
+	const int shift = index / SubBucketCount - 1;
+	return BucketLowest( index ) + ( ( uint64_t )1 << shift ) - 1;
+}
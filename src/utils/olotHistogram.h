@@ -0,0 +1,123 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _OLOTHISTOGRAM_H_
+#define _OLOTHISTOGRAM_H_
+
+#include <atomic>
+#include <string>
+#include <ostream>
+#include <stdint.h>
+
+
+/**
+ * Lock-free histogram of nanosecond durations.
+ * 
+ * Buckets are log-linear like HDR histograms. Values below SubBucketCount have their own
+ * bucket. Larger values are grouped by power of two with each group split into
+ * SubBucketCount linear sub buckets. This keeps the relative error below 1/SubBucketCount
+ * over the entire range. Values of MaxValueBits bits and more are counted in the last bucket.
+ * 
+ * Recording is a single relaxed atomic increment and safe from any number of threads.
+ * Dumping copies the counts and never blocks recording threads. Counts recorded while
+ * dumping end up in either the dumped or the next interval.
+ */
+class olotHistogram{
+public:
+	/** Number of bits used for sub buckets. */
+	const static int SubBucketBits = 4;
+	
+	/** Number of linear sub buckets per power of two. */
+	const static int SubBucketCount = 1 << SubBucketBits;
+	
+	/** Number of value bits covered. 40 bits are about 18 minutes. */
+	const static int MaxValueBits = 40;
+	
+	/** Number of buckets. */
+	const static int BucketCount = ( MaxValueBits - SubBucketBits + 1 ) * SubBucketCount;
+	
+	
+	
+private:
+	const std::string pName;
+	std::atomic<uint64_t> pCounts[ BucketCount ];
+	
+	
+	
+public:
+	/** \name Constructors and Destructors */
+	/*@{*/
+	/** Create histogram. */
+	olotHistogram( const char *name );
+	/*@}*/
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/** Name. */
+	inline const std::string &GetName() const{ return pName; }
+	
+	/** Record value in nanoseconds. Negative values are recorded as 0. */
+	inline void Record( int64_t value, uint64_t count = 1 ){
+		pCounts[ BucketIndex( value > 0 ? ( uint64_t )value : 0 ) ].fetch_add(
+			count, std::memory_order_relaxed );
+	}
+	
+	/**
+	 * Write one line summary to stream.
+	 * 
+	 * Writes name, count, mean, percentiles and maximum. If reset is true counts are
+	 * cleared while copying them.
+	 */
+	void Dump( std::ostream &stream, bool reset );
+	
+	/** Clear counts. */
+	void Reset();
+	
+	/** Bucket index of value. */
+	static inline int BucketIndex( uint64_t value ){
+		if( value < SubBucketCount ){
+			return ( int )value;
+		}
+		
+		const int msb = 63 - __builtin_clzll( value );
+		if( msb >= MaxValueBits ){
+			return BucketCount - 1;
+		}
+		
+		const int shift = msb - SubBucketBits;
+		return ( shift + 1 ) * SubBucketCount + ( int )( ( value >> shift ) & ( SubBucketCount - 1 ) );
+	}
+	
+	/** Lowest value counted in bucket. */
+	static uint64_t BucketLowest( int index );
+	
+	/** Highest value counted in bucket. */
+	static uint64_t BucketHighest( int index );
+	/*@}*/
+};
+
+#endif
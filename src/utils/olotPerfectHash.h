@@ -0,0 +1,151 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _OLOTPERFECTHASH_H_
+#define _OLOTPERFECTHASH_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+
+/** Perfect hash policy comparing names exactly. */
+struct olotPerfectHashExact{
+	/** Byte hashed for character. */
+	static constexpr uint8_t Fold( char c ){ return ( uint8_t )c; }
+};
+
+/** Perfect hash policy ignoring the case of ASCII letters. */
+struct olotPerfectHashCaseless{
+	/** Byte hashed for character. */
+	static constexpr uint8_t Fold( char c ){
+		return ( uint8_t )( c >= 'A' && c <= 'Z' ? c - 'A' + 'a' : c );
+	}
+};
+
+
+/**
+ * Compile time perfect hash over a fixed set of names.
+ * 
+ * Searches for a seed mapping each name to its own slot of a table with TableSize slots.
+ * Find returns the index of the only name that can match. The caller has to compare the
+ * name to confirm the match using the same policy. Construct as constexpr and check
+ * IsValid using static_assert. Policy defines how characters are folded before hashing.
+ */
+template<int Count, int TableSize, class Policy = olotPerfectHashExact> class olotPerfectHash{
+public:
+	/** Maximum number of seeds tried before giving up. */
+	const static uint64_t MaxSeeds = 100000;
+	
+	static_assert( ( TableSize & ( TableSize - 1 ) ) == 0, "table size has to be a power of two" );
+	static_assert( TableSize >= Count, "table size smaller than name count" );
+	
+	
+	
+private:
+	uint64_t pSeed;
+	int pSlots[ TableSize ];
+	
+	
+	
+public:
+	/** \name Constructors and Destructors */
+	/*@{*/
+	/** Create perfect hash for names. */
+	constexpr olotPerfectHash( const char * const ( &names )[ Count ] ) : pSeed( MaxSeeds ), pSlots{}{
+		uint64_t seed = 0;
+		int i = 0;
+		
+		for( seed=0; seed<MaxSeeds; seed++ ){
+			for( i=0; i<TableSize; i++ ){
+				pSlots[ i ] = -1;
+			}
+			
+			for( i=0; i<Count; i++ ){
+				const int slot = Slot( Hash( names[ i ], seed ) );
+				if( pSlots[ slot ] != -1 ){
+					break;
+				}
+				pSlots[ slot ] = i;
+			}
+			
+			if( i == Count ){
+				pSeed = seed;
+				break;
+			}
+		}
+	}
+	/*@}*/
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/** A seed has been found. */
+	constexpr bool IsValid() const{ return pSeed != MaxSeeds; }
+	
+	/** Index of the name that can match or -1. */
+	constexpr int Find( const char *name ) const{
+		return pSlots[ SlotOf( name ) ];
+	}
+	
+	/** Index of the name with length that can match or -1. Name has not to be null terminated. */
+	constexpr int Find( const char *name, size_t length ) const{
+		return pSlots[ Slot( Hash( name, length, pSeed ) ) ];
+	}
+	
+	/** Table slot of name. Names not in the set share slots with names in the set. */
+	constexpr int SlotOf( const char *name ) const{
+		return Slot( Hash( name, pSeed ) );
+	}
+	
+	/** FNV-1a hash of name. */
+	static constexpr uint64_t Hash( const char *name, uint64_t seed = 0 ){
+		uint64_t hash = 14695981039346656037ULL ^ seed;
+		for( ; *name; name++ ){
+			hash ^= Policy::Fold( *name );
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+	
+	/** FNV-1a hash of name with length. */
+	static constexpr uint64_t Hash( const char *name, size_t length, uint64_t seed ){
+		uint64_t hash = 14695981039346656037ULL ^ seed;
+		size_t i = 0;
+		for( i=0; i<length; i++ ){
+			hash ^= Policy::Fold( name[ i ] );
+			hash *= 1099511628211ULL;
+		}
+		return hash;
+	}
+	
+	/** Table slot of hash. */
+	static constexpr int Slot( uint64_t hash ){
+		return ( int )( ( hash ^ ( hash >> 32 ) ) & ( TableSize - 1 ) );
+	}
+	/*@}*/
+};
+
+#endif
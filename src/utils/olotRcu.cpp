@@ -0,0 +1,142 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#include <thread>
+#include <mutex>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/membarrier.h>
+
+#include "olotRcu.h"
+
+
+// Definitions
+////////////////
+
+// epoch 0 marks readers outside read sections
+std::atomic<uint64_t> olotRcu::pEpoch( 1 );
+std::atomic<bool> olotRcu::pMembarrier( false );
+
+static std::atomic<olotRcu::sReader*> vReaders( nullptr );
+static std::mutex vMutexReaders;
+static bool vMembarrierChecked = false;
+
+
+static inline int membarrier( int command ){
+	return ( int )syscall( __NR_membarrier, command, 0 );
+}
+
+// enable expedited private membarrier if supported. has to be called with vMutexReaders held
+static void checkMembarrier( std::atomic<bool> &enabled ){
+	if( vMembarrierChecked ){
+		return;
+	}
+	vMembarrierChecked = true;
+	
+	const int commands = membarrier( MEMBARRIER_CMD_QUERY );
+	if( commands != -1 && ( commands & MEMBARRIER_CMD_PRIVATE_EXPEDITED ) != 0
+	&& membarrier( MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED ) == 0 ){
+		enabled.store( true, std::memory_order_seq_cst );
+	}
+}
+
+
+// registers the announcement of a thread the first time it reads. announcements of exited
+// threads are reused. announcements are never deleted since writers can iterate them at
+// any time
+class cThreadReader{
+public:
+	olotRcu::sReader *reader;
+	
+	cThreadReader( std::atomic<bool> &membarrierEnabled ) : reader( nullptr ){
+		const std::lock_guard<std::mutex> guard( vMutexReaders );
+		checkMembarrier( membarrierEnabled );
+		
+		olotRcu::sReader *next;
+		for( next = vReaders.load( std::memory_order_acquire ); next; next = next->next ){
+			if( ! next->used.load( std::memory_order_relaxed ) ){
+				reader = next;
+				break;
+			}
+		}
+		
+		if( ! reader ){
+			reader = new olotRcu::sReader;
+			reader->epoch.store( 0, std::memory_order_relaxed );
+			reader->next = vReaders.load( std::memory_order_relaxed );
+			vReaders.store( reader, std::memory_order_release );
+		}
+		
+		reader->nesting = 0;
+		reader->used.store( true, std::memory_order_relaxed );
+	}
+	
+	~cThreadReader(){
+		const std::lock_guard<std::mutex> guard( vMutexReaders );
+		reader->epoch.store( 0, std::memory_order_release );
+		reader->used.store( false, std::memory_order_relaxed );
+	}
+};
+
+
+
+// class olotRcu
+//////////////////
+
+// Management
+///////////////
+
+void olotRcu::Synchronize(){
+	// pairs with the fence readers issue between announcing the epoch and reading
+	if( pMembarrier.load( std::memory_order_relaxed ) ){
+		membarrier( MEMBARRIER_CMD_PRIVATE_EXPEDITED );
+		
+	}else{
+		std::atomic_thread_fence( std::memory_order_seq_cst );
+	}
+	
+	const uint64_t epoch = pEpoch.fetch_add( 1, std::memory_order_seq_cst ) + 1;
+	
+	sReader *reader;
+	for( reader = vReaders.load( std::memory_order_acquire ); reader; reader = reader->next ){
+		while( true ){
+			const uint64_t readerEpoch = reader->epoch.load( std::memory_order_acquire );
+			if( readerEpoch == 0 || readerEpoch >= epoch ){
+				break;
+			}
+			std::this_thread::yield();
+		}
+	}
+}
+
+
+
+// Private Functions
+//////////////////////
+
+olotRcu::sReader &olotRcu::pThreadReader(){
+	thread_local cThreadReader threadReader( pMembarrier );
+	return *threadReader.reader;
+}
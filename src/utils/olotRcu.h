@@ -0,0 +1,122 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+#ifndef _OLOTRCU_H_
+#define _OLOTRCU_H_
+
+#include <atomic>
+#include <stdint.h>
+
+
+/**
+ * Read-copy-update synchronization.
+ * 
+ * Readers enter a read section before loading a published pointer and leave it once they
+ * no longer use the pointed to data. Entering and leaving is wait-free. Writers publish a
+ * new pointer and call Synchronize before deleting the old data. Synchronize waits until
+ * every reader that could still see the old pointer has left its read section.
+ * 
+ * Each thread announces the epoch it entered a read section in. Announcements are
+ * registered once per thread and reused after the thread exits. If the kernel supports
+ * expedited private membarrier the memory barrier required between announcing and
+ * reading is issued by writers on behalf of all readers. Otherwise readers issue a full
+ * memory fence.
+ * 
+ * \code{.cpp}
+ * {
+ *    const olotRcu::ReadGuard guard;
+ *    const Data *data = published.load( std::memory_order_acquire );
+ *    // read data
+ * }
+ * \endcode
+ */
+class olotRcu{
+public:
+	/** Reader announcement. For internal use only. */
+	struct sReader{
+		std::atomic<uint64_t> epoch;
+		std::atomic<bool> used;
+		sReader *next;
+		int nesting;
+	};
+	
+	/** Read section guard. */
+	class ReadGuard{
+	public:
+		inline ReadGuard(){ olotRcu::ReadLock(); }
+		inline ~ReadGuard(){ olotRcu::ReadUnlock(); }
+		ReadGuard( const ReadGuard & ) = delete;
+		ReadGuard &operator=( const ReadGuard & ) = delete;
+	};
+	
+	
+	
+private:
+	static std::atomic<uint64_t> pEpoch;
+	static std::atomic<bool> pMembarrier;
+	
+	
+	
+public:
+	/** \name Management */
+	/*@{*/
+	/** Enter read section. Read sections can be nested. */
+	static inline void ReadLock(){
+		sReader &reader = pThreadReader();
+		if( reader.nesting++ == 0 ){
+			reader.epoch.store( pEpoch.load( std::memory_order_relaxed ), std::memory_order_relaxed );
+			if( pMembarrier.load( std::memory_order_relaxed ) ){
+				std::atomic_signal_fence( std::memory_order_seq_cst );
+				
+			}else{
+				std::atomic_thread_fence( std::memory_order_seq_cst );
+			}
+		}
+	}
+	
+	/** Leave read section. */
+	static inline void ReadUnlock(){
+		sReader &reader = pThreadReader();
+		if( --reader.nesting == 0 ){
+			reader.epoch.store( 0, std::memory_order_release );
+		}
+	}
+	
+	/**
+	 * Wait for all readers that entered a read section before the call to leave it.
+	 * 
+	 * Has to be called after publishing a new pointer and before deleting the old data.
+	 * Must not be called inside a read section.
+	 */
+	static void Synchronize();
+	/*@}*/
+	
+	
+	
+private:
+	static sReader &pThreadReader();
+};
+
+#endif
@@ -0,0 +1,161 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#ifndef _OLOTSEQLOCK_H_
+#define _OLOTSEQLOCK_H_
+
+#include <atomic>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+
+/**
+ * Sequence lock.
+ * 
+ * Protects data stored in std::atomic variables accessed with relaxed memory order.
+ * Writing is wait-free for a single writer. Multiple writers have to be serialized by the
+ * caller. Reading is lock-free for any number of readers. Readers retry if the data has
+ * been modified while reading it. Readers never block the writer.
+ * 
+ * \code{.cpp}
+ * uint32_t sequence;
+ * do{
+ *    sequence = seqlock.BeginRead();
+ *    // read data
+ * }while( seqlock.RetryRead( sequence ) );
+ * \endcode
+ */
+class olotSeqLock{
+private:
+	alignas( 64 ) std::atomic<uint32_t> pSequence;
+	
+	
+	
+public:
+	/** \name Constructors and Destructors */
+	/*@{*/
+	/** Create sequence lock. */
+	olotSeqLock() : pSequence( 0 ){
+	}
+	/*@}*/
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/** Begin writing data. */
+	inline void BeginWrite(){
+		pSequence.store( pSequence.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+		std::atomic_thread_fence( std::memory_order_release );
+	}
+	
+	/** End writing data. Readers see all written data from now on. */
+	inline void EndWrite(){
+		pSequence.store( pSequence.load( std::memory_order_relaxed ) + 1, std::memory_order_release );
+	}
+	
+	/** Begin reading data waiting for a running write to finish. */
+	inline uint32_t BeginRead() const{
+		uint32_t sequence = pSequence.load( std::memory_order_acquire );
+		while( sequence & 1 ){
+			sequence = pSequence.load( std::memory_order_acquire );
+		}
+		return sequence;
+	}
+	
+	/** End reading data. Returns true if data has been modified and has to be read again. */
+	inline bool RetryRead( uint32_t sequence ) const{
+		std::atomic_thread_fence( std::memory_order_acquire );
+		return pSequence.load( std::memory_order_relaxed ) != sequence;
+	}
+	/*@}*/
+};
+
+
+/**
+ * Value protected by a sequence lock.
+ * 
+ * Stores a trivially copyable value as atomic words. Same rules as olotSeqLock apply.
+ */
+template<typename T>
+class olotSeqLockValue{
+private:
+	static_assert( std::is_trivially_copyable<T>::value, "value has to be trivially copyable" );
+	
+	const static int WordCount = ( int )( ( sizeof( T ) + 3 ) / 4 );
+	
+	olotSeqLock pLock;
+	std::atomic<uint32_t> pWords[ WordCount ];
+	
+	
+	
+public:
+	/** \name Constructors and Destructors */
+	/*@{*/
+	/** Create value with all bytes 0. */
+	olotSeqLockValue(){
+		int i;
+		for( i=0; i<WordCount; i++ ){
+			pWords[ i ].store( 0, std::memory_order_relaxed );
+		}
+	}
+	/*@}*/
+	
+	
+	
+	/** \name Management */
+	/*@{*/
+	/** Store value. */
+	void Store( const T &value ){
+		uint32_t words[ WordCount ] = {};
+		memcpy( words, &value, sizeof( T ) );
+		
+		pLock.BeginWrite();
+		int i;
+		for( i=0; i<WordCount; i++ ){
+			pWords[ i ].store( words[ i ], std::memory_order_relaxed );
+		}
+		pLock.EndWrite();
+	}
+	
+	/** Load consistent copy of value. */
+	void Load( T &value ) const{
+		uint32_t words[ WordCount ];
+		uint32_t sequence;
+		int i;
+		
+		do{
+			sequence = pLock.BeginRead();
+			for( i=0; i<WordCount; i++ ){
+				words[ i ] = pWords[ i ].load( std::memory_order_relaxed );
+			}
+		}while( pLock.RetryRead( sequence ) );
+		
+		memcpy( &value, words, sizeof( T ) );
+	}
+	/*@}*/
+};
+
+#endif
@@ -0,0 +1,333 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/*
+ * Equivalence test for olotExpressionMapping.
+ * 
+ * Evaluates the built-in eye and lip mappings using the fixed functions and the compiled
+ * machine code and a synthetic mapping using all operation types including remaps the
+ * machine code simplifies. Inputs cover the range limits, remap boundaries, signed zero,
+ * values outside the valid range, NaN and pseudo-random values. All evaluations have to
+ * produce bit identical results to the reference evaluation.
+ * 
+ * The built-in mappings are additionally compared against golden values calculated
+ * using the hand-written linearStep and vec2Length code the mappings replaced. This code
+ * is independent of the operation tables. Returns 0 on success and 1 on failure.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+#include <algorithm>
+
+#include "olotExpressionMapping.h"
+#include "olotExpressionProfile.h"
+#include "olotOcsClient.h"
+#include "openxr/openxr.h"
+
+
+static const float vValues[] = { 0.0f, 1.0f, 0.5f, 0.75f, 0.25f, 1e-7f, 0.999999f, 1.0f / 3.0f,
+	-0.0f, -0.5f, 1.5f, NAN };
+static const int vValueCount = ( int )( sizeof( vValues ) / sizeof( vValues[ 0 ] ) );
+static const int vRandomTestCount = 10000;
+
+// hand-written mapping code the built-in mappings replaced. kept verbatim as golden values
+static inline float clamp( float value ){
+	return std::max( std::min( value, 1.0f ), 0.0f );
+}
+
+static inline float linearStep( float value, float from, float to ){
+	return clamp( ( value - from ) / ( to - from ) );
+}
+
+static inline float linearStep( float value, float from, float to, float mapFrom, float mapTo ){
+	return linearStep( value, from, to ) * ( mapTo - mapFrom ) + mapFrom;
+}
+
+static inline float vec2Length( float x, float y ){
+	return sqrtf( x * x + y * y );
+}
+
+static const float invSqrt2 = 1.0f / sqrtf( 2.0f );
+
+static void goldenEye( const float *values, float *weights ){
+	const float openessRight = values[ olotOcsClient::eeRightEyeLidExpandedSqueeze ];
+	const float openessLeft = values[ olotOcsClient::eeLeftEyeLidExpandedSqueeze ];
+	
+	weights[ XR_EYE_EXPRESSION_RIGHT_BLINK_HTC ] = linearStep( openessRight, 0.0f, 0.75f, 0.0f, 1.0f );
+	weights[ XR_EYE_EXPRESSION_LEFT_BLINK_HTC ] = linearStep( openessLeft, 0.0f, 0.75f, 0.0f, 1.0f );
+	
+	weights[ XR_EYE_EXPRESSION_RIGHT_WIDE_HTC ] = linearStep( openessRight, 0.75f, 1.0f, 0.0f, 1.0f );
+	weights[ XR_EYE_EXPRESSION_LEFT_WIDE_HTC ] = linearStep( openessLeft, 0.75f, 1.0f, 0.0f, 1.0f );
+	
+	weights[ XR_EYE_EXPRESSION_RIGHT_SQUEEZE_HTC ] = 0.0f;
+	weights[ XR_EYE_EXPRESSION_LEFT_SQUEEZE_HTC ] = 0.0f;
+}
+
+static void goldenLip( const float *values, float *weights ){
+	weights[ XR_LIP_EXPRESSION_JAW_RIGHT_HTC ] = values[ olotOcsClient::eeJawRight ];
+	weights[ XR_LIP_EXPRESSION_JAW_LEFT_HTC ] = values[ olotOcsClient::eeJawLeft ];
+	weights[ XR_LIP_EXPRESSION_JAW_FORWARD_HTC ] = values[ olotOcsClient::eeJawForward ];
+	weights[ XR_LIP_EXPRESSION_JAW_OPEN_HTC ] = values[ olotOcsClient::eeJawOpen ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_POUT_HTC ] = values[ olotOcsClient::eeMouthPucker ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_SMILE_RIGHT_HTC ] = values[ olotOcsClient::eeMouthSmileRight ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_SMILE_LEFT_HTC ] = values[ olotOcsClient::eeMouthSmileLeft ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_SAD_RIGHT_HTC ] = values[ olotOcsClient::eeMouthFrownRight ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_SAD_LEFT_HTC ] = values[ olotOcsClient::eeMouthFrownLeft ];
+	weights[ XR_LIP_EXPRESSION_CHEEK_PUFF_RIGHT_HTC ] = values[ olotOcsClient::eeCheekPuffRight ];
+	weights[ XR_LIP_EXPRESSION_CHEEK_PUFF_LEFT_HTC ] = values[ olotOcsClient::eeCheekPuffLeft ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_UPPER_UPRIGHT_HTC ] = values[ olotOcsClient::eeMouthUpperUpRight ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_UPPER_UPLEFT_HTC ] = values[ olotOcsClient::eeMouthUpperUpLeft ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_LOWER_DOWNRIGHT_HTC ] = values[ olotOcsClient::eeMouthLowerDownRight ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_LOWER_DOWNLEFT_HTC ] = values[ olotOcsClient::eeMouthLowerDownLeft ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_UPPER_INSIDE_HTC ] = values[ olotOcsClient::eeMouthRollUpper ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_LOWER_INSIDE_HTC ] = values[ olotOcsClient::eeMouthRollLower ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_LOWER_OVERLAY_HTC ] = values[ olotOcsClient::eeMouthShrugLower ];
+	weights[ XR_LIP_EXPRESSION_TONGUE_LEFT_HTC ] = values[ olotOcsClient::eeTongueLeft ];
+	weights[ XR_LIP_EXPRESSION_TONGUE_RIGHT_HTC ] = values[ olotOcsClient::eeTongueRight ];
+	weights[ XR_LIP_EXPRESSION_TONGUE_UP_HTC ] = values[ olotOcsClient::eeTongueUp ];
+	weights[ XR_LIP_EXPRESSION_TONGUE_DOWN_HTC ] = values[ olotOcsClient::eeTongueDown ];
+	weights[ XR_LIP_EXPRESSION_TONGUE_ROLL_HTC ] = values[ olotOcsClient::eeTongueRoll ];
+	
+	weights[ XR_LIP_EXPRESSION_MOUTH_APE_SHAPE_HTC ] = values[ olotOcsClient::eeMouthClose ];
+	
+	weights[ XR_LIP_EXPRESSION_MOUTH_UPPER_RIGHT_HTC ] = values[ olotOcsClient::eeMouthRight ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_UPPER_LEFT_HTC ] = values[ olotOcsClient::eeMouthLeft ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_LOWER_RIGHT_HTC ] = values[ olotOcsClient::eeMouthRight ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_LOWER_LEFT_HTC ] = values[ olotOcsClient::eeMouthLeft ];
+	
+	weights[ XR_LIP_EXPRESSION_MOUTH_UPPER_OVERTURN_HTC ] = values[ olotOcsClient::eeMouthFunnel ];
+	weights[ XR_LIP_EXPRESSION_MOUTH_LOWER_OVERTURN_HTC ] = values[ olotOcsClient::eeMouthFunnel ];
+	
+	weights[ XR_LIP_EXPRESSION_CHEEK_SUCK_HTC ] = std::max(
+		values[ olotOcsClient::eeCheekSuckRight ], values[ olotOcsClient::eeCheekSuckLeft ] );
+	
+	const float tongueOut = values[ olotOcsClient::eeTongueOut ];
+	const float tongueUp = values[ olotOcsClient::eeTongueUp ];
+	const float tongueDown = values[ olotOcsClient::eeTongueDown ];
+	const float tongueRight = values[ olotOcsClient::eeTongueRight ];
+	const float tongueLeft = values[ olotOcsClient::eeTongueLeft ];
+	
+	weights[ XR_LIP_EXPRESSION_TONGUE_LONGSTEP1_HTC ] = linearStep( tongueOut, 0.0f, 0.5f, 0.0f, 1.0f );
+	weights[ XR_LIP_EXPRESSION_TONGUE_LONGSTEP2_HTC ] = linearStep( tongueOut, 0.5f, 1.0f, 0.0f, 1.0f );
+	
+	weights[ XR_LIP_EXPRESSION_TONGUE_UPRIGHT_MORPH_HTC ] = vec2Length( tongueUp, tongueRight ) * invSqrt2 * tongueOut;
+	weights[ XR_LIP_EXPRESSION_TONGUE_UPLEFT_MORPH_HTC ] = vec2Length( tongueUp, tongueLeft ) * invSqrt2 * tongueOut;
+	weights[ XR_LIP_EXPRESSION_TONGUE_DOWNRIGHT_MORPH_HTC ] = vec2Length( tongueDown, tongueRight ) * invSqrt2 * tongueOut;
+	weights[ XR_LIP_EXPRESSION_TONGUE_DOWNLEFT_MORPH_HTC ] = vec2Length( tongueDown, tongueLeft ) * invSqrt2 * tongueOut;
+}
+
+typedef void (*GoldenFunction)( const float *values, float *weights );
+
+// fills inputs for test index. uniform value tests followed by pseudo-random tests
+// mixing all values
+static void fillInputs( int test, uint32_t &random, std::vector<float> &inputs ){
+	const int count = ( int )inputs.size();
+	int i;
+	
+	for( i=0; i<count; i++ ){
+		if( test < vValueCount ){
+			inputs[ i ] = vValues[ test ];
+			
+		}else{
+			random = random * 1664525 + 1013904223;
+			inputs[ i ] = ( random >> 8 ) % 4 == 0
+				? vValues[ ( random >> 16 ) % vValueCount ]
+				: ( float )( random >> 8 ) / ( float )( 1 << 24 );
+		}
+	}
+}
+
+// compares evaluation and reference evaluation against the golden values. outputs start
+// zeroed like expression frames do. the old code wrote constant zero to outputs the
+// mappings do not write
+static bool testGolden( const char *name, const olotExpressionMapping &mapping, GoldenFunction golden ){
+	const int outputCount = mapping.GetOutputCount();
+	std::vector<float> inputs( mapping.GetInputCount() );
+	std::vector<float> outputs( outputCount );
+	std::vector<float> referenceOutputs( outputCount );
+	std::vector<float> goldenOutputs( outputCount );
+	uint32_t random = 7;
+	int i, j;
+	
+	for( i=0; i<vValueCount+vRandomTestCount; i++ ){
+		fillInputs( i, random, inputs );
+		
+		for( j=0; j<outputCount; j++ ){
+			outputs[ j ] = referenceOutputs[ j ] = goldenOutputs[ j ] = 0.0f;
+		}
+		
+		mapping.Evaluate( inputs.data(), outputs.data() );
+		mapping.EvaluateReference( inputs.data(), referenceOutputs.data() );
+		golden( inputs.data(), goldenOutputs.data() );
+		
+		for( j=0; j<outputCount; j++ ){
+			if( memcmp( &outputs[ j ], &goldenOutputs[ j ], sizeof( float ) ) ){
+				printf( "FAIL %s: test %d output %d: %.9g != golden %.9g\n", name, i, j,
+					outputs[ j ], goldenOutputs[ j ] );
+				return false;
+			}
+			if( memcmp( &referenceOutputs[ j ], &goldenOutputs[ j ], sizeof( float ) ) ){
+				printf( "FAIL %s: test %d output %d: reference %.9g != golden %.9g\n", name, i, j,
+					referenceOutputs[ j ], goldenOutputs[ j ] );
+				return false;
+			}
+		}
+	}
+	
+	printf( "PASS %s\n", name );
+	return true;
+}
+
+static bool testMapping( const char *name, const olotExpressionMapping &mapping ){
+	const int outputCount = mapping.GetOutputCount();
+	std::vector<float> inputs( mapping.GetInputCount() );
+	std::vector<float> outputs( outputCount );
+	std::vector<float> referenceOutputs( outputCount );
+	uint32_t random = 1;
+	int i, j;
+	
+	for( i=0; i<vValueCount+vRandomTestCount; i++ ){
+		fillInputs( i, random, inputs );
+		
+		// outputs not written by any operation have to stay unchanged
+		for( j=0; j<outputCount; j++ ){
+			outputs[ j ] = referenceOutputs[ j ] = -2.0f - ( float )j;
+		}
+		
+		mapping.Evaluate( inputs.data(), outputs.data() );
+		mapping.EvaluateReference( inputs.data(), referenceOutputs.data() );
+		
+		for( j=0; j<outputCount; j++ ){
+			if( memcmp( &outputs[ j ], &referenceOutputs[ j ], sizeof( float ) ) ){
+				printf( "FAIL %s: test %d output %d: %.9g != %.9g\n", name, i, j,
+					outputs[ j ], referenceOutputs[ j ] );
+				return false;
+			}
+		}
+	}
+	
+	printf( "PASS %s\n", name );
+	return true;
+}
+
+// remap parameters (from, to, mapFrom, mapTo) covering ranges the machine code divides by,
+// multiplies by the reciprocal or skips, signed zero and inverted ranges
+static const float vRemapParameters[][ 4 ] = {
+	{ 0.0f, 0.75f, 0.0f, 1.0f },
+	{ 0.75f, 1.0f, 0.0f, 1.0f },
+	{ 0.0f, 0.5f, 0.0f, 1.0f },
+	{ -0.0f, 0.5f, -0.0f, 0.5f },
+	{ 0.5f, -1.5f, 1.0f, 0.0f },
+	{ 0.0f, 1.0f, -0.0f, 1.0f },
+	{ -0.25f, 1.0f, 0.2f, 0.9f },
+	{ 0.25f, -0.5f, 1.0f, 0.0f },
+	{ 0.0f, 0x1p-126f, 0.0f, 1.0f },
+	{ 0.0f, 0x1p127f, 0.0f, 2.0f }
+};
+static const int vRemapParameterCount = ( int )( sizeof( vRemapParameters ) / sizeof( vRemapParameters[ 0 ] ) );
+
+static olotExpressionMapping::Ref createSyntheticMapping(){
+	// the last output is not written by any operation
+	const int inputCount = 8;
+	const int operationsPerType = 7;
+	std::vector<olotExpressionMapping::sOperation> operations;
+	int i, j;
+	
+	for( i=0; i<olotExpressionMapping::OperationCount; i++ ){
+		const olotExpressionMapping::eOperation type = ( olotExpressionMapping::eOperation )i;
+		const int count = type == olotExpressionMapping::eoRemap ? vRemapParameterCount : operationsPerType;
+		
+		for( j=0; j<count; j++ ){
+			olotExpressionMapping::sOperation operation = {};
+			operation.operation = type;
+			operation.output = ( int )operations.size();
+			operation.inputs[ 0 ] = j % inputCount;
+			operation.inputs[ 1 ] = ( j * 3 + 1 ) % inputCount;
+			operation.inputs[ 2 ] = ( j * 5 + 2 ) % inputCount;
+			
+			if( type == olotExpressionMapping::eoRemap ){
+				memcpy( operation.parameters, vRemapParameters[ j ], sizeof( operation.parameters ) );
+				
+			}else if( type == olotExpressionMapping::eoBlend ){
+				operation.parameters[ 0 ] = 1.0f / sqrtf( 2.0f ) + 0.1f * ( float )j;
+			}
+			
+			operations.push_back( operation );
+		}
+	}
+	
+	return olotExpressionMapping::Ref( new olotExpressionMapping( operations.data(),
+		( int )operations.size(), inputCount, ( int )operations.size() + 1 ) );
+}
+
+static bool testFixedMapping( const char *name, const olotExpressionMapping &mapping ){
+	if( ! mapping.GetFixedFunction() ){
+		printf( "FAIL %s: no fixed function\n", name );
+		return false;
+	}
+	return testMapping( name, mapping );
+}
+
+static bool testCompiledMapping( const char *name, const olotExpressionMapping &mapping ){
+#if defined __x86_64__ && defined __linux__
+	if( ! mapping.GetCompiled() ){
+		printf( "FAIL %s: not compiled\n", name );
+		return false;
+	}
+#endif
+	return testMapping( name, mapping );
+}
+
+static olotExpressionMapping::Ref createTableMapping(
+const olotExpressionProfile::ListOperations &operations, int outputCount ){
+	return olotExpressionMapping::Ref( new olotExpressionMapping( operations.data(),
+		( int )operations.size(), olotOcsClient::ExpressionCount, outputCount ) );
+}
+
+int main(){
+	const olotExpressionProfile profile;
+	bool success = true;
+	
+	success &= testFixedMapping( "built-in eye mapping fixed", *profile.CompileEyeMapping() );
+	success &= testFixedMapping( "built-in lip mapping fixed", *profile.CompileLipMapping() );
+	success &= testCompiledMapping( "built-in eye mapping compiled", *createTableMapping(
+		profile.GetEyeOperations(), XR_FACIAL_EXPRESSION_EYE_COUNT_HTC ) );
+	success &= testCompiledMapping( "built-in lip mapping compiled", *createTableMapping(
+		profile.GetLipOperations(), XR_FACIAL_EXPRESSION_LIP_COUNT_HTC ) );
+	success &= testCompiledMapping( "synthetic mapping compiled", *createSyntheticMapping() );
+	
+	success &= testGolden( "built-in eye mapping fixed golden", *profile.CompileEyeMapping(), goldenEye );
+	success &= testGolden( "built-in lip mapping fixed golden", *profile.CompileLipMapping(), goldenLip );
+	success &= testGolden( "built-in eye mapping compiled golden", *createTableMapping(
+		profile.GetEyeOperations(), XR_FACIAL_EXPRESSION_EYE_COUNT_HTC ), goldenEye );
+	success &= testGolden( "built-in lip mapping compiled golden", *createTableMapping(
+		profile.GetLipOperations(), XR_FACIAL_EXPRESSION_LIP_COUNT_HTC ), goldenLip );
+	
+	return success ? 0 : 1;
+}
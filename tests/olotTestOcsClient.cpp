@@ -0,0 +1,132 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/*
+ * Test of values received by olotOcsClient.
+ * 
+ * Feeds shared memory frames containing non-finite values through the client with the
+ * filter enabled. Non-finite values have to be rejected before they reach the filter and
+ * the sample history. Published values and history samples have to stay finite and
+ * follow the finite inputs. Has to run with OCSEYEFACETRACKING_FILTER=1 and
+ * OCSEYEFACETRACKING_SHM_NAME set to an unused name so no sockets are opened. Returns 0
+ * on success and 1 on failure.
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "olotApiLayer.h"
+#include "olotOcsClient.h"
+#include "olot_shm.h"
+
+
+static const int64_t vFrameInterval = 10000000;
+
+static bool testChannel( olotOcsClient &client, const char *name, int channel ){
+	const float inputs[] = { 0.5f, NAN, 0.5f, 0.6f, INFINITY, 0.7f, -INFINITY, -NAN, 0.7f };
+	const int inputCount = ( int )( sizeof( inputs ) / sizeof( inputs[ 0 ] ) );
+	const int64_t startTime = ( int64_t )channel * 1000000000 + 1000000000;
+	olotOcsClient::sSnapshot snapshot = {};
+	int64_t lastFiniteTime = 0;
+	float lastValue = 0.0f;
+	int i;
+	
+	for( i=0; i<inputCount; i++ ){
+		const int64_t time = startTime + vFrameInterval * i;
+		olot_shm_frame frame;
+		memset( &frame, 0, sizeof( frame ) );
+		
+		if( channel < olotOcsClient::ExpressionCount ){
+			frame.expression_mask = ( uint64_t )1 << channel;
+			frame.expressions[ channel ] = inputs[ i ];
+			
+		}else{
+			frame.eye_state_mask = ( uint32_t )1 << ( channel - olotOcsClient::ExpressionCount );
+			frame.eye_states[ channel - olotOcsClient::ExpressionCount ] = inputs[ i ];
+		}
+		
+		client.ProcessData( &frame, &time, 1 );
+		client.GetSnapshot( snapshot );
+		
+		const float value = channel < olotOcsClient::ExpressionCount
+			? snapshot.expressions[ channel ]
+			: snapshot.eyeStates[ channel - olotOcsClient::ExpressionCount ];
+		
+		if( ! isfinite( value ) ){
+			printf( "FAIL %s: input %d (%g) published %g\n", name, i, inputs[ i ], value );
+			return false;
+		}
+		
+		if( isfinite( inputs[ i ] ) ){
+			lastFiniteTime = time;
+			
+		}else if( value != lastValue ){
+			printf( "FAIL %s: input %d (%g) changed published value from %g to %g\n",
+				name, i, inputs[ i ], lastValue, value );
+			return false;
+		}
+		lastValue = value;
+		
+		if( client.GetHistory().GetLastSampleTime( channel ) != lastFiniteTime ){
+			printf( "FAIL %s: input %d (%g) added history sample\n", name, i, inputs[ i ] );
+			return false;
+		}
+		
+		float historyValue;
+		if( ! client.GetHistory().GetValueAt( channel, lastFiniteTime, historyValue )
+		|| ! isfinite( historyValue ) ){
+			printf( "FAIL %s: input %d (%g) history value not finite\n", name, i, inputs[ i ] );
+			return false;
+		}
+	}
+	
+	// the filter lags behind but has to move towards the last finite input
+	if( ! ( lastValue > 0.5f && lastValue <= 0.7f ) ){
+		printf( "FAIL %s: final value %g not between 0.5 and 0.7\n", name, lastValue );
+		return false;
+	}
+	
+	printf( "PASS %s\n", name );
+	return true;
+}
+
+int main(){
+	if( ! olotApiLayer::Get().GetConfig().GetFilter() ){
+		printf( "FAIL test requires OCSEYEFACETRACKING_FILTER=1\n" );
+		return 1;
+	}
+	
+	olotOcsClient client;
+	bool success = true;
+	
+	success &= testChannel( client, "expression jawOpen",
+		olotOcsClient::ExpressionChannel( olotOcsClient::eeJawOpen ) );
+	success &= testChannel( client, "eye state leftEyeX",
+		olotOcsClient::EyeStateChannel( olotOcsClient::eesLeftEyeX ) );
+	
+	return success ? 0 : 1;
+}
@@ -0,0 +1,517 @@
+/**
+ * MIT License
+ * 
+ * Copyright (c) 2024 DragonDreams (info@dragondreams.ch)
+ * 
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ * 
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ * 
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+
+
+/*
+ * Test of OSC packet parsing by olotOcsMessage and olotOcsBundle.
+ * 
+ * Messages cover all type tags, truncated and unpadded strings and blobs, truncated
+ * fixed size arguments and unknown type tags. Bundles cover nested bundles up to and
+ * beyond the depth limit, misaligned and truncated element lengths, rollback of packets
+ * failing to parse part way and timetag ordering per source including clock resets.
+ * Returns 0 on success and 1 on failure.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <vector>
+
+#include "olotOcsMessage.h"
+#include "olotOcsBundle.h"
+
+
+// writes OSC packets. all values are big endian and strings are padded to 4 bytes
+class cPacket{
+public:
+	std::vector<uint8_t> data;
+	
+	cPacket &String( const char *string ){
+		return Bytes( string, strlen( string ) + 1 ).Pad();
+	}
+	
+	cPacket &Int32( uint32_t value ){
+		const uint8_t bytes[] = { ( uint8_t )( value >> 24 ), ( uint8_t )( value >> 16 ),
+			( uint8_t )( value >> 8 ), ( uint8_t )value };
+		return Bytes( bytes, 4 );
+	}
+	
+	cPacket &Int64( uint64_t value ){
+		return Int32( ( uint32_t )( value >> 32 ) ).Int32( ( uint32_t )value );
+	}
+	
+	cPacket &Float( float value ){
+		uint32_t bits;
+		memcpy( &bits, &value, 4 );
+		return Int32( bits );
+	}
+	
+	cPacket &Double( double value ){
+		uint64_t bits;
+		memcpy( &bits, &value, 8 );
+		return Int64( bits );
+	}
+	
+	cPacket &Bytes( const void *bytes, size_t count ){
+		data.insert( data.end(), ( const uint8_t* )bytes, ( const uint8_t* )bytes + count );
+		return *this;
+	}
+	
+	cPacket &Pad(){
+		data.resize( ( data.size() + 3 ) & ~( size_t )3, 0 );
+		return *this;
+	}
+	
+	cPacket &BundleHeader( uint64_t timetag ){
+		return String( "#bundle" ).Int64( timetag );
+	}
+	
+	cPacket &Element( const cPacket &element ){
+		return Int32( ( uint32_t )element.data.size() ).Bytes( element.data.data(), element.data.size() );
+	}
+};
+
+static cPacket floatMessage( const char *target, float value ){
+	cPacket packet;
+	packet.String( target ).String( ",f" ).Float( value );
+	return packet;
+}
+
+static bool vSuccess = true;
+
+static void check( bool condition, const char *name, const char *description ){
+	if( ! condition ){
+		printf( "FAIL %s: %s\n", name, description );
+		vSuccess = false;
+	}
+}
+
+static bool parseMessage( olotOcsMessage &message, const cPacket &packet ){
+	return message.Parse( packet.data.data(), packet.data.size() );
+}
+
+// truncated packets are copied so reading past the end is caught by memory checkers
+static bool parseMessage( olotOcsMessage &message, const cPacket &packet, size_t length ){
+	const std::vector<uint8_t> data( packet.data.cbegin(), packet.data.cbegin() + length );
+	return message.Parse( data.data(), data.size() );
+}
+
+static bool parseBundle( olotOcsBundle &bundle, const cPacket &packet, uint64_t source ){
+	return bundle.Parse( packet.data.data(), packet.data.size(), 1000, source );
+}
+
+
+// messages
+/////////////
+
+static void testMessageTypes(){
+	const char * const name = "message types";
+	const uint8_t blob[] = { 1, 2, 3 };
+	cPacket packet;
+	packet.String( "/a/b" ).String( ",fisbhdtcrmTFNI[]S" )
+		.Float( 0.25f ).Int32( ( uint32_t )-3 ).String( "hello" )
+		.Int32( 3 ).Bytes( blob, 3 ).Pad()
+		.Int64( ( uint64_t )-5 ).Double( 0.75 ).Int64( 7 )
+		.Int32( 'x' ).Int32( 0x11223344 ).Int32( 0x90407f00 )
+		.String( "sym" );
+	
+	olotOcsMessage message;
+	const bool parsed = parseMessage( message, packet );
+	check( parsed, name, "valid message rejected" );
+	if( ! parsed ){
+		return;
+	}
+	
+	check( message.GetTarget() == "/a/b", name, "wrong target" );
+	check( message.GetParameterCount() == 17, name, "wrong parameter count" );
+	check( message.GetParameterTypeAt( 3 ) == olotOcsMessage::etBlob, name, "wrong blob type" );
+	check( message.GetParameterTypeAt( 16 ) == olotOcsMessage::etString, name, "symbol not a string" );
+	check( message.GetParameterFloatAt( 0 ) == 0.25f, name, "wrong float" );
+	check( message.GetParameterIntAt( 1 ) == -3, name, "wrong integer" );
+	check( message.GetParameterStringAt( 2 ) == "hello", name, "wrong string" );
+	check( message.GetParameterStringAt( 16 ) == "sym", name, "wrong string after all other types" );
+	
+	float value;
+	check( message.GetParameterAsFloatAt( 4, value ) && value == -5.0f, name, "wrong 64-bit integer" );
+	check( message.GetParameterAsFloatAt( 5, value ) && value == 0.75f, name, "wrong double" );
+	check( message.GetParameterAsFloatAt( 10, value ) && value == 1.0f, name, "wrong true" );
+	check( message.GetParameterAsFloatAt( 11, value ) && value == 0.0f, name, "wrong false" );
+	check( ! message.GetParameterAsFloatAt( 2, value ), name, "string converted to float" );
+	check( ! message.GetParameterAsFloatAt( 12, value ), name, "nil converted to float" );
+	
+	if( vSuccess ){
+		printf( "PASS %s\n", name );
+	}
+}
+
+static void testMessageTruncated(){
+	const char * const name = "message truncated";
+	olotOcsMessage message;
+	cPacket packet;
+	
+	// every proper prefix. empty packets never reach the parser of a message ending with a string is malformed
+	packet.String( "/a" ).String( ",s" ).String( "hello" );
+	size_t length;
+	for( length=1; length<packet.data.size(); length++ ){
+		if( parseMessage( message, packet, length ) ){
+			printf( "FAIL %s: string message truncated to %d bytes accepted\n", name, ( int )length );
+			vSuccess = false;
+		}
+	}
+	
+	// blob data and blob size truncated
+	const uint8_t blob[] = { 1, 2, 3, 4, 5 };
+	packet = cPacket();
+	packet.String( "/a" ).String( ",b" ).Int32( 5 ).Bytes( blob, 5 ).Pad();
+	for( length=1; length<packet.data.size(); length++ ){
+		if( parseMessage( message, packet, length ) ){
+			printf( "FAIL %s: blob message truncated to %d bytes accepted\n", name, ( int )length );
+			vSuccess = false;
+		}
+	}
+	
+	// blob size exceeding the packet including sizes wrapping around when padded
+	packet = cPacket();
+	packet.String( "/a" ).String( ",b" ).Int32( 1000 ).Bytes( blob, 4 );
+	check( ! parseMessage( message, packet ), name, "blob larger than packet accepted" );
+	
+	packet = cPacket();
+	packet.String( "/a" ).String( ",b" ).Int32( 0xffffffff ).Bytes( blob, 4 );
+	check( ! parseMessage( message, packet ), name, "blob with maximum size accepted" );
+	
+	// fixed size arguments
+	packet = cPacket();
+	packet.String( "/a" ).String( ",fh" ).Float( 1.0f ).Int32( 0 );
+	check( ! parseMessage( message, packet ), name, "truncated 64-bit integer accepted" );
+	
+	// missing type tags
+	packet = cPacket();
+	packet.String( "/a" );
+	check( ! parseMessage( message, packet ), name, "message without type tags accepted" );
+	
+	packet = cPacket();
+	packet.String( "/a" ).String( "f" ).Float( 1.0f );
+	check( ! parseMessage( message, packet ), name, "type tags without comma accepted" );
+	
+	if( vSuccess ){
+		printf( "PASS %s\n", name );
+	}
+}
+
+static void testMessageMisaligned(){
+	const char * const name = "message misaligned";
+	olotOcsMessage message;
+	cPacket packet;
+	
+	// padding missing after target, type tags, string and blob
+	packet.Bytes( "/ab", 4 ).String( ",f" ).Float( 1.0f );
+	check( parseMessage( message, packet ), name, "padded target rejected" );
+	
+	packet = cPacket();
+	packet.Bytes( "/abcd", 6 ).Bytes( ",f", 3 ).Float( 1.0f );
+	check( ! parseMessage( message, packet ), name, "unpadded target accepted" );
+	
+	packet = cPacket();
+	packet.String( "/a" ).Bytes( ",ff", 4 ).Float( 1.0f ).Float( 2.0f );
+	check( parseMessage( message, packet ) && message.GetParameterFloatAt( 1 ) == 2.0f,
+		name, "padded type tags rejected" );
+	
+	packet = cPacket();
+	packet.String( "/a" ).Bytes( ",fff", 5 ).Float( 1.0f ).Float( 2.0f ).Float( 3.0f );
+	check( ! parseMessage( message, packet ), name, "unpadded type tags accepted" );
+	
+	packet = cPacket();
+	packet.String( "/a" ).String( ",s" ).Bytes( "abcdef", 7 );
+	check( ! parseMessage( message, packet ), name, "unpadded string accepted" );
+	
+	const uint8_t blob[] = { 1, 2, 3, 4, 5 };
+	packet = cPacket();
+	packet.String( "/a" ).String( ",b" ).Int32( 5 ).Bytes( blob, 5 );
+	check( ! parseMessage( message, packet ), name, "unpadded blob accepted" );
+	
+	// arguments after an unpadded blob are read from the padded position
+	packet = cPacket();
+	packet.String( "/a" ).String( ",bf" ).Int32( 5 ).Bytes( blob, 5 ).Pad().Float( 0.5f );
+	check( parseMessage( message, packet ) && message.GetParameterFloatAt( 1 ) == 0.5f,
+		name, "float after padded blob wrong" );
+	
+	if( vSuccess ){
+		printf( "PASS %s\n", name );
+	}
+}
+
+static void testMessageUnknownTag(){
+	const char * const name = "message unknown tag";
+	olotOcsMessage message;
+	cPacket packet;
+	
+	// the message is truncated to the parameters before the unknown tag
+	packet.String( "/a" ).String( ",fiXf" ).Float( 0.5f ).Int32( 2 ).Int32( 0 ).Float( 1.0f );
+	check( parseMessage( message, packet ), name, "message with unknown tag rejected" );
+	check( message.GetParameterCount() == 2, name, "parameters after unknown tag kept" );
+	check( message.GetParameterFloatAt( 0 ) == 0.5f && message.GetParameterIntAt( 1 ) == 2,
+		name, "parameters before unknown tag wrong" );
+	
+	packet = cPacket();
+	packet.String( "/a" ).String( ",X" ).Int32( 0 );
+	check( parseMessage( message, packet ) && message.GetParameterCount() == 0,
+		name, "unknown first tag not truncated" );
+	
+	// arguments before the unknown tag still have to fit
+	packet = cPacket();
+	packet.String( "/a" ).String( ",fX" );
+	check( ! parseMessage( message, packet ), name, "missing argument before unknown tag accepted" );
+	
+	if( vSuccess ){
+		printf( "PASS %s\n", name );
+	}
+}
+
+
+// bundles
+////////////
+
+static cPacket nestedBundle( int levels, uint64_t timetag ){
+	cPacket packet;
+	packet.BundleHeader( timetag ).Element( floatMessage( "/leaf", 1.0f ) );
+	
+	int i;
+	for( i=1; i<levels; i++ ){
+		cPacket outer;
+		outer.BundleHeader( timetag ).Element( packet );
+		packet = outer;
+	}
+	return packet;
+}
+
+static void testBundleNested(){
+	const char * const name = "bundle nested";
+	olotOcsBundle bundle;
+	
+	// messages of nested bundles are flattened in packet order
+	cPacket inner;
+	inner.BundleHeader( 5 ).Element( floatMessage( "/b", 2.0f ) ).Element( floatMessage( "/c", 3.0f ) );
+	
+	cPacket packet;
+	packet.BundleHeader( 5 ).Element( floatMessage( "/a", 1.0f ) ).Element( inner )
+		.Element( floatMessage( "/d", 4.0f ) );
+	
+	check( parseBundle( bundle, packet, 1 ), name, "nested bundle rejected" );
+	check( bundle.GetMessageCount() == 4, name, "wrong message count" );
+	if( bundle.GetMessageCount() == 4 ){
+		check( bundle.GetMessageAt( 0 ).GetTarget() == "/a" && bundle.GetMessageAt( 1 ).GetTarget() == "/b"
+			&& bundle.GetMessageAt( 2 ).GetTarget() == "/c" && bundle.GetMessageAt( 3 ).GetTarget() == "/d",
+			name, "wrong message order" );
+		check( bundle.GetMessageAt( 2 ).GetReceiveTime() == 1000, name, "receive time not assigned" );
+	}
+	
+	// bundles nest up to the depth limit
+	bundle.Clear();
+	check( parseBundle( bundle, nestedBundle( olotOcsBundle::MaxDepth, 5 ), 2 ),
+		name, "bundle nested up to the depth limit rejected" );
+	check( bundle.GetMessageCount() == 1, name, "message of deepest bundle missing" );
+	
+	bundle.Clear();
+	check( ! parseBundle( bundle, nestedBundle( olotOcsBundle::MaxDepth + 1, 5 ), 3 ),
+		name, "bundle nested beyond the depth limit accepted" );
+	check( bundle.GetMessageCount() == 0, name, "messages of too deep bundle appended" );
+	
+	// empty bundles are valid
+	packet = cPacket();
+	packet.BundleHeader( 5 );
+	check( parseBundle( bundle, packet, 4 ) && bundle.GetMessageCount() == 0, name, "empty bundle rejected" );
+	
+	// more messages than initially allocated
+	packet = cPacket();
+	packet.BundleHeader( 5 );
+	int i;
+	for( i=0; i<200; i++ ){
+		packet.Element( floatMessage( "/m", ( float )i ) );
+	}
+	check( parseBundle( bundle, packet, 5 ) && bundle.GetMessageCount() == 200, name, "large bundle rejected" );
+	check( bundle.GetMessageCount() == 200 && bundle.GetMessageAt( 199 ).GetParameterFloatAt( 0 ) == 199.0f,
+		name, "wrong value of last message in large bundle" );
+	
+	if( vSuccess ){
+		printf( "PASS %s\n", name );
+	}
+}
+
+static void testBundleMalformed(){
+	const char * const name = "bundle malformed";
+	olotOcsBundle bundle;
+	const cPacket message( floatMessage( "/a", 1.0f ) );
+	cPacket packet;
+	
+	// element lengths have to be multiples of 4 and fit into the bundle
+	packet.BundleHeader( 5 ).Int32( ( uint32_t )message.data.size() + 2 )
+		.Bytes( message.data.data(), message.data.size() ).Int32( 0 ).Pad();
+	check( ! parseBundle( bundle, packet, 1 ), name, "misaligned element length accepted" );
+	
+	packet = cPacket();
+	packet.BundleHeader( 5 ).Int32( ( uint32_t )message.data.size() + 4 )
+		.Bytes( message.data.data(), message.data.size() );
+	check( ! parseBundle( bundle, packet, 1 ), name, "element length exceeding bundle accepted" );
+	
+	// truncated element length and trailing bytes
+	packet = cPacket();
+	packet.BundleHeader( 5 ).Element( message ).Bytes( "\0\0", 2 );
+	check( ! parseBundle( bundle, packet, 1 ), name, "truncated element length accepted" );
+	
+	// zero length elements are neither messages nor bundles
+	packet = cPacket();
+	packet.BundleHeader( 5 ).Int32( 0 );
+	check( ! parseBundle( bundle, packet, 1 ), name, "empty element accepted" );
+	
+	// header
+	packet = cPacket();
+	packet.String( "#bundl" ).Int64( 5 ).Element( message );
+	check( ! parseBundle( bundle, packet, 1 ), name, "wrong bundle tag accepted" );
+	
+	packet = cPacket();
+	packet.String( "#bundle" ).Int32( 0 );
+	check( ! parseBundle( bundle, packet, 1 ), name, "truncated timetag accepted" );
+	
+	packet = cPacket();
+	packet.String( "abc" ).String( ",f" ).Float( 1.0f );
+	check( ! parseBundle( bundle, packet, 1 ), name, "packet without address accepted" );
+	
+	check( bundle.GetMessageCount() == 0, name, "messages of malformed packets appended" );
+	
+	if( vSuccess ){
+		printf( "PASS %s\n", name );
+	}
+}
+
+static void testBundleRollback(){
+	const char * const name = "bundle rollback";
+	olotOcsBundle bundle;
+	
+	// messages reference the packet data which has to stay alive
+	const cPacket first( floatMessage( "/first", 1.0f ) );
+	check( parseBundle( bundle, first, 1 ), name, "single message rejected" );
+	
+	// the malformed message follows valid messages and a valid nested bundle
+	cPacket inner;
+	inner.BundleHeader( 100 ).Element( floatMessage( "/b", 2.0f ) );
+	
+	cPacket broken;
+	broken.String( "/broken" ).String( ",f" );
+	
+	cPacket packet;
+	packet.BundleHeader( 100 ).Element( floatMessage( "/a", 1.0f ) ).Element( inner ).Element( broken );
+	
+	check( ! parseBundle( bundle, packet, 1 ), name, "bundle with malformed message accepted" );
+	check( bundle.GetMessageCount() == 1, name, "messages of partially parsed bundle kept" );
+	check( bundle.GetMessageCount() >= 1 && bundle.GetMessageAt( 0 ).GetTarget() == "/first",
+		name, "message of previous packet lost" );
+	check( bundle.GetLatestTimetag( 1 ) == 0, name, "timetag of rejected bundle stored" );
+	
+	// the rolled back slots are reused by the next packet
+	const cPacket second( floatMessage( "/second", 2.0f ) );
+	check( parseBundle( bundle, second, 1 ), name, "message after rollback rejected" );
+	check( bundle.GetMessageCount() == 2 && bundle.GetMessageAt( 1 ).GetTarget() == "/second",
+		name, "wrong message after rollback" );
+	
+	if( vSuccess ){
+		printf( "PASS %s\n", name );
+	}
+}
+
+static cPacket timedBundle( uint64_t timetag ){
+	cPacket packet;
+	packet.BundleHeader( timetag ).Element( floatMessage( "/a", 1.0f ) );
+	return packet;
+}
+
+static void testBundleTimetags(){
+	const char * const name = "bundle timetags";
+	const uint64_t time = ( uint64_t )1000 << 32;
+	olotOcsBundle bundle;
+	
+	check( parseBundle( bundle, timedBundle( time ), 1 ), name, "first bundle rejected" );
+	check( bundle.GetLatestTimetag( 1 ) == time, name, "latest timetag not stored" );
+	
+	// same and later timetags are accepted. earlier ones are dropped
+	check( parseBundle( bundle, timedBundle( time ), 1 ), name, "same timetag rejected" );
+	check( ! parseBundle( bundle, timedBundle( time - 1 ), 1 ), name, "earlier timetag accepted" );
+	check( bundle.TakeDroppedCount() == 1, name, "dropped bundle not counted" );
+	check( bundle.TakeDroppedCount() == 0, name, "dropped count not reset" );
+	check( parseBundle( bundle, timedBundle( time + 10 ), 1 ), name, "later timetag rejected" );
+	check( bundle.GetMessageCount() == 3, name, "wrong message count after dropped bundle" );
+	
+	// each source has its own clock
+	check( parseBundle( bundle, timedBundle( time - 5 ), 2 ), name, "earlier timetag of other source rejected" );
+	check( bundle.GetLatestTimetag( 1 ) == time + 10 && bundle.GetLatestTimetag( 2 ) == time - 5,
+		name, "timetags of sources mixed up" );
+	
+	// immediate bundles are never dropped and do not change the latest timetag
+	check( parseBundle( bundle, timedBundle( olotOcsBundle::TimetagImmediately ), 1 ),
+		name, "immediate bundle rejected" );
+	check( bundle.GetLatestTimetag( 1 ) == time + 10, name, "immediate bundle changed latest timetag" );
+	
+	// only the top level timetag is checked
+	cPacket packet;
+	packet.BundleHeader( time + 20 ).Element( timedBundle( 5 ) );
+	check( parseBundle( bundle, packet, 1 ), name, "nested bundle with earlier timetag rejected" );
+	check( bundle.GetLatestTimetag( 1 ) == time + 20, name, "nested timetag stored" );
+	
+	// a large jump back is a clock reset
+	const uint64_t reset = time + 20 - olotOcsBundle::TimetagResetJump;
+	check( parseBundle( bundle, timedBundle( reset ), 1 ), name, "clock reset rejected" );
+	check( bundle.GetLatestTimetag( 1 ) == reset, name, "clock reset not stored" );
+	check( ! parseBundle( bundle, timedBundle( reset - 1 ), 1 ), name, "earlier timetag after reset accepted" );
+	check( bundle.TakeDroppedCount() == 1, name, "dropped bundle after reset not counted" );
+	
+	// more sources than tracked replace the oldest ones
+	uint64_t source;
+	for( source=10; source<10+olotOcsBundle::MaxSources; source++ ){
+		check( parseBundle( bundle, timedBundle( time ), source ), name, "bundle of new source rejected" );
+	}
+	check( bundle.GetLatestTimetag( 1 ) == 0, name, "replaced source still tracked" );
+	check( bundle.GetLatestTimetag( 10 + olotOcsBundle::MaxSources - 1 ) == time,
+		name, "newest source not tracked" );
+	
+	if( vSuccess ){
+		printf( "PASS %s\n", name );
+	}
+}
+
+int main(){
+	bool success = true;
+	
+	// each test reports its own result
+	void ( * const tests[] )() = { testMessageTypes, testMessageTruncated, testMessageMisaligned,
+		testMessageUnknownTag, testBundleNested, testBundleMalformed, testBundleRollback,
+		testBundleTimetags };
+	
+	for( void ( * const test )() : tests ){
+		vSuccess = true;
+		test();
+		success &= vSuccess;
+	}
+	
+	return success ? 0 : 1;
+}